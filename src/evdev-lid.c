@@ -74,9 +74,6 @@ lid_switch_keyboard_event(uint64_t time,
 	if (!dispatch->lid_is_closed)
 		return;
 
-	if (event->type != LIBINPUT_EVENT_KEYBOARD_KEY)
-		return;
-
 	if (dispatch->reliability == RELIABILITY_WRITE_OPEN) {
 		int fd = libevdev_get_fd(dispatch->device->evdev);
 		struct input_event ev[2] = {
@@ -108,6 +105,10 @@ lid_switch_toggle_keyboard_listener(struct lid_switch_dispatch *dispatch,
 		libinput_device_add_event_listener(
 					&dispatch->keyboard.keyboard->base,
 					&dispatch->keyboard.listener,
+					(const enum libinput_event_type[]) {
+						LIBINPUT_EVENT_KEYBOARD_KEY,
+						LIBINPUT_EVENT_NONE,
+					},
 					lid_switch_keyboard_event,
 					dispatch);
 	} else {
@@ -155,6 +156,7 @@ lid_switch_process(struct evdev_dispatch *evdev_dispatch,
 		lid_switch_process_switch(dispatch, device, event, time);
 		break;
 	case EV_SYN:
+		LIBINPUT_PROBE3(frame, device, DISPATCH_LID_SWITCH, time);
 		break;
 	default:
 		assert(0 && "Unknown event type");
@@ -292,6 +294,7 @@ struct evdev_dispatch_interface lid_switch_interface = {
 	lid_switch_interface_device_added,   /* device_resumed, treat as add */
 	lid_switch_sync_initial_state,
 	NULL, /* toggle_touch */
+	NULL, /* config_changed */
 };
 
 struct evdev_dispatch *
@@ -667,6 +667,7 @@ evdev_middlebutton_set(struct libinput_device *device,
 	}
 
 	evdev_middlebutton_apply_config(evdev);
+	evdev_dispatch_config_changed(evdev);
 
 	return LIBINPUT_CONFIG_STATUS_SUCCESS;
 }
@@ -700,6 +701,13 @@ evdev_init_middlebutton(struct evdev_device *device,
 			    evdev_libinput_context(device),
 			    evdev_middlebutton_handle_timeout,
 			    device);
+
+	/* Nothing to emulate if the caller doesn't want button events */
+	if (!libinput_wants_event_type(evdev_libinput_context(device),
+				       LIBINPUT_EVENT_POINTER_BUTTON)) {
+		enable = false;
+		want_config = false;
+	}
 	device->middlebutton.enabled_default = enable;
 	device->middlebutton.want_enabled = enable;
 	device->middlebutton.enabled = enable;
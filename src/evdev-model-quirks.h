@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EVDEV_MODEL_QUIRKS_H
+#define EVDEV_MODEL_QUIRKS_H
+
+#include <fnmatch.h>
+#include <stdint.h>
+
+#include "evdev.h"
+
+/* The LIBINPUT_MODEL_* entries of 90-libinput-model-quirks.hwdb are
+ * compiled into evdev-model-quirks-table.h by parse_hwdb.py --generate-c.
+ * Matches on bus/vid/pid end up in a perfect hash, everything else is
+ * a glob matched against the same strings the udev rules look up.
+ */
+struct model_quirk_id {
+	uint64_t key;
+	uint32_t model_flags;
+};
+
+struct model_quirk_glob {
+	const char *match;
+	uint32_t model_flags;
+};
+
+#include "evdev-model-quirks-table.h"
+
+/* Must match ID_TYPES in parse_hwdb.py */
+enum model_quirk_type {
+	MODEL_QUIRK_TOUCHPAD = 1,
+	MODEL_QUIRK_MOUSE = 2,
+	MODEL_QUIRK_KEYBOARD = 3,
+};
+
+/* Key layout, must match parse_hwdb.py: type << 49, any-product << 48,
+ * then bus, vid and pid in 16 bits each */
+#define MODEL_QUIRK_ANY_PRODUCT (1ULL << 48)
+#define MODEL_QUIRK_HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+static inline uint64_t
+model_quirk_id_key(enum model_quirk_type type,
+		   uint16_t bus,
+		   uint16_t vid,
+		   uint16_t pid)
+{
+	return (uint64_t)type << 49 |
+	       (uint64_t)bus << 32 |
+	       (uint64_t)vid << 16 |
+	       pid;
+}
+
+static inline uint32_t
+model_quirk_id_lookup(uint64_t key)
+{
+	const struct model_quirk_id *q;
+	uint64_t slot;
+
+	slot = ((key ^ MODEL_QUIRK_ID_SEED) * MODEL_QUIRK_HASH_MULTIPLIER) >>
+		(64 - MODEL_QUIRK_ID_BITS);
+	q = &model_quirk_ids[slot];
+
+	return q->key == key ? q->model_flags : 0;
+}
+
+static inline uint32_t
+model_quirk_glob_lookup(const char *match)
+{
+	const struct model_quirk_glob *g;
+	uint32_t model_flags = 0;
+
+	for (g = model_quirk_globs; g->match; g++) {
+		if (fnmatch(g->match, match, 0) == 0)
+			model_flags |= g->model_flags;
+	}
+
+	return model_flags;
+}
+
+#endif
@@ -619,13 +619,37 @@ tp_gesture_handle_state(struct tp_dispatch *tp, uint64_t time)
 	}
 }
 
+static bool
+tp_gesture_events_wanted(struct tp_dispatch *tp)
+{
+	struct libinput *libinput = tp_libinput_context(tp);
+	enum libinput_event_type types[] = {
+		LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN,
+		LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE,
+		LIBINPUT_EVENT_GESTURE_SWIPE_END,
+		LIBINPUT_EVENT_GESTURE_PINCH_BEGIN,
+		LIBINPUT_EVENT_GESTURE_PINCH_UPDATE,
+		LIBINPUT_EVENT_GESTURE_PINCH_END,
+	};
+	size_t i;
+
+	for (i = 0; i < ARRAY_LENGTH(types); i++) {
+		if (libinput_wants_event_type(libinput, types[i]))
+			return true;
+	}
+
+	return false;
+}
+
 void
 tp_init_gesture(struct tp_dispatch *tp)
 {
 	/* two-finger scrolling is always enabled, this flag just
 	 * decides whether we detect pinch. semi-mt devices are too
-	 * unreliable to do pinch gestures. */
-	tp->gesture.enabled = !tp->semi_mt && tp->num_slots > 1;
+	 * unreliable to do pinch gestures. If the caller doesn't
+	 * want gesture events we don't bother detecting them. */
+	tp->gesture.enabled = !tp->semi_mt && tp->num_slots > 1 &&
+			      tp_gesture_events_wanted(tp);
 
 	tp->gesture.state = GESTURE_STATE_NONE;
 
@@ -1119,6 +1119,15 @@ tp_init_tap(struct tp_dispatch *tp)
 	libinput_timer_init(&tp->tap.timer,
 			    tp_libinput_context(tp),
 			    tp_tap_handle_timeout, tp);
+
+	/* Tapping only generates button events. If the caller doesn't
+	 * want those, the tap state machine never runs and tapping
+	 * is unavailable */
+	if (!libinput_wants_event_type(tp_libinput_context(tp),
+				       LIBINPUT_EVENT_POINTER_BUTTON)) {
+		tp->tap.enabled = false;
+		tp->device->base.config.tap = NULL;
+	}
 }
 
 void
@@ -1302,6 +1302,7 @@ tp_interface_process(struct evdev_dispatch *dispatch,
 		tp_process_key(tp, e, time);
 		break;
 	case EV_SYN:
+		LIBINPUT_PROBE3(frame, device, DISPATCH_TOUCHPAD, time);
 		tp_handle_state(tp, time);
 #if 0
 		tp_debug_touch_state(tp, device);
@@ -1441,11 +1442,6 @@ tp_trackpoint_event(uint64_t time, struct libinput_event *event, void *data)
 {
 	struct tp_dispatch *tp = data;
 
-	/* Buttons do not count as trackpad activity, as people may use
-	   the trackpoint buttons in combination with the touchpad. */
-	if (event->type == LIBINPUT_EVENT_POINTER_BUTTON)
-		return;
-
 	tp->palm.trackpoint_last_event_time = time;
 	tp->palm.trackpoint_event_count++;
 
@@ -1529,9 +1525,6 @@ tp_keyboard_event(uint64_t time, struct libinput_event *event, void *data)
 	unsigned int key;
 	bool is_modifier;
 
-	if (event->type != LIBINPUT_EVENT_KEYBOARD_KEY)
-		return;
-
 	kbdev = libinput_event_get_keyboard_event(event);
 	key = libinput_event_keyboard_get_key(kbdev);
 
@@ -1618,6 +1611,10 @@ tp_dwt_pair_keyboard(struct evdev_device *touchpad,
 
 	libinput_device_add_event_listener(&keyboard->base,
 					   &tp->dwt.keyboard_listener,
+					   (const enum libinput_event_type[]) {
+						LIBINPUT_EVENT_KEYBOARD_KEY,
+						LIBINPUT_EVENT_NONE,
+					   },
 					   tp_keyboard_event, tp);
 	tp->dwt.keyboard = keyboard;
 	tp->dwt.keyboard_active = false;
@@ -1648,9 +1645,17 @@ tp_pair_trackpoint(struct evdev_device *touchpad,
 		/* Don't send any pending releases to the new trackpoint */
 		tp->buttons.active_is_topbutton = false;
 		tp->buttons.trackpoint = trackpoint;
+		/* Buttons do not count as trackpoint activity, as
+		 * people may use the trackpoint buttons in combination
+		 * with the touchpad. */
 		if (tp->palm.monitor_trackpoint)
 			libinput_device_add_event_listener(&trackpoint->base,
 						&tp->palm.trackpoint_listener,
+						(const enum libinput_event_type[]) {
+							LIBINPUT_EVENT_POINTER_MOTION,
+							LIBINPUT_EVENT_POINTER_AXIS,
+							LIBINPUT_EVENT_NONE,
+						},
 						tp_trackpoint_event, tp);
 	}
 }
@@ -1661,9 +1666,6 @@ tp_lid_switch_event(uint64_t time, struct libinput_event *event, void *data)
 	struct tp_dispatch *tp = data;
 	struct libinput_event_switch *swev;
 
-	if (libinput_event_get_type(event) != LIBINPUT_EVENT_SWITCH_TOGGLE)
-		return;
-
 	swev = libinput_event_get_switch_event(event);
 	switch (libinput_event_switch_get_switch_state(swev)) {
 	case LIBINPUT_SWITCH_STATE_OFF:
@@ -1694,6 +1696,10 @@ tp_pair_lid_switch(struct evdev_device *touchpad,
 
 		libinput_device_add_event_listener(&lid_switch->base,
 					&tp->lid_switch.lid_switch_listener,
+					(const enum libinput_event_type[]) {
+						LIBINPUT_EVENT_SWITCH_TOGGLE,
+						LIBINPUT_EVENT_NONE,
+					},
 					tp_lid_switch_event, tp);
 		tp->lid_switch.lid_switch = lid_switch;
 	}
@@ -1868,6 +1874,7 @@ static struct evdev_dispatch_interface tp_interface = {
 	tp_interface_device_added,   /* device_resumed, treat as add */
 	NULL,                        /* post_added */
 	tp_interface_toggle_touch,
+	NULL,                        /* config_changed */
 };
 
 static void
@@ -2164,16 +2171,25 @@ tp_init_scroll(struct tp_dispatch *tp, struct evdev_device *device)
 
 	evdev_init_natural_scroll(device);
 
+	 /* In mm for touchpads with valid resolution, see tp_init_accel() */
+	tp->device->scroll.threshold = 0.0;
+	tp->device->scroll.direction_lock_threshold = 5.0;
+
+	/* Edge and two-finger scrolling only generate axis events. If the
+	 * caller doesn't want those, both are disabled and there is no
+	 * scroll method to configure */
+	if (!libinput_wants_event_type(tp_libinput_context(tp),
+				       LIBINPUT_EVENT_POINTER_AXIS)) {
+		tp->scroll.method = LIBINPUT_CONFIG_SCROLL_NO_SCROLL;
+		return;
+	}
+
 	tp->scroll.config_method.get_methods = tp_scroll_config_scroll_method_get_methods;
 	tp->scroll.config_method.set_method = tp_scroll_config_scroll_method_set_method;
 	tp->scroll.config_method.get_method = tp_scroll_config_scroll_method_get_method;
 	tp->scroll.config_method.get_default_method = tp_scroll_config_scroll_method_get_default_method;
 	tp->scroll.method = tp_scroll_get_default_method(tp);
 	tp->device->base.config.scroll_method = &tp->scroll.config_method;
-
-	 /* In mm for touchpads with valid resolution, see tp_init_accel() */
-	tp->device->scroll.threshold = 0.0;
-	tp->device->scroll.direction_lock_threshold = 5.0;
 }
 
 static int
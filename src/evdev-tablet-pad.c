@@ -463,6 +463,7 @@ pad_process(struct evdev_dispatch *dispatch,
 		pad_process_key(pad, device, e, time);
 		break;
 	case EV_SYN:
+		LIBINPUT_PROBE3(frame, device, DISPATCH_TABLET_PAD, time);
 		pad_flush(pad, device, time);
 		break;
 	case EV_MSC:
@@ -514,6 +515,7 @@ static struct evdev_dispatch_interface pad_interface = {
 	NULL, /* device_resumed */
 	NULL, /* post_added */
 	NULL, /* toggle_touch */
+	NULL, /* config_changed */
 };
 
 static void
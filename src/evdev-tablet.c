@@ -95,7 +95,8 @@ tablet_history_push(struct tablet_dispatch *tablet,
 	unsigned int index = (tablet->history.index + 1) %
 				tablet_history_size(tablet);
 
-	tablet->history.samples[index] = *axes;
+	tablet->history.samples[index].point = axes->point;
+	tablet->history.samples[index].tilt = axes->tilt;
 	tablet->history.index = index;
 	tablet->history.count = min(tablet->history.count + 1,
 				    tablet_history_size(tablet));
@@ -108,7 +109,7 @@ tablet_history_push(struct tablet_dispatch *tablet,
  * Return a previous axis state, where index of 0 means "most recent", 1 is
  * "one before most recent", etc.
  */
-static inline const struct tablet_axes*
+static inline const struct tablet_history_sample*
 tablet_history_get(const struct tablet_dispatch *tablet, unsigned int index)
 {
 	size_t sz = tablet_history_size(tablet);
@@ -595,10 +596,11 @@ tablet_smoothen_axes(const struct tablet_dispatch *tablet,
 {
 	size_t i;
 	size_t count = tablet_history_size(tablet);
-	struct tablet_axes smooth = { 0 };
+	struct tablet_history_sample smooth = { 0 };
 
 	for (i = 0; i < count; i++) {
-		const struct tablet_axes *a = tablet_history_get(tablet, i);
+		const struct tablet_history_sample *a =
+			tablet_history_get(tablet, i);
 
 		smooth.point.x += a->point.x;
 		smooth.point.y += a->point.y;
@@ -652,11 +654,18 @@ tablet_check_notify_axes(struct tablet_dispatch *tablet,
 	rc = true;
 
 out:
-	tablet_history_push(tablet, &tablet->axes);
-	tablet_smoothen_axes(tablet, &axes);
-
-	/* The delta relies on the last *smooth* point, so we do it last */
-	axes.delta = tablet_tool_process_delta(tablet, tool, device, &axes, time);
+	if (tablet->axes_wanted) {
+		tablet_history_push(tablet, &tablet->axes);
+		tablet_smoothen_axes(tablet, &axes);
+
+		/* The delta relies on the last *smooth* point, so we do it
+		 * last */
+		axes.delta = tablet_tool_process_delta(tablet,
+						       tool,
+						       device,
+						       &axes,
+						       time);
+	}
 
 	*axes_out = axes;
 
@@ -1656,6 +1665,7 @@ tablet_process(struct evdev_dispatch *dispatch,
 		tablet_process_misc(tablet, device, e, time);
 		break;
 	case EV_SYN:
+		LIBINPUT_PROBE3(frame, device, DISPATCH_TABLET, time);
 		tablet_flush(tablet, device, time);
 		tablet_toggle_touch_device(tablet, device);
 		tablet_reset_state(tablet);
@@ -1768,6 +1778,7 @@ static struct evdev_dispatch_interface tablet_interface = {
 	NULL, /* device_resumed */
 	tablet_check_initial_proximity,
 	NULL, /* toggle_touch */
+	NULL, /* config_changed */
 };
 
 static void
@@ -1889,6 +1900,21 @@ out:
 	return rc;
 }
 
+static bool
+tablet_tool_events_wanted(struct evdev_device *device)
+{
+	struct libinput *libinput = evdev_libinput_context(device);
+
+	return libinput_wants_event_type(libinput,
+					 LIBINPUT_EVENT_TABLET_TOOL_AXIS) ||
+	       libinput_wants_event_type(libinput,
+					 LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY) ||
+	       libinput_wants_event_type(libinput,
+					 LIBINPUT_EVENT_TABLET_TOOL_TIP) ||
+	       libinput_wants_event_type(libinput,
+					 LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+}
+
 static int
 tablet_init(struct tablet_dispatch *tablet,
 	    struct evdev_device *device)
@@ -1901,6 +1927,7 @@ tablet_init(struct tablet_dispatch *tablet,
 	tablet->device = device;
 	tablet->status = TABLET_NONE;
 	tablet->current_tool_type = LIBINPUT_TOOL_NONE;
+	tablet->axes_wanted = tablet_tool_events_wanted(device);
 	list_init(&tablet->tool_list);
 
 	if (tablet_reject_device(device))
@@ -50,6 +50,12 @@ struct button_state {
 	unsigned char bits[NCHARS(KEY_CNT)];
 };
 
+/* The subset of struct tablet_axes that is smoothed */
+struct tablet_history_sample {
+	struct device_coords point;
+	struct tilt_degrees tilt;
+};
+
 struct tablet_dispatch {
 	struct evdev_dispatch base;
 	struct evdev_device *device;
@@ -60,8 +66,11 @@ struct tablet_dispatch {
 	struct {
 		unsigned int index;
 		unsigned int count;
-		struct tablet_axes samples[TABLET_HISTORY_LENGTH];
+		struct tablet_history_sample samples[TABLET_HISTORY_LENGTH];
 	} history;
+	/* false if the caller wants no tablet tool events, we skip
+	 * smoothing and acceleration then */
+	bool axes_wanted;
 
 	unsigned char axis_caps[NCHARS(LIBINPUT_TABLET_TOOL_AXIS_MAX + 1)];
 	int current_value[LIBINPUT_TABLET_TOOL_AXIS_MAX + 1];
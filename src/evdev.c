@@ -33,13 +33,13 @@
 #include "linux/input.h"
 #include <unistd.h>
 #include <fcntl.h>
-#include <mtdev-plumbing.h>
 #include <assert.h>
 #include <time.h>
 #include <math.h>
 
 #include "libinput.h"
 #include "evdev.h"
+#include "evdev-model-quirks.h"
 #include "filter.h"
 #include "libinput-private.h"
 
@@ -49,6 +49,11 @@
 
 #define DEFAULT_WHEEL_CLICK_ANGLE 15
 #define DEFAULT_BUTTON_SCROLL_TIMEOUT ms2us(200)
+/* Protocol A devices don't announce how many touches they support */
+#define FALLBACK_PROTOCOL_A_SLOTS 10
+/* A protocol A contact further than this from every touch of the
+ * previous frame is a new touch */
+#define FALLBACK_PROTOCOL_A_MAX_JUMP_MM 30
 
 enum evdev_key_type {
 	EVDEV_KEY_TYPE_NONE,
@@ -328,11 +333,19 @@ evdev_device_led_update(struct evdev_device *device, enum libinput_led leds)
 void
 evdev_transform_absolute(struct evdev_device *device,
 			 struct device_coords *point)
+{
+	evdev_transform_absolute_batch(device, &point->x, &point->y, 1);
+}
+
+void
+evdev_transform_absolute_batch(struct evdev_device *device,
+			       int *x, int *y,
+			       size_t count)
 {
 	if (!device->abs.apply_calibration)
 		return;
 
-	matrix_mult_vec(&device->abs.calibration, &point->x, &point->y);
+	matrix_mult_vec_batch(&device->abs.calibration, x, y, count);
 }
 
 void
@@ -409,32 +422,6 @@ evdev_post_trackpoint_scroll(struct evdev_device *device,
 	assert(!"invalid scroll button state");
 }
 
-static inline bool
-fallback_filter_defuzz_touch(struct fallback_dispatch *dispatch,
-			     struct evdev_device *device,
-			     struct mt_slot *slot)
-{
-	struct device_coords point;
-
-	if (!dispatch->mt.want_hysteresis)
-		return false;
-
-	point.x = evdev_hysteresis(slot->point.x,
-				   slot->hysteresis_center.x,
-				   dispatch->mt.hysteresis_margin.x);
-	point.y = evdev_hysteresis(slot->point.y,
-				   slot->hysteresis_center.y,
-				   dispatch->mt.hysteresis_margin.y);
-
-	slot->hysteresis_center = slot->point;
-	if (point.x == slot->point.x && point.y == slot->point.y)
-		return true;
-
-	slot->point = point;
-
-	return false;
-}
-
 static inline void
 fallback_rotate_relative(struct fallback_dispatch *dispatch,
 			 struct evdev_device *device)
@@ -510,15 +497,103 @@ fallback_flush_absolute_motion(struct fallback_dispatch *dispatch,
 	pointer_notify_motion_absolute(base, time, &point);
 }
 
+static inline void
+fallback_latch_aggregate(struct fallback_dispatch *dispatch,
+			 struct evdev_device *device)
+{
+	struct libinput *libinput = evdev_libinput_context(device);
+
+	dispatch->mt.aggregate = dispatch->mt.slots_len > 0 &&
+				 libinput->touch_frame_aggregation;
+}
+
+static void
+fallback_aggregate_post(struct fallback_dispatch *dispatch,
+			struct evdev_device *device,
+			uint64_t time)
+{
+	size_t i;
+
+	if (dispatch->mt.frame_len == 0)
+		return;
+
+	touch_notify_aggregate_frame(&device->base,
+				     time,
+				     dispatch->mt.frame,
+				     dispatch->mt.frame_len);
+
+	for (i = 0; i < dispatch->mt.frame_len; i++) {
+		int slot_idx = dispatch->mt.frame[i].slot;
+
+		dispatch->mt.slots[slot_idx].frame_index = -1;
+	}
+	dispatch->mt.frame_len = 0;
+}
+
+static void
+fallback_aggregate_slot(struct fallback_dispatch *dispatch,
+			struct evdev_device *device,
+			int slot_idx,
+			int seat_slot,
+			enum libinput_event_type type,
+			const struct device_coords *point,
+			uint64_t time)
+{
+	struct mt_slot *slot = &dispatch->mt.slots[slot_idx];
+	struct libinput_touch_slot_change *change;
+
+	/* A down or up for a slot that already changed in this frame
+	 * would lose information, post what we have and start over */
+	if (slot->frame_index != -1 && type != LIBINPUT_EVENT_TOUCH_MOTION)
+		fallback_aggregate_post(dispatch, device, time);
+
+	if (slot->frame_index == -1) {
+		slot->frame_index = dispatch->mt.frame_len++;
+		change = &dispatch->mt.frame[slot->frame_index];
+		*change = (struct libinput_touch_slot_change) {
+			.type = type,
+			.slot = slot_idx,
+			.seat_slot = seat_slot,
+		};
+	} else {
+		/* motion after a down stays a down */
+		change = &dispatch->mt.frame[slot->frame_index];
+	}
+
+	if (point) {
+		change->x = evdev_convert_to_mm(device->abs.absinfo_x,
+						point->x);
+		change->y = evdev_convert_to_mm(device->abs.absinfo_y,
+						point->y);
+		change->x_normalized = scale_axis(device->abs.absinfo_x,
+						  point->x,
+						  1.0);
+		change->y_normalized = scale_axis(device->abs.absinfo_y,
+						  point->y,
+						  1.0);
+	}
+}
+
+static void
+fallback_notify_touch_frame(struct fallback_dispatch *dispatch,
+			    struct evdev_device *device,
+			    uint64_t time)
+{
+	if (dispatch->mt.aggregate)
+		fallback_aggregate_post(dispatch, device, time);
+	else
+		touch_notify_frame(&device->base, time);
+}
+
 static bool
 fallback_flush_mt_down(struct fallback_dispatch *dispatch,
 		       struct evdev_device *device,
 		       int slot_idx,
+		       const struct device_coords *point,
 		       uint64_t time)
 {
 	struct libinput_device *base = &device->base;
 	struct libinput_seat *seat = base->seat;
-	struct device_coords point;
 	struct mt_slot *slot;
 	int seat_slot;
 
@@ -539,12 +614,14 @@ fallback_flush_mt_down(struct fallback_dispatch *dispatch,
 		return false;
 
 	seat->slot_map |= 1 << seat_slot;
-	point = slot->point;
-	slot->hysteresis_center = point;
-	evdev_transform_absolute(device, &point);
 
-	touch_notify_touch_down(base, time, slot_idx, seat_slot,
-				&point);
+	if (dispatch->mt.aggregate)
+		fallback_aggregate_slot(dispatch, device, slot_idx, seat_slot,
+					LIBINPUT_EVENT_TOUCH_DOWN,
+					point, time);
+	else
+		touch_notify_touch_down(base, time, slot_idx, seat_slot,
+					point);
 
 	return true;
 }
@@ -553,10 +630,10 @@ static bool
 fallback_flush_mt_motion(struct fallback_dispatch *dispatch,
 			 struct evdev_device *device,
 			 int slot_idx,
+			 const struct device_coords *point,
 			 uint64_t time)
 {
 	struct libinput_device *base = &device->base;
-	struct device_coords point;
 	struct mt_slot *slot;
 	int seat_slot;
 
@@ -565,17 +642,17 @@ fallback_flush_mt_motion(struct fallback_dispatch *dispatch,
 
 	slot = &dispatch->mt.slots[slot_idx];
 	seat_slot = slot->seat_slot;
-	point = slot->point;
 
 	if (seat_slot == -1)
 		return false;
 
-	if (fallback_filter_defuzz_touch(dispatch, device, slot))
-		return false;
-
-	evdev_transform_absolute(device, &point);
-	touch_notify_touch_motion(base, time, slot_idx, seat_slot,
-				  &point);
+	if (dispatch->mt.aggregate)
+		fallback_aggregate_slot(dispatch, device, slot_idx, seat_slot,
+					LIBINPUT_EVENT_TOUCH_MOTION,
+					point, time);
+	else
+		touch_notify_touch_motion(base, time, slot_idx, seat_slot,
+					  point);
 
 	return true;
 }
@@ -603,11 +680,141 @@ fallback_flush_mt_up(struct fallback_dispatch *dispatch,
 
 	seat->slot_map &= ~(1 << seat_slot);
 
-	touch_notify_touch_up(base, time, slot_idx, seat_slot);
+	if (dispatch->mt.aggregate)
+		fallback_aggregate_slot(dispatch, device, slot_idx, seat_slot,
+					LIBINPUT_EVENT_TOUCH_UP,
+					NULL, time);
+	else
+		touch_notify_touch_up(base, time, slot_idx, seat_slot);
 
 	return true;
 }
 
+static inline void
+fallback_mt_set_pending(struct fallback_dispatch *dispatch,
+			int slot_idx,
+			enum evdev_event_type type)
+{
+	struct mt_slot *slot = &dispatch->mt.slots[slot_idx];
+
+	if (slot->pending == EVDEV_NONE)
+		dispatch->mt.dirty[dispatch->mt.dirty_len++] = slot_idx;
+
+	slot->pending = type;
+}
+
+/**
+ * Flush the pending events of all slots that changed in this frame.
+ * Hysteresis and calibration are applied to the coordinates of all
+ * touch downs and motions in one pass before any event is sent.
+ * Hysteresis drops motions that stay within the margin, the events
+ * that are sent carry the unfiltered coordinates.
+ *
+ * @return true if at least one touch event was sent
+ */
+static bool
+fallback_flush_mt_frame(struct fallback_dispatch *dispatch,
+			struct evdev_device *device,
+			uint64_t time)
+{
+	struct mt_slot *slots = dispatch->mt.slots;
+	int *x = dispatch->mt.batch.x,
+	    *y = dispatch->mt.batch.y,
+	    *center_x = dispatch->mt.batch.center_x,
+	    *center_y = dispatch->mt.batch.center_y;
+	bool *unchanged = dispatch->mt.batch.unchanged;
+	size_t i, count = 0;
+	bool sent = false;
+
+	if (dispatch->mt.dirty_len == 0)
+		return false;
+
+	for (i = 0; i < dispatch->mt.dirty_len; i++) {
+		struct mt_slot *slot = &slots[dispatch->mt.dirty[i]];
+
+		if (slot->pending == EVDEV_ABSOLUTE_MT_UP)
+			continue;
+
+		/* a new touch starts with its own position as the
+		 * hysteresis center, i.e. it is never filtered */
+		if (slot->pending == EVDEV_ABSOLUTE_MT_DOWN)
+			slot->hysteresis_center = slot->point;
+
+		x[count] = slot->point.x;
+		y[count] = slot->point.y;
+		center_x[count] = slot->hysteresis_center.x;
+		center_y[count] = slot->hysteresis_center.y;
+		count++;
+	}
+
+	if (dispatch->mt.want_hysteresis) {
+		hysteresis_batch(x, y,
+				 center_x, center_y,
+				 dispatch->mt.hysteresis_margin.x,
+				 dispatch->mt.hysteresis_margin.y,
+				 unchanged,
+				 count);
+
+		for (i = 0, count = 0; i < dispatch->mt.dirty_len; i++) {
+			struct mt_slot *slot = &slots[dispatch->mt.dirty[i]];
+
+			if (slot->pending == EVDEV_ABSOLUTE_MT_UP)
+				continue;
+
+			slot->hysteresis_center.x = center_x[count];
+			slot->hysteresis_center.y = center_y[count];
+			x[count] = slot->point.x;
+			y[count] = slot->point.y;
+			count++;
+		}
+	}
+
+	evdev_transform_absolute_batch(device, x, y, count);
+
+	for (i = 0, count = 0; i < dispatch->mt.dirty_len; i++) {
+		int slot_idx = dispatch->mt.dirty[i];
+		struct mt_slot *slot = &slots[slot_idx];
+		enum evdev_event_type pending = slot->pending;
+		struct device_coords point;
+		bool filtered;
+
+		slot->pending = EVDEV_NONE;
+
+		switch (pending) {
+		case EVDEV_ABSOLUTE_MT_DOWN:
+			point.x = x[count];
+			point.y = y[count];
+			count++;
+			if (fallback_flush_mt_down(dispatch, device, slot_idx,
+						   &point, time))
+				sent = true;
+			break;
+		case EVDEV_ABSOLUTE_MT_MOTION:
+			point.x = x[count];
+			point.y = y[count];
+			filtered = dispatch->mt.want_hysteresis &&
+				   unchanged[count];
+			count++;
+			if (!filtered &&
+			    fallback_flush_mt_motion(dispatch, device, slot_idx,
+						     &point, time))
+				sent = true;
+			break;
+		case EVDEV_ABSOLUTE_MT_UP:
+			if (fallback_flush_mt_up(dispatch, device, slot_idx, time))
+				sent = true;
+			break;
+		default:
+			assert(0 && "Unknown pending slot event type");
+			break;
+		}
+	}
+
+	dispatch->mt.dirty_len = 0;
+
+	return sent;
+}
+
 static bool
 fallback_flush_st_down(struct fallback_dispatch *dispatch,
 		       struct evdev_device *device,
@@ -696,7 +903,6 @@ fallback_flush_pending_event(struct fallback_dispatch *dispatch,
 			     uint64_t time)
 {
 	enum evdev_event_type sent_event;
-	int slot_idx;
 
 	sent_event = dispatch->pending_event;
 
@@ -706,30 +912,6 @@ fallback_flush_pending_event(struct fallback_dispatch *dispatch,
 	case EVDEV_RELATIVE_MOTION:
 		fallback_flush_relative_motion(dispatch, device, time);
 		break;
-	case EVDEV_ABSOLUTE_MT_DOWN:
-		slot_idx = dispatch->mt.slot;
-		if (!fallback_flush_mt_down(dispatch,
-					    device,
-					    slot_idx,
-					    time))
-			sent_event = EVDEV_NONE;
-		break;
-	case EVDEV_ABSOLUTE_MT_MOTION:
-		slot_idx = dispatch->mt.slot;
-		if (!fallback_flush_mt_motion(dispatch,
-					      device,
-					      slot_idx,
-					      time))
-			sent_event = EVDEV_NONE;
-		break;
-	case EVDEV_ABSOLUTE_MT_UP:
-		slot_idx = dispatch->mt.slot;
-		if (!fallback_flush_mt_up(dispatch,
-					  device,
-					  slot_idx,
-					  time))
-			sent_event = EVDEV_NONE;
-		break;
 	case EVDEV_ABSOLUTE_TOUCH_DOWN:
 		if (!fallback_flush_st_down(dispatch, device, time))
 			sent_event = EVDEV_NONE;
@@ -873,12 +1055,328 @@ fallback_process_key(struct fallback_dispatch *dispatch,
 	}
 }
 
+static inline void
+fallback_mt_start_frame(struct fallback_dispatch *dispatch,
+			struct evdev_device *device)
+{
+	if (dispatch->mt.in_frame)
+		return;
+
+	fallback_latch_aggregate(dispatch, device);
+	dispatch->mt.in_frame = true;
+}
+
+static void
+fallback_process_touch_protocol_a(struct fallback_dispatch *dispatch,
+				  struct evdev_device *device,
+				  struct input_event *e)
+{
+	struct device_coords *contact;
+	size_t ncontacts;
+
+	switch (e->code) {
+	case ABS_MT_POSITION_X:
+	case ABS_MT_POSITION_Y:
+	case ABS_MT_TRACKING_ID:
+		/* more contacts than slots, drop the rest */
+		ncontacts = dispatch->mt.protocol_a.ncontacts;
+		if (ncontacts == dispatch->mt.slots_len)
+			break;
+
+		if (!dispatch->mt.protocol_a.in_contact) {
+			dispatch->mt.protocol_a.contact_ids[ncontacts] = -1;
+			dispatch->mt.protocol_a.in_contact = true;
+		}
+
+		if (e->code == ABS_MT_TRACKING_ID) {
+			dispatch->mt.protocol_a.contact_ids[ncontacts] = e->value;
+			break;
+		}
+
+		evdev_device_check_abs_axis_range(device, e->code, e->value);
+		contact = &dispatch->mt.protocol_a.contacts[ncontacts];
+		if (e->code == ABS_MT_POSITION_X)
+			contact->x = e->value;
+		else
+			contact->y = e->value;
+		break;
+	}
+}
+
+static inline void
+fallback_protocol_a_end_contact(struct fallback_dispatch *dispatch)
+{
+	if (!dispatch->mt.protocol_a.in_contact)
+		return;
+
+	dispatch->mt.protocol_a.ncontacts++;
+	dispatch->mt.protocol_a.in_contact = false;
+}
+
+/**
+ * The cost of continuing the touch at a with the contact at b: the
+ * squared distance, or limit if they are at least max_jump apart.
+ */
+static inline int64_t
+fallback_protocol_a_cost(const struct device_coords *a,
+			 const struct device_coords *b,
+			 int max_jump,
+			 int64_t limit)
+{
+	int64_t dx = (int64_t)b->x - a->x,
+		dy = (int64_t)b->y - a->y;
+
+	if (llabs(dx) >= max_jump || llabs(dy) >= max_jump)
+		return limit;
+
+	return min(dx * dx + dy * dy, limit);
+}
+
+/**
+ * Solve the n x n assignment problem with the Hungarian algorithm:
+ * pick one column per row so the sum of the costs is minimal.
+ * col_for_row receives the column picked for each row.
+ */
+static void
+fallback_protocol_a_solve(int64_t cost[][FALLBACK_PROTOCOL_A_SLOTS],
+			  size_t n,
+			  size_t *col_for_row)
+{
+	/* 1-based row/column potentials, column 0 is the root of each
+	 * augmenting path */
+	int64_t u[FALLBACK_PROTOCOL_A_SLOTS + 1] = {0},
+		v[FALLBACK_PROTOCOL_A_SLOTS + 1] = {0};
+	size_t row_for_col[FALLBACK_PROTOCOL_A_SLOTS + 1] = {0},
+	       way[FALLBACK_PROTOCOL_A_SLOTS + 1] = {0};
+	size_t i, j;
+
+	for (i = 1; i <= n; i++) {
+		int64_t minv[FALLBACK_PROTOCOL_A_SLOTS + 1];
+		bool used[FALLBACK_PROTOCOL_A_SLOTS + 1];
+		size_t j0 = 0, j1 = 0;
+
+		for (j = 0; j <= n; j++) {
+			minv[j] = INT64_MAX;
+			used[j] = false;
+		}
+
+		row_for_col[0] = i;
+		do {
+			size_t i0 = row_for_col[j0];
+			int64_t delta = INT64_MAX;
+
+			used[j0] = true;
+			for (j = 1; j <= n; j++) {
+				int64_t c;
+
+				if (used[j])
+					continue;
+
+				c = cost[i0 - 1][j - 1] - u[i0] - v[j];
+				if (c < minv[j]) {
+					minv[j] = c;
+					way[j] = j0;
+				}
+				if (minv[j] < delta) {
+					delta = minv[j];
+					j1 = j;
+				}
+			}
+
+			for (j = 0; j <= n; j++) {
+				if (used[j]) {
+					u[row_for_col[j]] += delta;
+					v[j] -= delta;
+				} else {
+					minv[j] -= delta;
+				}
+			}
+			j0 = j1;
+		} while (row_for_col[j0] != 0);
+
+		do {
+			j1 = way[j0];
+			row_for_col[j0] = row_for_col[j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+
+	for (j = 1; j <= n; j++)
+		col_for_row[row_for_col[j] - 1] = j - 1;
+}
+
+/**
+ * Assign the contacts of a protocol A frame to slots and set the
+ * slots' pending events as if the device had sent protocol B.
+ *
+ * If the device sends ABS_MT_TRACKING_ID, a contact continues the touch
+ * with the same tracking ID and a touch whose ID is missing from the
+ * frame ends.
+ *
+ * Anonymous contacts are matched to the remaining touches by position,
+ * minimizing the sum of the squared distances over all pairs. A
+ * contact at least FALLBACK_PROTOCOL_A_MAX_JUMP_MM away from a touch
+ * is never matched to it, the touch ends and the contact starts a new
+ * one. This is a guess, not tracking: two touches that cross each other
+ * between two frames, or that end and start again close to each other,
+ * are mixed up. There is no way to tell these apart from the positions
+ * alone.
+ *
+ * Slots left without a contact are lifted, contacts left without a
+ * slot start a new touch in the first free slot.
+ */
+static void
+fallback_protocol_a_track(struct fallback_dispatch *dispatch,
+			  struct evdev_device *device)
+{
+	struct device_coords *contacts = dispatch->mt.protocol_a.contacts;
+	int *contact_ids = dispatch->mt.protocol_a.contact_ids;
+	int *slot_ids = dispatch->mt.protocol_a.slot_ids;
+	int max_jump = dispatch->mt.protocol_a.max_jump;
+	int64_t limit = (int64_t)max_jump * max_jump;
+	int64_t cost[FALLBACK_PROTOCOL_A_SLOTS][FALLBACK_PROTOCOL_A_SLOTS];
+	size_t rows[FALLBACK_PROTOCOL_A_SLOTS],
+	       cols[FALLBACK_PROTOCOL_A_SLOTS],
+	       col_for_row[FALLBACK_PROTOCOL_A_SLOTS];
+	int contact_for_slot[FALLBACK_PROTOCOL_A_SLOTS];
+	unsigned int active = dispatch->mt.protocol_a.active;
+	unsigned int contacts_left;
+	size_t nslots = dispatch->mt.slots_len;
+	size_t ncontacts;
+	size_t nrows = 0, ncols = 0, n;
+	size_t s, c, i, j;
+
+	/* a contact without a trailing SYN_MT_REPORT */
+	fallback_protocol_a_end_contact(dispatch);
+	ncontacts = dispatch->mt.protocol_a.ncontacts;
+	contacts_left = (1U << ncontacts) - 1;
+
+	if (active == 0 && ncontacts == 0)
+		return;
+
+	for (s = 0; s < nslots; s++)
+		contact_for_slot[s] = -1;
+
+	for (s = 0; s < nslots; s++) {
+		if (!(active & (1U << s)) || slot_ids[s] == -1)
+			continue;
+
+		for (c = 0; c < ncontacts; c++) {
+			if ((contacts_left & (1U << c)) &&
+			    contact_ids[c] == slot_ids[s]) {
+				contact_for_slot[s] = c;
+				contacts_left &= ~(1U << c);
+				break;
+			}
+		}
+	}
+
+	for (s = 0; s < nslots; s++) {
+		if ((active & (1U << s)) && slot_ids[s] == -1)
+			rows[nrows++] = s;
+	}
+	for (c = 0; c < ncontacts; c++) {
+		if ((contacts_left & (1U << c)) && contact_ids[c] == -1)
+			cols[ncols++] = c;
+	}
+
+	/* Square up the matrix, a row or column matched to padding or
+	 * beyond the limit stays unmatched */
+	n = max(nrows, ncols);
+	if (nrows > 0 && ncols > 0) {
+		for (i = 0; i < n; i++) {
+			for (j = 0; j < n; j++) {
+				if (i >= nrows || j >= ncols) {
+					cost[i][j] = limit;
+					continue;
+				}
+
+				cost[i][j] = fallback_protocol_a_cost(
+					&dispatch->mt.slots[rows[i]].point,
+					&contacts[cols[j]],
+					max_jump,
+					limit);
+			}
+		}
+
+		fallback_protocol_a_solve(cost, n, col_for_row);
+
+		for (i = 0; i < nrows; i++) {
+			j = col_for_row[i];
+			if (j >= ncols || cost[i][j] >= limit)
+				continue;
+
+			contact_for_slot[rows[i]] = cols[j];
+			contacts_left &= ~(1U << cols[j]);
+		}
+	}
+
+	/* New contacts go into slots that were free before this frame,
+	 * a contact without a free slot is picked up in the next frame */
+	c = 0;
+	for (s = 0; s < nslots && contacts_left; s++) {
+		if (active & (1U << s))
+			continue;
+
+		while (!(contacts_left & (1U << c)))
+			c++;
+		contact_for_slot[s] = c;
+		contacts_left &= ~(1U << c);
+	}
+
+	fallback_mt_start_frame(dispatch, device);
+
+	for (s = 0; s < nslots; s++) {
+		struct mt_slot *slot = &dispatch->mt.slots[s];
+		bool was_active = !!(active & (1U << s));
+		struct device_coords *point;
+
+		if (contact_for_slot[s] == -1) {
+			if (was_active) {
+				fallback_mt_set_pending(dispatch,
+							s,
+							EVDEV_ABSOLUTE_MT_UP);
+				active &= ~(1U << s);
+			}
+			continue;
+		}
+
+		point = &contacts[contact_for_slot[s]];
+		if (!was_active) {
+			slot->point = *point;
+			slot_ids[s] = contact_ids[contact_for_slot[s]];
+			fallback_mt_set_pending(dispatch,
+						s,
+						EVDEV_ABSOLUTE_MT_DOWN);
+			active |= 1U << s;
+		} else if (slot->point.x != point->x ||
+			   slot->point.y != point->y) {
+			slot->point = *point;
+			fallback_mt_set_pending(dispatch,
+						s,
+						EVDEV_ABSOLUTE_MT_MOTION);
+		}
+	}
+
+	dispatch->mt.protocol_a.active = active;
+	dispatch->mt.protocol_a.ncontacts = 0;
+}
+
 static void
 fallback_process_touch(struct fallback_dispatch *dispatch,
 		       struct evdev_device *device,
 		       struct input_event *e,
 		       uint64_t time)
 {
+	struct mt_slot *slot;
+
+	fallback_mt_start_frame(dispatch, device);
+
+	if (dispatch->mt.protocol_a.enabled) {
+		fallback_process_touch_protocol_a(dispatch, device, e);
+		return;
+	}
+
 	switch (e->code) {
 	case ABS_MT_SLOT:
 		if ((size_t)e->value >= dispatch->mt.slots_len) {
@@ -888,29 +1386,42 @@ fallback_process_touch(struct fallback_dispatch *dispatch,
 					 dispatch->mt.slots_len);
 			e->value = dispatch->mt.slots_len - 1;
 		}
-		fallback_flush_pending_event(dispatch, device, time);
 		dispatch->mt.slot = e->value;
 		break;
 	case ABS_MT_TRACKING_ID:
-		if (dispatch->pending_event != EVDEV_NONE &&
-		    dispatch->pending_event != EVDEV_ABSOLUTE_MT_MOTION)
-			fallback_flush_pending_event(dispatch, device, time);
+		slot = &dispatch->mt.slots[dispatch->mt.slot];
+		/* a down and up for the same slot within one frame, send
+		 * what we have so far */
+		if (slot->pending != EVDEV_NONE &&
+		    slot->pending != EVDEV_ABSOLUTE_MT_MOTION &&
+		    fallback_flush_mt_frame(dispatch, device, time))
+			dispatch->mt.need_frame = true;
 		if (e->value >= 0)
-			dispatch->pending_event = EVDEV_ABSOLUTE_MT_DOWN;
+			fallback_mt_set_pending(dispatch,
+						dispatch->mt.slot,
+						EVDEV_ABSOLUTE_MT_DOWN);
 		else
-			dispatch->pending_event = EVDEV_ABSOLUTE_MT_UP;
+			fallback_mt_set_pending(dispatch,
+						dispatch->mt.slot,
+						EVDEV_ABSOLUTE_MT_UP);
 		break;
 	case ABS_MT_POSITION_X:
 		evdev_device_check_abs_axis_range(device, e->code, e->value);
-		dispatch->mt.slots[dispatch->mt.slot].point.x = e->value;
-		if (dispatch->pending_event == EVDEV_NONE)
-			dispatch->pending_event = EVDEV_ABSOLUTE_MT_MOTION;
+		slot = &dispatch->mt.slots[dispatch->mt.slot];
+		slot->point.x = e->value;
+		if (slot->pending == EVDEV_NONE)
+			fallback_mt_set_pending(dispatch,
+						dispatch->mt.slot,
+						EVDEV_ABSOLUTE_MT_MOTION);
 		break;
 	case ABS_MT_POSITION_Y:
 		evdev_device_check_abs_axis_range(device, e->code, e->value);
-		dispatch->mt.slots[dispatch->mt.slot].point.y = e->value;
-		if (dispatch->pending_event == EVDEV_NONE)
-			dispatch->pending_event = EVDEV_ABSOLUTE_MT_MOTION;
+		slot = &dispatch->mt.slots[dispatch->mt.slot];
+		slot->point.y = e->value;
+		if (slot->pending == EVDEV_NONE)
+			fallback_mt_set_pending(dispatch,
+						dispatch->mt.slot,
+						EVDEV_ABSOLUTE_MT_MOTION);
 		break;
 	}
 }
@@ -958,7 +1469,8 @@ evdev_notify_axis(struct evdev_device *device,
 			    axes,
 			    source,
 			    &delta,
-			    &discrete);
+			    &discrete,
+			    NULL);
 }
 
 static inline bool
@@ -978,32 +1490,16 @@ fallback_reject_relative(struct evdev_device *device,
 }
 
 static inline void
-fallback_process_relative(struct fallback_dispatch *dispatch,
-			  struct evdev_device *device,
-			  struct input_event *e, uint64_t time)
+fallback_process_wheel(struct evdev_device *device,
+		       struct input_event *e,
+		       uint64_t time)
 {
 	struct normalized_coords wheel_degrees = { 0.0, 0.0 };
 	struct discrete_coords discrete = { 0.0, 0.0 };
 	enum libinput_pointer_axis_source source;
 
-	if (fallback_reject_relative(device, e, time))
-		return;
-
 	switch (e->code) {
-	case REL_X:
-		if (dispatch->pending_event != EVDEV_RELATIVE_MOTION)
-			fallback_flush_pending_event(dispatch, device, time);
-		dispatch->rel.x += e->value;
-		dispatch->pending_event = EVDEV_RELATIVE_MOTION;
-		break;
-	case REL_Y:
-		if (dispatch->pending_event != EVDEV_RELATIVE_MOTION)
-			fallback_flush_pending_event(dispatch, device, time);
-		dispatch->rel.y += e->value;
-		dispatch->pending_event = EVDEV_RELATIVE_MOTION;
-		break;
 	case REL_WHEEL:
-		fallback_flush_pending_event(dispatch, device, time);
 		wheel_degrees.y = -1 * e->value *
 					device->scroll.wheel_click_angle.x;
 		discrete.y = -1 * e->value;
@@ -1021,7 +1517,6 @@ fallback_process_relative(struct fallback_dispatch *dispatch,
 			&discrete);
 		break;
 	case REL_HWHEEL:
-		fallback_flush_pending_event(dispatch, device, time);
 		wheel_degrees.x = e->value *
 					device->scroll.wheel_click_angle.y;
 		discrete.x = e->value;
@@ -1041,6 +1536,35 @@ fallback_process_relative(struct fallback_dispatch *dispatch,
 	}
 }
 
+static inline void
+fallback_process_relative(struct fallback_dispatch *dispatch,
+			  struct evdev_device *device,
+			  struct input_event *e, uint64_t time)
+{
+	if (fallback_reject_relative(device, e, time))
+		return;
+
+	switch (e->code) {
+	case REL_X:
+		if (dispatch->pending_event != EVDEV_RELATIVE_MOTION)
+			fallback_flush_pending_event(dispatch, device, time);
+		dispatch->rel.x += e->value;
+		dispatch->pending_event = EVDEV_RELATIVE_MOTION;
+		break;
+	case REL_Y:
+		if (dispatch->pending_event != EVDEV_RELATIVE_MOTION)
+			fallback_flush_pending_event(dispatch, device, time);
+		dispatch->rel.y += e->value;
+		dispatch->pending_event = EVDEV_RELATIVE_MOTION;
+		break;
+	case REL_WHEEL:
+	case REL_HWHEEL:
+		fallback_flush_pending_event(dispatch, device, time);
+		fallback_process_wheel(device, e, time);
+		break;
+	}
+}
+
 static inline void
 fallback_process_absolute(struct fallback_dispatch *dispatch,
 			  struct evdev_device *device,
@@ -1168,6 +1692,16 @@ fallback_process(struct evdev_dispatch *evdev_dispatch,
 		fallback_process_key(dispatch, device, event, time);
 		break;
 	case EV_SYN:
+		/* protocol A contact separator, not the end of a frame */
+		if (event->code == SYN_MT_REPORT) {
+			fallback_protocol_a_end_contact(dispatch);
+			break;
+		}
+
+		LIBINPUT_PROBE3(frame, device, DISPATCH_FALLBACK, time);
+		if (dispatch->mt.protocol_a.enabled)
+			fallback_protocol_a_track(dispatch, device);
+
 		sent = fallback_flush_pending_event(dispatch, device, time);
 		switch (sent) {
 		case EVDEV_ABSOLUTE_TOUCH_DOWN:
@@ -1175,13 +1709,120 @@ fallback_process(struct evdev_dispatch *evdev_dispatch,
 		case EVDEV_ABSOLUTE_MT_DOWN:
 		case EVDEV_ABSOLUTE_MT_MOTION:
 		case EVDEV_ABSOLUTE_MT_UP:
-			touch_notify_frame(&device->base, time);
+			dispatch->mt.need_frame = true;
 			break;
 		case EVDEV_ABSOLUTE_MOTION:
 		case EVDEV_RELATIVE_MOTION:
 		case EVDEV_NONE:
 			break;
 		}
+
+		if (fallback_flush_mt_frame(dispatch, device, time))
+			dispatch->mt.need_frame = true;
+
+		if (dispatch->mt.need_frame) {
+			fallback_notify_touch_frame(dispatch, device, time);
+			dispatch->mt.need_frame = false;
+		}
+
+		/* slot changes may have been collected even when the last
+		 * pending event was filtered */
+		if (dispatch->mt.aggregate)
+			fallback_aggregate_post(dispatch, device, time);
+		dispatch->mt.in_frame = false;
+		break;
+	}
+}
+
+/**
+ * Flush the accumulated relative motion of a device on the
+ * fallback_mouse_interface. Unlike fallback_flush_relative_motion(),
+ * there is no rotation and no button scrolling to consider.
+ */
+static inline void
+fallback_mouse_flush_motion(struct fallback_dispatch *dispatch,
+			    struct evdev_device *device,
+			    uint64_t time)
+{
+	struct normalized_coords accel;
+	struct device_float_coords raw;
+
+	if (dispatch->rel.x == 0 && dispatch->rel.y == 0)
+		return;
+
+	raw.x = dispatch->rel.x;
+	raw.y = dispatch->rel.y;
+	dispatch->rel.x = 0;
+	dispatch->rel.y = 0;
+
+	accel = filter_dispatch(device->pointer.filter, &raw, device, time);
+	pointer_notify_motion(&device->base, time, &accel, &raw);
+}
+
+static inline void
+fallback_mouse_process_key(struct fallback_dispatch *dispatch,
+			   struct evdev_device *device,
+			   struct input_event *e,
+			   uint64_t time)
+{
+	/* ignore kernel key repeat and releases for buttons we never got
+	 * the press for */
+	if (e->value == 2 ||
+	    (e->value == 0 && !hw_is_key_down(dispatch, e->code)))
+		return;
+
+	/* Still tracked so we can switch back to fallback_interface at
+	 * any time */
+	hw_set_key_down(dispatch, e->code, e->value);
+
+	if (get_key_type(e->code) != EVDEV_KEY_TYPE_BUTTON)
+		return;
+
+	evdev_pointer_post_button(device,
+				  time,
+				  e->code,
+				  e->value ? LIBINPUT_BUTTON_STATE_PRESSED :
+					     LIBINPUT_BUTTON_STATE_RELEASED);
+}
+
+/**
+ * Process function for plain relative mice, see
+ * fallback_mouse_interface_possible().
+ */
+static void
+fallback_mouse_process(struct evdev_dispatch *evdev_dispatch,
+		       struct evdev_device *device,
+		       struct input_event *event,
+		       uint64_t time)
+{
+	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
+
+	if (dispatch->ignore_events)
+		return;
+
+	switch (event->type) {
+	case EV_REL:
+		switch (event->code) {
+		case REL_X:
+			dispatch->rel.x += event->value;
+			break;
+		case REL_Y:
+			dispatch->rel.y += event->value;
+			break;
+		case REL_WHEEL:
+		case REL_HWHEEL:
+			fallback_mouse_flush_motion(dispatch, device, time);
+			fallback_process_wheel(device, event, time);
+			break;
+		}
+		break;
+	case EV_KEY:
+		fallback_mouse_flush_motion(dispatch, device, time);
+		fallback_mouse_process_key(dispatch, device, event, time);
+		break;
+	case EV_SYN:
+		LIBINPUT_PROBE3(frame, device, DISPATCH_FALLBACK, time);
+		fallback_mouse_flush_motion(dispatch, device, time);
 		break;
 	}
 }
@@ -1194,8 +1835,19 @@ release_touches(struct fallback_dispatch *dispatch,
 	unsigned int idx;
 	bool need_frame = false;
 
+	if (!dispatch->mt.in_frame)
+		fallback_latch_aggregate(dispatch, device);
+
 	need_frame = fallback_flush_st_up(dispatch, device, time);
 
+	/* anything still pending in this frame is dropped */
+	for (idx = 0; idx < dispatch->mt.dirty_len; idx++)
+		dispatch->mt.slots[dispatch->mt.dirty[idx]].pending = EVDEV_NONE;
+	dispatch->mt.dirty_len = 0;
+	dispatch->mt.protocol_a.active = 0;
+	dispatch->mt.protocol_a.ncontacts = 0;
+	dispatch->mt.protocol_a.in_contact = false;
+
 	for (idx = 0; idx < dispatch->mt.slots_len; idx++) {
 		struct mt_slot *slot = &dispatch->mt.slots[idx];
 
@@ -1206,8 +1858,9 @@ release_touches(struct fallback_dispatch *dispatch,
 			need_frame = true;
 	}
 
-	if (need_frame)
-		touch_notify_frame(&device->base, time);
+	if (need_frame || dispatch->mt.need_frame)
+		fallback_notify_touch_frame(dispatch, device, time);
+	dispatch->mt.need_frame = false;
 }
 
 static void
@@ -1301,12 +1954,28 @@ fallback_toggle_touch(struct evdev_dispatch *evdev_dispatch,
 	dispatch->ignore_events = ignore_events;
 }
 
+static inline void
+fallback_dispatch_free_slots(struct fallback_dispatch *dispatch)
+{
+	free(dispatch->mt.slots);
+	free(dispatch->mt.frame);
+	free(dispatch->mt.dirty);
+	free(dispatch->mt.batch.x);
+	free(dispatch->mt.batch.y);
+	free(dispatch->mt.batch.center_x);
+	free(dispatch->mt.batch.center_y);
+	free(dispatch->mt.batch.unchanged);
+	free(dispatch->mt.protocol_a.contacts);
+	free(dispatch->mt.protocol_a.contact_ids);
+	free(dispatch->mt.protocol_a.slot_ids);
+}
+
 static void
 fallback_destroy(struct evdev_dispatch *evdev_dispatch)
 {
 	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
 
-	free(dispatch->mt.slots);
+	fallback_dispatch_free_slots(dispatch);
 	free(dispatch);
 }
 
@@ -1348,22 +2017,114 @@ evdev_calibration_get_default_matrix(struct libinput_device *libinput_device,
 
 	matrix_to_farray6(&device->abs.default_calibration, matrix);
 
-	return !matrix_is_identity(&device->abs.default_calibration);
+	return !matrix_is_identity(&device->abs.default_calibration);
+}
+
+static void
+fallback_config_changed(struct evdev_dispatch *evdev_dispatch,
+			struct evdev_device *device);
+
+struct evdev_dispatch_interface fallback_interface = {
+	fallback_process,
+	fallback_suspend,
+	NULL, /* remove */
+	fallback_destroy,
+	NULL, /* device_added */
+	NULL, /* device_removed */
+	NULL, /* device_suspended */
+	NULL, /* device_resumed */
+	NULL, /* post_added */
+	fallback_toggle_touch, /* toggle_touch */
+	fallback_config_changed, /* config_changed */
+};
+
+/* Same dispatch as fallback_interface, for devices that are nothing
+ * but relative motion, buttons and wheels in their current
+ * configuration */
+struct evdev_dispatch_interface fallback_mouse_interface = {
+	fallback_mouse_process,
+	fallback_suspend,
+	NULL, /* remove */
+	fallback_destroy,
+	NULL, /* device_added */
+	NULL, /* device_removed */
+	NULL, /* device_suspended */
+	NULL, /* device_resumed */
+	NULL, /* post_added */
+	fallback_toggle_touch, /* toggle_touch */
+	fallback_config_changed, /* config_changed */
+};
+
+/**
+ * @return true if the device's current and pending configuration need
+ * none of the features fallback_mouse_interface leaves out
+ */
+static bool
+fallback_mouse_interface_possible(struct fallback_dispatch *dispatch,
+				  struct evdev_device *device)
+{
+	if (device->seat_caps != EVDEV_DEVICE_POINTER ||
+	    device->abs.absinfo_x ||
+	    !device->pointer.filter)
+		return false;
+
+	if (dispatch->rotation.angle != 0)
+		return false;
+
+	if (device->left_handed.enabled ||
+	    device->left_handed.want_enabled)
+		return false;
+
+	if (device->scroll.method == LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN ||
+	    device->scroll.want_method == LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN)
+		return false;
+
+	if (device->middlebutton.enabled ||
+	    device->middlebutton.want_enabled)
+		return false;
+
+	return true;
+}
+
+static void
+fallback_select_interface(struct fallback_dispatch *dispatch,
+			  struct evdev_device *device)
+{
+	struct evdev_dispatch_interface *interface;
+
+	interface = fallback_mouse_interface_possible(dispatch, device) ?
+			&fallback_mouse_interface : &fallback_interface;
+	if (dispatch->base.interface == interface)
+		return;
+
+	/* Hand over a frame in progress, e.g. when a left-handed change
+	 * takes effect on a button release. The generic path only flushes
+	 * dispatch->rel while a relative motion is pending, the mouse path
+	 * flushes whatever has accumulated and never looks at
+	 * pending_event. Devices that qualify for the mouse path have no
+	 * other pending event type. */
+	if (interface == &fallback_interface) {
+		if (dispatch->rel.x != 0 || dispatch->rel.y != 0)
+			dispatch->pending_event = EVDEV_RELATIVE_MOTION;
+	} else {
+		dispatch->pending_event = EVDEV_NONE;
+	}
+
+	dispatch->base.interface = interface;
+	evdev_log_debug(device,
+			"using the %s event processing\n",
+			interface == &fallback_interface ? "generic" : "mouse");
+}
+
+static void
+fallback_config_changed(struct evdev_dispatch *evdev_dispatch,
+			struct evdev_device *device)
+{
+	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
+
+	fallback_select_interface(dispatch, device);
 }
 
-struct evdev_dispatch_interface fallback_interface = {
-	fallback_process,
-	fallback_suspend,
-	NULL, /* remove */
-	fallback_destroy,
-	NULL, /* device_added */
-	NULL, /* device_removed */
-	NULL, /* device_suspended */
-	NULL, /* device_resumed */
-	NULL, /* post_added */
-	fallback_toggle_touch, /* toggle_touch */
-};
-
 static uint32_t
 evdev_sendevents_get_modes(struct libinput_device *device)
 {
@@ -1431,6 +2192,7 @@ evdev_change_to_left_handed(struct evdev_device *device)
 		return;
 
 	device->left_handed.enabled = device->left_handed.want_enabled;
+	fallback_select_interface(dispatch, device);
 }
 
 static enum libinput_config_status
@@ -1495,6 +2257,7 @@ evdev_change_scroll_method(struct evdev_device *device)
 
 	device->scroll.method = device->scroll.want_method;
 	device->scroll.button = device->scroll.want_button;
+	fallback_select_interface(dispatch, device);
 }
 
 static enum libinput_config_status
@@ -1626,6 +2389,62 @@ evdev_init_sendevents(struct evdev_device *device,
 	dispatch->sendevents.config.get_default_mode = evdev_sendevents_get_default_mode;
 }
 
+static int
+evdev_raw_is_available(struct libinput_device *device)
+{
+	return 1;
+}
+
+static enum libinput_config_status
+evdev_raw_set_enabled(struct libinput_device *device,
+		      enum libinput_config_raw_state enable)
+{
+	struct evdev_device *evdev = evdev_device(device);
+	struct evdev_dispatch *dispatch = evdev->dispatch;
+	bool enabled = (enable == LIBINPUT_CONFIG_RAW_ENABLED);
+
+	if (enabled == dispatch->raw.enabled)
+		return LIBINPUT_CONFIG_STATUS_SUCCESS;
+
+	/* Release anything logically down before the processing is
+	 * bypassed, and drop a partial raw frame on the way back */
+	if (enabled && dispatch->interface->suspend)
+		dispatch->interface->suspend(dispatch, evdev);
+
+	dispatch->raw.nevents = 0;
+	dispatch->raw.enabled = enabled;
+
+	return LIBINPUT_CONFIG_STATUS_SUCCESS;
+}
+
+static enum libinput_config_raw_state
+evdev_raw_get_enabled(struct libinput_device *device)
+{
+	struct evdev_device *evdev = evdev_device(device);
+	struct evdev_dispatch *dispatch = evdev->dispatch;
+
+	return dispatch->raw.enabled ? LIBINPUT_CONFIG_RAW_ENABLED :
+				       LIBINPUT_CONFIG_RAW_DISABLED;
+}
+
+static enum libinput_config_raw_state
+evdev_raw_get_default_enabled(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_RAW_DISABLED;
+}
+
+void
+evdev_init_raw(struct evdev_device *device,
+	       struct evdev_dispatch *dispatch)
+{
+	dispatch->raw.enabled = false;
+	dispatch->raw.config.is_available = evdev_raw_is_available;
+	dispatch->raw.config.set_enabled = evdev_raw_set_enabled;
+	dispatch->raw.config.get_enabled = evdev_raw_get_enabled;
+	dispatch->raw.config.get_default_enabled = evdev_raw_get_default_enabled;
+	device->base.config.raw = &dispatch->raw.config;
+}
+
 static int
 evdev_scroll_config_natural_has(struct libinput_device *device)
 {
@@ -1686,6 +2505,7 @@ evdev_rotation_config_set_angle(struct libinput_device *libinput_device,
 
 	dispatch->rotation.angle = degrees_cw;
 	matrix_init_rotate(&dispatch->rotation.matrix, degrees_cw);
+	fallback_select_interface(dispatch, device);
 
 	return LIBINPUT_CONFIG_STATUS_SUCCESS;
 }
@@ -1721,8 +2541,8 @@ evdev_init_rotation(struct evdev_device *device,
 	device->base.config.rotation = &dispatch->rotation.config;
 }
 
-static inline int
-evdev_need_mtdev(struct evdev_device *device)
+static inline bool
+evdev_is_mt_protocol_a(struct evdev_device *device)
 {
 	struct libevdev *evdev = device->evdev;
 
@@ -1758,31 +2578,76 @@ fallback_dispatch_init_slots(struct fallback_dispatch *dispatch,
 	    !libevdev_has_event_code(evdev, EV_ABS, ABS_MT_POSITION_Y))
 		 return 0;
 
-	/* We only handle the slotted Protocol B in libinput.
-	   Devices with ABS_MT_POSITION_* but not ABS_MT_SLOT
-	   require mtdev for conversion. */
-	if (evdev_need_mtdev(device)) {
-		device->mtdev = mtdev_new_open(device->fd);
-		if (!device->mtdev)
+	/* Devices with ABS_MT_POSITION_* but not ABS_MT_SLOT send
+	   Protocol A, their contacts are assigned to slots in
+	   fallback_protocol_a_track() */
+	if (evdev_is_mt_protocol_a(device)) {
+		num_slots = FALLBACK_PROTOCOL_A_SLOTS;
+		active_slot = 0;
+
+		dispatch->mt.protocol_a.enabled = true;
+		dispatch->mt.protocol_a.contacts =
+			calloc(num_slots,
+			       sizeof(*dispatch->mt.protocol_a.contacts));
+		dispatch->mt.protocol_a.contact_ids =
+			calloc(num_slots,
+			       sizeof(*dispatch->mt.protocol_a.contact_ids));
+		dispatch->mt.protocol_a.slot_ids =
+			calloc(num_slots,
+			       sizeof(*dispatch->mt.protocol_a.slot_ids));
+		if (!dispatch->mt.protocol_a.contacts ||
+		    !dispatch->mt.protocol_a.contact_ids ||
+		    !dispatch->mt.protocol_a.slot_ids) {
+			fallback_dispatch_free_slots(dispatch);
 			return -1;
+		}
 
-		/* pick 10 slots as default for type A
-		   devices. */
-		num_slots = 10;
-		active_slot = device->mtdev->caps.slot.value;
+		if (device->abs.is_fake_resolution)
+			dispatch->mt.protocol_a.max_jump =
+				max(device->abs.dimensions.x,
+				    device->abs.dimensions.y) / 4;
+		else
+			dispatch->mt.protocol_a.max_jump =
+				FALLBACK_PROTOCOL_A_MAX_JUMP_MM *
+				max(device->abs.absinfo_x->resolution,
+				    device->abs.absinfo_y->resolution);
 	} else {
 		num_slots = libevdev_get_num_slots(device->evdev);
 		active_slot = libevdev_get_current_slot(evdev);
 	}
 
 	slots = calloc(num_slots, sizeof(struct mt_slot));
-	if (!slots)
+	if (!slots) {
+		fallback_dispatch_free_slots(dispatch);
 		return -1;
+	}
+
+	dispatch->mt.frame = calloc(num_slots,
+				    sizeof(*dispatch->mt.frame));
+	dispatch->mt.dirty = calloc(num_slots, sizeof(*dispatch->mt.dirty));
+	dispatch->mt.batch.x = calloc(num_slots, sizeof(int));
+	dispatch->mt.batch.y = calloc(num_slots, sizeof(int));
+	dispatch->mt.batch.center_x = calloc(num_slots, sizeof(int));
+	dispatch->mt.batch.center_y = calloc(num_slots, sizeof(int));
+	dispatch->mt.batch.unchanged = calloc(num_slots, sizeof(bool));
+	if (!dispatch->mt.frame ||
+	    !dispatch->mt.dirty ||
+	    !dispatch->mt.batch.x ||
+	    !dispatch->mt.batch.y ||
+	    !dispatch->mt.batch.center_x ||
+	    !dispatch->mt.batch.center_y ||
+	    !dispatch->mt.batch.unchanged) {
+		free(slots);
+		fallback_dispatch_free_slots(dispatch);
+		return -1;
+	}
 
 	for (slot = 0; slot < num_slots; ++slot) {
 		slots[slot].seat_slot = -1;
+		slots[slot].frame_index = -1;
+		slots[slot].pending = EVDEV_NONE;
 
-		if (evdev_need_mtdev(device))
+		if (dispatch->mt.protocol_a.enabled)
 			continue;
 
 		slots[slot].point.x = libevdev_get_slot_value(evdev,
@@ -1880,6 +2745,8 @@ fallback_dispatch_create(struct libinput_device *libinput_device)
 					want_config);
 	}
 
+	fallback_select_interface(dispatch, device);
+
 	return &dispatch->base;
 }
 
@@ -1904,22 +2771,65 @@ evdev_process_event(struct evdev_device *device, struct input_event *e)
 	dispatch->interface->process(dispatch, device, e, time);
 }
 
+static inline void
+evdev_raw_process(struct evdev_device *device,
+		  struct evdev_dispatch *dispatch,
+		  struct input_event *e)
+{
+	if (dispatch->raw.nevents == dispatch->raw.size) {
+		size_t size = max(dispatch->raw.size * 2, 16U);
+		struct input_event *events;
+
+		events = realloc(dispatch->raw.events, size * sizeof(*events));
+		if (!events) {
+			evdev_log_error(device,
+					"failed to allocate raw frame, dropping event\n");
+			return;
+		}
+		dispatch->raw.events = events;
+		dispatch->raw.size = size;
+	}
+
+	dispatch->raw.events[dispatch->raw.nevents++] = *e;
+
+	if (!libevdev_event_is_code(e, EV_SYN, SYN_REPORT))
+		return;
+
+	/* The event takes the buffer, the next frame allocates a new one */
+	raw_notify_frame(&device->base,
+			 tv2us(&e->time),
+			 dispatch->raw.events,
+			 dispatch->raw.nevents);
+	dispatch->raw.events = NULL;
+	dispatch->raw.nevents = 0;
+	dispatch->raw.size = 0;
+}
+
+/* Events per read on the io_uring backend, a lower dispatch budget
+ * caps it further */
+#define EVDEV_READ_EVENTS 64
+
+static inline void
+evdev_drain_fd(int fd)
+{
+	struct input_event ev[24];
+	size_t sz = sizeof ev;
+
+	while (read(fd, &ev, sz) == (int)sz) {
+		/* discard all pending events */
+	}
+}
+
 static inline void
 evdev_device_dispatch_one(struct evdev_device *device,
 			  struct input_event *ev)
 {
-	if (!device->mtdev) {
-		evdev_process_event(device, ev);
-	} else {
-		mtdev_put_event(device->mtdev, ev);
-		if (libevdev_event_is_code(ev, EV_SYN, SYN_REPORT)) {
-			while (!mtdev_empty(device->mtdev)) {
-				struct input_event e;
-				mtdev_get_event(device->mtdev, &e);
-				evdev_process_event(device, &e);
-			}
-		}
+	if (device->dispatch->raw.enabled) {
+		evdev_raw_process(device, device->dispatch, ev);
+		return;
 	}
+
+	evdev_process_event(device, ev);
 }
 
 static int
@@ -1939,35 +2849,62 @@ evdev_sync_device(struct evdev_device *device)
 	return rc == -EAGAIN ? 0 : rc;
 }
 
+static int
+evdev_device_handle_syn_dropped(struct evdev_device *device,
+				struct input_event *ev)
+{
+	int rc;
+
+	LIBINPUT_PROBE1(syn_dropped, device);
+	evdev_log_info_ratelimit(device,
+				 &device->syn_drop_limit,
+				 "SYN_DROPPED event - some input events have been lost.\n");
+
+	/* send one more sync event so we handle all
+	   currently pending events before we sync up
+	   to the current state */
+	ev->code = SYN_REPORT;
+	evdev_device_dispatch_one(device, ev);
+
+	rc = evdev_sync_device(device);
+	LIBINPUT_PROBE2(syn_dropped_done, device, rc);
+
+	return rc;
+}
+
 static void
 evdev_device_dispatch(void *data)
 {
 	struct evdev_device *device = data;
 	struct libinput *libinput = evdev_libinput_context(device);
+	unsigned int budget = libinput->dispatch_budget;
+	unsigned int nevents = 0;
 	struct input_event ev;
 	int rc;
 
 	/* If the compositor is repainting, this function is called only once
 	 * per frame and we have to process all the events available on the
-	 * fd, otherwise there will be input lag. */
+	 * fd, otherwise there will be input lag. Once we're out of budget
+	 * we leave the rest for the next round of libinput_dispatch() so
+	 * other devices get their turn first. */
 	do {
+		if (budget != 0 && nevents++ == budget) {
+			libinput_source_mark_pending(libinput, device->source);
+			return;
+		}
+
 		rc = libevdev_next_event(device->evdev,
 					 LIBEVDEV_READ_FLAG_NORMAL, &ev);
 		if (rc == LIBEVDEV_READ_STATUS_SYNC) {
-			evdev_log_info_ratelimit(device,
-						 &device->syn_drop_limit,
-						 "SYN_DROPPED event - some input events have been lost.\n");
-
-			/* send one more sync event so we handle all
-			   currently pending events before we sync up
-			   to the current state */
-			ev.code = SYN_REPORT;
-			evdev_device_dispatch_one(device, &ev);
-
-			rc = evdev_sync_device(device);
+			rc = evdev_device_handle_syn_dropped(device, &ev);
 			if (rc == 0)
 				rc = LIBEVDEV_READ_STATUS_SUCCESS;
 		} else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
+			LIBINPUT_PROBE4(evdev_read,
+					device,
+					ev.type,
+					ev.code,
+					ev.value);
 			evdev_device_dispatch_one(device, &ev);
 		}
 	} while (rc == LIBEVDEV_READ_STATUS_SUCCESS);
@@ -1978,6 +2915,85 @@ evdev_device_dispatch(void *data)
 	}
 }
 
+/* Mirrors what libevdev_next_event() does for each event when the kernel
+ * did the read for us: skip codes the device doesn't have (we disable
+ * some on purpose) and out-of-range slots, and keep libevdev's state
+ * current since we query it elsewhere. */
+static inline bool
+evdev_update_libevdev_state(struct evdev_device *device,
+			    const struct input_event *ev)
+{
+	struct libevdev *evdev = device->evdev;
+
+	if (!libevdev_has_event_code(evdev, ev->type, ev->code))
+		return false;
+
+	switch (ev->type) {
+	case EV_ABS:
+		if (ev->code == ABS_MT_SLOT &&
+		    (ev->value < 0 || ev->value >= libevdev_get_num_slots(evdev)))
+			return false;
+		/* fallthrough */
+	case EV_KEY:
+	case EV_SW:
+	case EV_LED:
+		libevdev_set_event_value(evdev, ev->type, ev->code, ev->value);
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+/* The io_uring equivalent of evdev_device_dispatch(), called with up to
+ * EVDEV_READ_EVENTS (or dispatch budget) events the kernel read for us */
+static void
+evdev_device_read(void *data, void *buf, int res)
+{
+	struct evdev_device *device = data;
+	struct libinput *libinput = evdev_libinput_context(device);
+	struct input_event *events = buf;
+	struct input_event ev;
+	size_t i, nevents;
+	int rc = 0;
+
+	if (res < 0) {
+		rc = res;
+		goto out;
+	}
+
+	nevents = res / sizeof(*events);
+	for (i = 0; i < nevents; i++) {
+		if (libevdev_event_is_code(&events[i], EV_SYN, SYN_DROPPED)) {
+			/* Whatever else we have buffered is older than the
+			 * state we're about to sync to, drop it */
+			evdev_drain_fd(device->fd);
+			libevdev_next_event(device->evdev,
+					    LIBEVDEV_READ_FLAG_FORCE_SYNC,
+					    &ev);
+			rc = evdev_device_handle_syn_dropped(device, &ev);
+			break;
+		}
+
+		if (!evdev_update_libevdev_state(device, &events[i]))
+			continue;
+
+		LIBINPUT_PROBE4(evdev_read,
+				device,
+				events[i].type,
+				events[i].code,
+				events[i].value);
+		evdev_device_dispatch_one(device, &events[i]);
+	}
+
+out:
+	if (rc < 0 && rc != -EAGAIN && rc != -EINTR) {
+		libinput_remove_source(libinput, device->source);
+		device->source = NULL;
+	}
+}
+
 static inline bool
 evdev_init_accel(struct evdev_device *device,
 		 enum libinput_config_accel_profile which)
@@ -2260,6 +3276,106 @@ evdev_read_dpi_prop(struct evdev_device *device)
 	return dpi;
 }
 
+static inline char *
+evdev_model_quirk_sysattr(struct udev *udev,
+			  const char *subsystem,
+			  const char *sysname,
+			  const char *attr)
+{
+	struct udev_device *d;
+	const char *value;
+	char *str = NULL;
+
+	d = udev_device_new_from_subsystem_sysname(udev, subsystem, sysname);
+	if (!d)
+		return NULL;
+
+	value = udev_device_get_sysattr_value(d, attr);
+	if (value)
+		str = strdup(value);
+	udev_device_unref(d);
+
+	return str;
+}
+
+/* The DMI and devicetree strings are per machine, read them once per
+ * context rather than once per device */
+static void
+evdev_model_quirks_init_context(struct libinput *libinput,
+				struct udev *udev)
+{
+	if (libinput->model_quirks.initialized)
+		return;
+
+	libinput->model_quirks.dmi_modalias =
+		evdev_model_quirk_sysattr(udev, "dmi", "id", "modalias");
+	libinput->model_quirks.dt_model =
+		evdev_model_quirk_sysattr(udev, "devicetree", "base", "model");
+	libinput->model_quirks.initialized = true;
+}
+
+static uint32_t
+evdev_model_quirks_lookup(struct evdev_device *device)
+{
+	const struct quirk_type {
+		const char *property;
+		const char *prefix;
+		enum model_quirk_type type;
+	} types[] = {
+		{ "ID_INPUT_TOUCHPAD", "touchpad", MODEL_QUIRK_TOUCHPAD },
+		{ "ID_INPUT_MOUSE", "mouse", MODEL_QUIRK_MOUSE },
+		{ "ID_INPUT_KEYBOARD", "keyboard", MODEL_QUIRK_KEYBOARD },
+	};
+	struct libinput *libinput = evdev_libinput_context(device);
+	struct udev *udev = udev_device_get_udev(device->udev_device);
+	struct libevdev *evdev = device->evdev;
+	const struct quirk_type *t;
+	char match[256];
+	uint16_t bus, vid, pid;
+	uint32_t model_flags = 0;
+
+	bus = libevdev_get_id_bustype(evdev);
+	vid = libevdev_get_id_vendor(evdev);
+	pid = libevdev_get_id_product(evdev);
+
+	ARRAY_FOR_EACH(types, t) {
+		if (!parse_udev_flag(device, device->udev_device, t->property))
+			continue;
+
+		model_flags |= model_quirk_id_lookup(
+				model_quirk_id_key(t->type, bus, vid, pid));
+		model_flags |= model_quirk_id_lookup(
+				model_quirk_id_key(t->type, bus, vid, 0) |
+				MODEL_QUIRK_ANY_PRODUCT);
+
+		snprintf(match, sizeof(match),
+			 "libinput:%s:input:b%04Xv%04Xp%04Xe%04X-",
+			 t->prefix, bus, vid, pid,
+			 libevdev_get_id_version(evdev));
+		model_flags |= model_quirk_glob_lookup(match);
+	}
+
+	evdev_model_quirks_init_context(libinput, udev);
+
+	if (libinput->model_quirks.dmi_modalias) {
+		snprintf(match, sizeof(match),
+			 "libinput:name:%s:%s",
+			 libevdev_get_name(evdev),
+			 libinput->model_quirks.dmi_modalias);
+		model_flags |= model_quirk_glob_lookup(match);
+	}
+
+	if (libinput->model_quirks.dt_model) {
+		snprintf(match, sizeof(match),
+			 "libinput:name:%s:dt:%s",
+			 libevdev_get_name(evdev),
+			 libinput->model_quirks.dt_model);
+		model_flags |= model_quirk_glob_lookup(match);
+	}
+
+	return model_flags;
+}
+
 static inline uint32_t
 evdev_read_model_flags(struct evdev_device *device)
 {
@@ -2268,7 +3384,6 @@ evdev_read_model_flags(struct evdev_device *device)
 		enum evdev_device_model model;
 	} model_map[] = {
 #define MODEL(name) { "LIBINPUT_MODEL_" #name, EVDEV_MODEL_##name }
-		MODEL(LENOVO_X230),
 		MODEL(LENOVO_X230),
 		MODEL(LENOVO_X220_TOUCHPAD_FW81),
 		MODEL(CHROMEBOOK),
@@ -2298,15 +3413,29 @@ evdev_read_model_flags(struct evdev_device *device)
 		{ NULL, EVDEV_MODEL_DEFAULT },
 	};
 	const struct model_map *m = model_map;
-	uint32_t model_flags = 0;
+	uint32_t model_flags;
 
+	model_flags = evdev_model_quirks_lookup(device);
+
+	/* udev properties override the compiled-in table, so a local hwdb
+	 * entry can still set or unset a quirk */
 	while (m->property) {
-		if (parse_udev_flag(device,
-				    device->udev_device,
-				    m->property)) {
-			evdev_log_debug(device, "tagged as %s\n", m->property);
+		const char *val;
+
+		val = udev_device_get_property_value(device->udev_device,
+						     m->property);
+		if (val && streq(val, "1"))
 			model_flags |= m->model;
-		}
+		else if (val && streq(val, "0"))
+			model_flags &= ~m->model;
+		else if (val)
+			evdev_log_error(device,
+					"property %s has invalid value '%s'\n",
+					m->property,
+					val);
+
+		if (model_flags & m->model)
+			evdev_log_debug(device, "tagged as %s\n", m->property);
 		m++;
 	}
 
@@ -2792,17 +3921,6 @@ evdev_set_device_group(struct evdev_device *device,
 	return true;
 }
 
-static inline void
-evdev_drain_fd(int fd)
-{
-	struct input_event ev[24];
-	size_t sz = sizeof ev;
-
-	while (read(fd, &ev, sz) == (int)sz) {
-		/* discard all pending events */
-	}
-}
-
 static inline void
 evdev_pre_configure_model_quirks(struct evdev_device *device)
 {
@@ -2899,6 +4017,47 @@ libevdev_log_func(const struct libevdev *evdev,
 	log_msg_va(libinput, pri, fmt, args);
 }
 
+static inline struct list *
+evdev_device_index_bucket(struct libinput *libinput, const char *syspath)
+{
+	uint32_t hash = strhash(syspath);
+
+	return &libinput->device_index[hash % ARRAY_LENGTH(libinput->device_index)];
+}
+
+static void
+evdev_device_index_add(struct evdev_device *device)
+{
+	struct libinput *libinput = evdev_libinput_context(device);
+	const char *syspath = udev_device_get_syspath(device->udev_device);
+	struct list *bucket = evdev_device_index_bucket(libinput, syspath);
+
+	/* append, evdev_device_find() returns the oldest match */
+	list_insert(bucket->prev, &device->index_link);
+}
+
+/**
+ * Look up a device of this context by its syspath. If the same syspath
+ * was added more than once (path backend), the oldest device is
+ * returned.
+ *
+ * @return The device or NULL if no device with that syspath exists
+ */
+struct evdev_device *
+evdev_device_find(struct libinput *libinput, const char *syspath)
+{
+	struct list *bucket = evdev_device_index_bucket(libinput, syspath);
+	struct evdev_device *device;
+
+	list_for_each(device, bucket, index_link) {
+		if (streq(syspath,
+			  udev_device_get_syspath(device->udev_device)))
+			return device;
+	}
+
+	return NULL;
+}
+
 struct evdev_device *
 evdev_device_create(struct libinput_seat *seat,
 		    struct udev_device *udev_device)
@@ -2913,7 +4072,7 @@ evdev_device_create(struct libinput_seat *seat,
 
 	/* Use non-blocking mode so that we can loop on read on
 	 * evdev_device_data() until all events on the fd are
-	 * read.  mtdev_get() also expects this. */
+	 * read. */
 	fd = open_restricted(libinput, devnode,
 			     O_RDWR | O_NONBLOCK | O_CLOEXEC);
 	if (fd < 0) {
@@ -2948,7 +4107,6 @@ evdev_device_create(struct libinput_seat *seat,
 					 libinput);
 	device->seat_caps = 0;
 	device->is_mt = 0;
-	device->mtdev = NULL;
 	device->udev_device = udev_device_ref(udev_device);
 	device->dispatch = NULL;
 	device->fd = fd;
@@ -2980,8 +4138,15 @@ evdev_device_create(struct libinput_seat *seat,
 		goto err;
 	}
 
-	device->source =
-		libinput_add_fd(libinput, fd, evdev_device_dispatch, device);
+	evdev_init_raw(device, device->dispatch);
+
+	device->source = libinput_add_read_fd(libinput,
+					      fd,
+					      sizeof(struct input_event),
+					      EVDEV_READ_EVENTS,
+					      evdev_device_dispatch,
+					      evdev_device_read,
+					      device);
 	if (!device->source)
 		goto err;
 
@@ -2989,6 +4154,7 @@ evdev_device_create(struct libinput_seat *seat,
 		goto err;
 
 	list_insert(seat->devices_list.prev, &device->base.link);
+	evdev_device_index_add(device);
 
 	evdev_notify_added_device(device);
 
@@ -3193,6 +4359,24 @@ evdev_device_has_button(struct evdev_device *device, uint32_t code)
 	return libevdev_has_event_code(device->evdev, EV_KEY, code);
 }
 
+int
+evdev_device_pointer_predict(struct evdev_device *device,
+			     uint64_t time,
+			     struct filter_prediction *prediction)
+{
+	if (!(device->seat_caps & EVDEV_DEVICE_POINTER) ||
+	    !device->pointer.filter)
+		return -1;
+
+	if (!filter_predict(device->pointer.filter,
+			    device,
+			    time,
+			    prediction))
+		return -1;
+
+	return 0;
+}
+
 int
 evdev_device_has_key(struct evdev_device *device, uint32_t code)
 {
@@ -3222,6 +4406,65 @@ evdev_start_scrolling(struct evdev_device *device,
 	device->scroll.direction |= AS_MASK(axis);
 }
 
+static inline void
+evdev_scroll_history_push(struct evdev_device *device,
+			  uint64_t time,
+			  const struct normalized_coords *delta)
+{
+	struct evdev_scroll_sample *sample;
+
+	sample = &device->scroll.history.samples[device->scroll.history.next];
+	sample->time = time;
+	sample->delta = *delta;
+
+	device->scroll.history.next = (device->scroll.history.next + 1) %
+				      EVDEV_SCROLL_HISTORY;
+	if (device->scroll.history.count < EVDEV_SCROLL_HISTORY)
+		device->scroll.history.count++;
+}
+
+/* Estimates the scroll velocity in units/s at the given time from the
+ * deltas within EVDEV_SCROLL_VELOCITY_WINDOW. Each delta covers the time
+ * since the previous one, so the oldest delta in the window only provides
+ * the start time. If the fingers rested before the sequence ended, there
+ * are no deltas in the window and the velocity is zero */
+static struct normalized_coords
+evdev_scroll_velocity(struct evdev_device *device, uint64_t time)
+{
+	struct normalized_coords velocity = { 0.0, 0.0 };
+	struct normalized_coords sum = { 0.0, 0.0 };
+	const struct evdev_scroll_sample *oldest = NULL;
+	uint64_t last = 0;
+	unsigned int i;
+
+	for (i = 1; i <= device->scroll.history.count; i++) {
+		unsigned int idx = (device->scroll.history.next +
+				    EVDEV_SCROLL_HISTORY - i) %
+				   EVDEV_SCROLL_HISTORY;
+		const struct evdev_scroll_sample *sample;
+
+		sample = &device->scroll.history.samples[idx];
+		if (time - sample->time > EVDEV_SCROLL_VELOCITY_WINDOW)
+			break;
+
+		if (oldest) {
+			sum.x += oldest->delta.x;
+			sum.y += oldest->delta.y;
+		} else {
+			last = sample->time;
+		}
+		oldest = sample;
+	}
+
+	if (!oldest || last == oldest->time)
+		return velocity;
+
+	velocity.x = sum.x / (last - oldest->time) * s2us(1);
+	velocity.y = sum.y / (last - oldest->time) * s2us(1);
+
+	return velocity;
+}
+
 void
 evdev_post_scroll(struct evdev_device *device,
 		  uint64_t time,
@@ -3288,6 +4531,8 @@ evdev_post_scroll(struct evdev_device *device,
 		if (event.x == 0.0)
 			axes &= ~AS_MASK(LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL);
 
+		evdev_scroll_history_push(device, time, &event);
+
 		evdev_notify_axis(device,
 				  time,
 				  axes,
@@ -3304,19 +4549,39 @@ evdev_stop_scroll(struct evdev_device *device,
 {
 	const struct normalized_coords zero = { 0.0, 0.0 };
 	const struct discrete_coords zero_discrete = { 0.0, 0.0 };
+	struct normalized_coords velocity;
+
+	/* terminate scrolling with a zero scroll event that carries the
+	 * velocity of the sequence for kinetic scrolling */
+	if (device->scroll.direction != 0) {
+		velocity = evdev_scroll_velocity(device, time);
+
+		if (!evdev_is_scrolling(device,
+					LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL))
+			velocity.y = 0.0;
+		if (!evdev_is_scrolling(device,
+					LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL))
+			velocity.x = 0.0;
+
+		if (device->scroll.natural_scrolling_enabled) {
+			velocity.x *= -1;
+			velocity.y *= -1;
+		}
 
-	/* terminate scrolling with a zero scroll event */
-	if (device->scroll.direction != 0)
 		pointer_notify_axis(&device->base,
 				    time,
 				    device->scroll.direction,
 				    source,
 				    &zero,
-				    &zero_discrete);
+				    &zero_discrete,
+				    &velocity);
+	}
 
 	device->scroll.buildup.x = 0;
 	device->scroll.buildup.y = 0;
 	device->scroll.direction = 0;
+	device->scroll.history.count = 0;
+	device->scroll.history.next = 0;
 }
 
 void
@@ -3375,11 +4640,6 @@ evdev_device_suspend(struct evdev_device *device)
 		device->source = NULL;
 	}
 
-	if (device->mtdev) {
-		mtdev_close_delete(device->mtdev);
-		device->mtdev = NULL;
-	}
-
 	if (device->fd != -1) {
 		close_restricted(libinput, device->fd);
 		device->fd = -1;
@@ -3417,12 +4677,6 @@ evdev_device_resume(struct evdev_device *device)
 
 	device->fd = fd;
 
-	if (evdev_need_mtdev(device)) {
-		device->mtdev = mtdev_new_open(device->fd);
-		if (!device->mtdev)
-			return -ENODEV;
-	}
-
 	libevdev_change_fd(device->evdev, fd);
 	libevdev_set_clock_id(device->evdev, CLOCK_MONOTONIC);
 
@@ -3437,12 +4691,15 @@ evdev_device_resume(struct evdev_device *device)
 					     &ev);
 	} while (status == LIBEVDEV_READ_STATUS_SYNC);
 
-	device->source =
-		libinput_add_fd(libinput, fd, evdev_device_dispatch, device);
-	if (!device->source) {
-		mtdev_close_delete(device->mtdev);
+	device->source = libinput_add_read_fd(libinput,
+					      fd,
+					      sizeof(struct input_event),
+					      EVDEV_READ_EVENTS,
+					      evdev_device_dispatch,
+					      evdev_device_read,
+					      device);
+	if (!device->source)
 		return -ENOMEM;
-	}
 
 	evdev_notify_resumed_device(device);
 
@@ -3475,6 +4732,7 @@ evdev_device_remove(struct evdev_device *device)
 	device->was_removed = true;
 
 	list_remove(&device->base.link);
+	list_remove(&device->index_link);
 
 	notify_removed_device(&device->base);
 	libinput_device_unref(&device->base);
@@ -3486,8 +4744,10 @@ evdev_device_destroy(struct evdev_device *device)
 	struct evdev_dispatch *dispatch;
 
 	dispatch = device->dispatch;
-	if (dispatch)
+	if (dispatch) {
+		free(dispatch->raw.events);
 		dispatch->interface->destroy(dispatch);
+	}
 
 	if (device->base.group)
 		libinput_device_group_unref(device->base.group);
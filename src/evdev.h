@@ -35,6 +35,7 @@
 #include "libinput-private.h"
 #include "timer.h"
 #include "filter.h"
+#include "libinput-tracepoint.h"
 
 /*
  * The constant (linear) acceleration factor we use to normalize trackpoint
@@ -45,6 +46,16 @@
 /* The fake resolution value for abs devices without resolution */
 #define EVDEV_FAKE_RESOLUTION 1
 
+/* Number of scroll deltas kept to estimate the velocity at the end of a
+ * scroll sequence, only deltas within the window are used */
+#define EVDEV_SCROLL_HISTORY 16
+#define EVDEV_SCROLL_VELOCITY_WINDOW ms2us(100)
+
+struct evdev_scroll_sample {
+	uint64_t time;
+	struct normalized_coords delta;
+};
+
 enum evdev_event_type {
 	EVDEV_NONE,
 	EVDEV_ABSOLUTE_TOUCH_DOWN,
@@ -139,6 +150,12 @@ struct mt_slot {
 	int32_t seat_slot;
 	struct device_coords point;
 	struct device_coords hysteresis_center;
+
+	/* EVDEV_ABSOLUTE_MT_* flushed at the end of the frame */
+	enum evdev_event_type pending;
+
+	/* index into fallback_dispatch.mt.frame or -1 */
+	int frame_index;
 };
 
 struct evdev_device {
@@ -151,6 +168,7 @@ struct evdev_device {
 	struct udev_device *udev_device;
 	char *output_name;
 	const char *devname;
+	struct list index_link; /* libinput->device_index */
 	bool was_removed;
 	int fd;
 	enum evdev_device_seat_capability seat_caps;
@@ -161,7 +179,6 @@ struct evdev_device {
 	struct ratelimit syn_drop_limit; /* ratelimit for SYN_DROPPED logging */
 	struct ratelimit nonpointer_rel_limit; /* ratelimit for REL_* events from non-pointer devices */
 	uint32_t model_flags;
-	struct mtdev *mtdev;
 
 	struct {
 		const struct input_absinfo *absinfo_x, *absinfo_y;
@@ -209,6 +226,14 @@ struct evdev_device {
 		struct wheel_angle wheel_click_angle;
 
 		struct wheel_tilt_flags is_tilt;
+
+		/* ring of the most recent deltas of the current scroll
+		 * sequence, before natural scrolling is applied */
+		struct {
+			struct evdev_scroll_sample samples[EVDEV_SCROLL_HISTORY];
+			unsigned int count;
+			unsigned int next;
+		} history;
 	} scroll;
 
 	struct {
@@ -295,6 +320,11 @@ struct evdev_dispatch_interface {
 	void (*toggle_touch)(struct evdev_dispatch *dispatch,
 			     struct evdev_device *device,
 			     bool enable);
+
+	/* A configuration option was changed by the caller. The new value
+	 * may not have taken effect yet (may be NULL) */
+	void (*config_changed)(struct evdev_dispatch *dispatch,
+			       struct evdev_device *device);
 };
 
 enum evdev_dispatch_type {
@@ -313,6 +343,17 @@ struct evdev_dispatch {
 		struct libinput_device_config_send_events config;
 		enum libinput_config_send_events_mode current_mode;
 	} sendevents;
+
+	struct {
+		struct libinput_device_config_raw config;
+		bool enabled;
+
+		/* The frame being collected, ownership passes to the
+		 * LIBINPUT_EVENT_RAW_FRAME event on SYN_REPORT */
+		struct input_event *events;
+		size_t nevents;
+		size_t size;
+	} raw;
 };
 
 static inline void
@@ -351,6 +392,53 @@ struct fallback_dispatch {
 		size_t slots_len;
 		bool want_hysteresis;
 		struct device_coords hysteresis_margin;
+
+		/* Slots with a pending event, in the order they changed
+		 * within the current frame */
+		int *dirty;
+		size_t dirty_len;
+		/* A touch event was sent before SYN_REPORT and the frame
+		 * still needs to be terminated */
+		bool need_frame;
+
+		/* Protocol A devices: the contacts of the current frame
+		 * and the slots that have a touch */
+		struct {
+			bool enabled;
+			struct device_coords *contacts;
+			size_t ncontacts;
+			bool in_contact;
+			unsigned int active;
+
+			/* ABS_MT_TRACKING_ID of each contact and of the
+			 * touch in each slot, -1 if the device didn't
+			 * send one */
+			int *contact_ids;
+			int *slot_ids;
+
+			/* Max distance in device units a touch may
+			 * move between two frames */
+			int max_jump;
+		} protocol_a;
+
+		/* The dirty slots' coordinates as separate arrays so
+		 * hysteresis and calibration can be applied to all of
+		 * them at once */
+		struct {
+			int *x;
+			int *y;
+			int *center_x;
+			int *center_y;
+			bool *unchanged;
+		} batch;
+
+		/* Latched from the context at the start of each frame, if
+		 * set the slot changes are collected in frame and posted
+		 * as one LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME */
+		bool in_frame;
+		bool aggregate;
+		struct libinput_touch_slot_change *frame;
+		size_t frame_len;
 	} mt;
 
 	struct device_coords rel;
@@ -374,6 +462,15 @@ fallback_dispatch(struct evdev_dispatch *dispatch)
 	return container_of(dispatch, struct fallback_dispatch, base);
 }
 
+static inline void
+evdev_dispatch_config_changed(struct evdev_device *device)
+{
+	struct evdev_dispatch *dispatch = device->dispatch;
+
+	if (dispatch->interface->config_changed)
+		dispatch->interface->config_changed(dispatch, device);
+}
+
 struct evdev_device *
 evdev_device_create(struct libinput_seat *seat,
 		    struct udev_device *device);
@@ -382,6 +479,11 @@ void
 evdev_transform_absolute(struct evdev_device *device,
 			 struct device_coords *point);
 
+void
+evdev_transform_absolute_batch(struct evdev_device *device,
+			       int *x, int *y,
+			       size_t count);
+
 void
 evdev_transform_relative(struct evdev_device *device,
 			 struct device_coords *point);
@@ -397,6 +499,10 @@ void
 evdev_init_sendevents(struct evdev_device *device,
 		      struct evdev_dispatch *dispatch);
 
+void
+evdev_init_raw(struct evdev_device *device,
+	       struct evdev_dispatch *dispatch);
+
 void
 evdev_device_init_pointer_acceleration(struct evdev_device *device,
 				       struct motion_filter *filter);
@@ -459,6 +565,11 @@ evdev_device_get_size(const struct evdev_device *device,
 int
 evdev_device_has_button(struct evdev_device *device, uint32_t code);
 
+int
+evdev_device_pointer_predict(struct evdev_device *device,
+			     uint64_t time,
+			     struct filter_prediction *prediction);
+
 int
 evdev_device_has_key(struct evdev_device *device, uint32_t code);
 
@@ -543,6 +654,9 @@ evdev_stop_scroll(struct evdev_device *device,
 void
 evdev_device_remove(struct evdev_device *device);
 
+struct evdev_device *
+evdev_device_find(struct libinput *libinput, const char *syspath);
+
 void
 evdev_device_destroy(struct evdev_device *device);
 
@@ -41,6 +41,10 @@ struct motion_filter_interface {
 	void (*restart)(struct motion_filter *filter,
 			void *data,
 			uint64_t time);
+	bool (*predict)(struct motion_filter *filter,
+			void *data,
+			uint64_t time,
+			struct filter_prediction *prediction);
 	void (*destroy)(struct motion_filter *filter);
 	bool (*set_speed)(struct motion_filter *filter,
 			  double speed_adjustment);
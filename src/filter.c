@@ -35,6 +35,7 @@
 #include "filter.h"
 #include "libinput-util.h"
 #include "filter-private.h"
+#include "libinput-tracepoint.h"
 
 /* Once normalized, touchpads see the same acceleration as mice. that is
  * technically correct but subjectively wrong, we expect a touchpad to be a
@@ -78,6 +79,8 @@ filter_dispatch(struct motion_filter *filter,
 		const struct device_float_coords *unaccelerated,
 		void *data, uint64_t time)
 {
+	LIBINPUT_PROBE3(filter_dispatch, filter, unaccelerated, time);
+
 	return filter->interface->filter(filter, unaccelerated, data, time);
 }
 
@@ -97,6 +100,17 @@ filter_restart(struct motion_filter *filter,
 		filter->interface->restart(filter, data, time);
 }
 
+bool
+filter_predict(struct motion_filter *filter,
+	       void *data, uint64_t time,
+	       struct filter_prediction *prediction)
+{
+	if (!filter->interface->predict)
+		return false;
+
+	return filter->interface->predict(filter, data, time, prediction);
+}
+
 void
 filter_destroy(struct motion_filter *filter)
 {
@@ -155,6 +169,14 @@ filter_get_type(struct motion_filter *filter)
 #define MOTION_TIMEOUT		ms2us(1000)
 #define NUM_POINTER_TRACKERS	16
 
+/*
+ * Motion prediction constants
+ */
+
+#define PREDICTION_HISTORY	ms2us(100) /* max age of trackers used */
+#define PREDICTION_MAX_HORIZON	ms2us(50) /* max time predicted ahead */
+#define PREDICTION_MIN_SAMPLES	3 /* segments needed for full confidence */
+
 struct pointer_tracker {
 	struct device_float_coords delta; /* delta to most recent event */
 	uint64_t time;  /* us */
@@ -396,6 +418,151 @@ calculate_acceleration_factor(struct pointer_accelerator *accel,
 	return accel_factor;
 }
 
+/**
+ * Predict the motion between the most recent event and the given time.
+ *
+ * The per-event velocities within PREDICTION_HISTORY are fitted to a
+ * straight line (weighted by the event interval), giving the current
+ * velocity and acceleration. The history stops at the first direction
+ * change and at least two segments in the same direction are needed, so
+ * a direction change on the most recent event leaves nothing to predict
+ * from.
+ *
+ * The error is the distance the prediction may be off by: the part
+ * contributed by the acceleration term plus the fit residual over the
+ * horizon. The confidence is reduced for short histories, for horizons
+ * long compared to the history and for noisy velocities.
+ *
+ * @param accel The acceleration filter
+ * @param data Caller-specific data
+ * @param time The time to predict the motion for in µs
+ * @param[out] delta The predicted accelerated delta, in the filter's
+ * tracker units
+ * @param[out] error The error radius, in the filter's tracker units
+ * @param[out] confidence The confidence in the range [0, 1]
+ *
+ * @return true if a prediction is available, false otherwise
+ */
+static bool
+accelerator_predict_generic(struct pointer_accelerator *accel,
+			    void *data,
+			    uint64_t time,
+			    struct device_float_coords *delta,
+			    double *error,
+			    double *confidence)
+{
+	struct pointer_tracker *newest, *tracker, *prev;
+	struct device_float_coords v, v0, a, d;
+	struct device_float_coords sv = {0}, stv = {0};
+	double sw = 0, st = 0, stt = 0, denom;
+	double residual = 0.0;
+	double t, dt, horizon, span;
+	double speed, velocity_end, factor;
+	unsigned int dir;
+	unsigned int offset;
+	int nsegments = 0;
+
+	newest = tracker_by_offset(accel, 0);
+	if (newest->time == 0 || time < newest->time)
+		return false;
+
+	horizon = time - newest->time;
+	if (horizon > PREDICTION_MAX_HORIZON)
+		return false;
+
+	/* Weighted least squares of per-event velocity over time, time is
+	 * relative to the most recent event */
+	dir = newest->dir;
+	prev = newest;
+	for (offset = 1; offset < NUM_POINTER_TRACKERS; offset++) {
+		tracker = tracker_by_offset(accel, offset);
+
+		if (tracker->time >= prev->time ||
+		    newest->time - tracker->time > PREDICTION_HISTORY)
+			break;
+
+		dir &= prev->dir;
+		if (dir == 0)
+			break;
+
+		dt = prev->time - tracker->time;
+		t = (tracker->time + prev->time)/2.0 - newest->time;
+		v.x = (tracker->delta.x - prev->delta.x)/dt;
+		v.y = (tracker->delta.y - prev->delta.y)/dt;
+
+		sw += dt;
+		st += dt * t;
+		stt += dt * t * t;
+		sv.x += dt * v.x;
+		sv.y += dt * v.y;
+		stv.x += dt * t * v.x;
+		stv.y += dt * t * v.y;
+
+		nsegments++;
+		prev = tracker;
+	}
+
+	/* One segment leaves the newest event's direction unconfirmed,
+	 * e.g. right after a direction change */
+	if (nsegments < 2)
+		return false;
+
+	denom = sw * stt - st * st;
+	if (denom <= 0.0) {
+		a.x = 0.0;
+		a.y = 0.0;
+	} else {
+		a.x = (sw * stv.x - st * sv.x)/denom;
+		a.y = (sw * stv.y - st * sv.y)/denom;
+	}
+	v0.x = (sv.x - a.x * st)/sw;
+	v0.y = (sv.y - a.y * st)/sw;
+
+	speed = hypot(v0.x, v0.y);
+	if (speed == 0.0)
+		return false;
+
+	/* Second pass for the residual of the fit */
+	prev = newest;
+	for (offset = 1; offset <= (unsigned int)nsegments; offset++) {
+		tracker = tracker_by_offset(accel, offset);
+		dt = prev->time - tracker->time;
+		t = (tracker->time + prev->time)/2.0 - newest->time;
+		v.x = (tracker->delta.x - prev->delta.x)/dt - (v0.x + a.x * t);
+		v.y = (tracker->delta.y - prev->delta.y)/dt - (v0.y + a.y * t);
+		residual += dt * (v.x * v.x + v.y * v.y);
+		prev = tracker;
+	}
+	residual = sqrt(residual/sw); /* units/us */
+	span = newest->time - prev->time;
+
+	/* Decelerating: stop where the velocity reaches zero, never
+	 * predict motion in the opposite direction */
+	t = horizon;
+	if (a.x * v0.x + a.y * v0.y < 0.0)
+		t = min(t, -(v0.x * v0.x + v0.y * v0.y)/
+			   (a.x * v0.x + a.y * v0.y));
+
+	d.x = v0.x * t + 0.5 * a.x * t * t;
+	d.y = v0.y * t + 0.5 * a.y * t * t;
+	velocity_end = hypot(v0.x + a.x * t, v0.y + a.y * t);
+
+	factor = calculate_acceleration(accel,
+					data,
+					velocity_end,
+					speed,
+					time);
+
+	delta->x = factor * d.x;
+	delta->y = factor * d.y;
+	*error = factor * (0.5 * hypot(a.x, a.y) * t * t + residual * horizon);
+	*confidence = min(1.0, (double)nsegments/PREDICTION_MIN_SAMPLES) *
+		      span/(span + horizon) *
+		      speed/(speed + residual);
+
+	return true;
+}
+
 /**
  * Generic filter that calculates the acceleration factor and applies it to
  * the coordinates.
@@ -630,6 +797,57 @@ accelerator_restart(struct motion_filter *filter,
 	tracker->dir = UNDEFINED_DIRECTION;
 }
 
+static bool
+accelerator_predict(struct motion_filter *filter,
+		    void *data,
+		    uint64_t time,
+		    struct filter_prediction *prediction)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *) filter;
+	struct device_float_coords delta;
+
+	/* Trackers are in the same units as the filter output */
+	if (!accelerator_predict_generic(accel,
+					 data,
+					 time,
+					 &delta,
+					 &prediction->error,
+					 &prediction->confidence))
+		return false;
+
+	prediction->delta.x = delta.x;
+	prediction->delta.y = delta.y;
+
+	return true;
+}
+
+static bool
+accelerator_predict_post_normalized(struct motion_filter *filter,
+				    void *data,
+				    uint64_t time,
+				    struct filter_prediction *prediction)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *) filter;
+	struct device_float_coords delta;
+	double error;
+
+	/* Trackers are in device units, normalize afterwards */
+	if (!accelerator_predict_generic(accel,
+					 data,
+					 time,
+					 &delta,
+					 &error,
+					 &prediction->confidence))
+		return false;
+
+	prediction->delta = normalize_for_dpi(&delta, accel->dpi);
+	prediction->error = error * DEFAULT_MOUSE_DPI/accel->dpi;
+
+	return true;
+}
+
 static void
 accelerator_destroy(struct motion_filter *filter)
 {
@@ -941,6 +1159,7 @@ struct motion_filter_interface accelerator_interface = {
 	.filter = accelerator_filter_pre_normalized,
 	.filter_constant = accelerator_filter_noop,
 	.restart = accelerator_restart,
+	.predict = accelerator_predict,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
 };
@@ -988,6 +1207,7 @@ struct motion_filter_interface accelerator_interface_low_dpi = {
 	.filter = accelerator_filter_unnormalized,
 	.filter_constant = accelerator_filter_noop,
 	.restart = accelerator_restart,
+	.predict = accelerator_predict,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
 };
@@ -1012,6 +1232,7 @@ struct motion_filter_interface accelerator_interface_touchpad = {
 	.filter = accelerator_filter_post_normalized,
 	.filter_constant = touchpad_constant_filter,
 	.restart = accelerator_restart,
+	.predict = accelerator_predict_post_normalized,
 	.destroy = accelerator_destroy,
 	.set_speed = touchpad_accelerator_set_speed,
 };
@@ -1036,6 +1257,7 @@ struct motion_filter_interface accelerator_interface_x230 = {
 	.filter = accelerator_filter_x230,
 	.filter_constant = accelerator_filter_constant_x230,
 	.restart = accelerator_restart,
+	.predict = accelerator_predict,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
 };
@@ -1074,6 +1296,7 @@ struct motion_filter_interface accelerator_interface_trackpoint = {
 	.filter = accelerator_filter_unnormalized,
 	.filter_constant = accelerator_filter_noop,
 	.restart = accelerator_restart,
+	.predict = accelerator_predict,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
 };
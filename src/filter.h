@@ -86,6 +86,33 @@ void
 filter_restart(struct motion_filter *filter,
 	       void *data, uint64_t time);
 
+struct filter_prediction {
+	struct normalized_coords delta; /* accelerated */
+	double error; /* radius around delta */
+	double confidence; /* [0, 1] */
+};
+
+/**
+ * Predict the accelerated motion between the most recent delta passed to
+ * filter_dispatch() and the given time.
+ *
+ * Prediction is based on the recent velocity and acceleration. It stops
+ * after a direction change and when the given time is too far from the
+ * most recent delta.
+ *
+ * @param filter The device's motion filter
+ * @param data Custom data
+ * @param time The time to predict the motion for
+ * @param[out] prediction The predicted delta, in the same units as
+ * returned by filter_dispatch()
+ *
+ * @return true if a prediction is available, false otherwise
+ */
+bool
+filter_predict(struct motion_filter *filter,
+	       void *data, uint64_t time,
+	       struct filter_prediction *prediction);
+
 void
 filter_destroy(struct motion_filter *filter);
 
@@ -43,6 +43,7 @@
 #endif
 
 struct libinput_source;
+struct uring;
 
 /* A coordinate pair in device coordinates */
 struct device_coords {
@@ -107,10 +108,31 @@ struct libinput_interface_backend {
 				  const char *seat_name);
 };
 
+/* libinput_event_type values are sparse, grouped in hundreds with fewer
+ * than 8 types per group. Each group gets 8 bits in the event type masks,
+ * see event_type_to_bit() */
+#define EVENT_TYPE_BITS ((LIBINPUT_EVENT_RAW_FRAME / 100 + 1) * 8)
+
+/* Number of hash buckets of the per-context device index, a power of two */
+#define DEVICE_INDEX_BUCKETS 64
+
 struct libinput {
 	int epoll_fd;
 	struct list source_destroy_list;
 
+	/* io_uring backend, NULL if not available. Only the ring fd is in
+	 * the epoll set, sources added with libinput_add_read_fd() have
+	 * their reads queued on the ring, see libinput_uring_dispatch() */
+	struct uring *uring;
+	struct libinput_source *uring_source;
+	struct list source_read_list;
+
+	/* Sources that stopped reading because they ran out of their
+	 * per-round budget, see libinput_source_mark_pending() */
+	struct list source_pending_list;
+	unsigned int dispatch_budget;
+	uint32_t dispatch_round;
+
 	struct list seat_list;
 
 	struct {
@@ -127,6 +149,9 @@ struct libinput {
 
 	struct list tool_list;
 
+	/* see libinput_event_ring_new(), NULL if not exported */
+	struct libinput_event_ring *event_ring;
+
 	const struct libinput_interface *interface;
 	const struct libinput_interface_backend *interface_backend;
 
@@ -137,7 +162,35 @@ struct libinput {
 
 	struct list device_group_list;
 
+	/* evdev devices hashed by syspath, see evdev_device_find() */
+	struct list device_index[DEVICE_INDEX_BUCKETS];
+
 	uint64_t last_event_time;
+
+	/* Event types the caller declared it does not want */
+	unsigned char ignored_event_types[NCHARS(EVENT_TYPE_BITS)];
+
+	/* Post touchscreen frames as LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME */
+	bool touch_frame_aggregation;
+
+	/* Merge consecutive queued LIBINPUT_EVENT_TABLET_TOOL_AXIS events */
+	bool tablet_motion_coalescing;
+
+	/* Optional timestamp ordering stage, NULL if disabled */
+	struct event_order *event_order;
+	uint64_t event_reorder_count;
+
+	/* Motion and scroll held back for the next frame, NULL until
+	 * libinput_dispatch_coalesced() is first called */
+	struct frame_stage *frame_stage;
+
+	/* DMI modalias and devicetree model for the model quirk globs,
+	 * read on the first device, see evdev_model_quirks_lookup() */
+	struct {
+		bool initialized;
+		char *dmi_modalias;
+		char *dt_model;
+	} model_quirks;
 };
 
 typedef void (*libinput_seat_destroy_func) (struct libinput_seat *seat);
@@ -270,6 +323,17 @@ struct libinput_device_config_dwt {
 			 struct libinput_device *device);
 };
 
+struct libinput_device_config_raw {
+	int (*is_available)(struct libinput_device *device);
+	enum libinput_config_status (*set_enabled)(
+			 struct libinput_device *device,
+			 enum libinput_config_raw_state enable);
+	enum libinput_config_raw_state (*get_enabled)(
+			 struct libinput_device *device);
+	enum libinput_config_raw_state (*get_default_enabled)(
+			 struct libinput_device *device);
+};
+
 struct libinput_device_config_rotation {
 	int (*is_available)(struct libinput_device *device);
 	enum libinput_config_status (*set_angle)(
@@ -291,6 +355,7 @@ struct libinput_device_config {
 	struct libinput_device_config_middle_emulation *middle_emulation;
 	struct libinput_device_config_dwt *dwt;
 	struct libinput_device_config_rotation *rotation;
+	struct libinput_device_config_raw *raw;
 };
 
 struct libinput_device_group {
@@ -306,9 +371,12 @@ struct libinput_device {
 	struct libinput_device_group *group;
 	struct list link;
 	struct list event_listeners;
+	/* Union of the event_types of all event_listeners */
+	unsigned char listener_event_types[NCHARS(EVENT_TYPE_BITS)];
 	void *user_data;
 	int refcount;
 	struct libinput_device_config config;
+	uint32_t ring_id; /* id in the event ring, 0 until first published */
 };
 
 enum libinput_tablet_tool_axis {
@@ -337,6 +405,85 @@ struct tablet_axes {
 	int wheel_discrete;
 };
 
+/*
+ * Sparse storage for the scalar members of struct tablet_axes. Only axes
+ * with a nonzero value are stored, packed in the order below, a bit in
+ * the mask marks which ones are present. An axis that is not present is
+ * zero, so the full struct can be reconstructed from mask + values.
+ * point and delta are always present and stored separately.
+ */
+enum tablet_packed_axis {
+	TABLET_PACKED_DISTANCE = 0,
+	TABLET_PACKED_PRESSURE,
+	TABLET_PACKED_TILT_X,
+	TABLET_PACKED_TILT_Y,
+	TABLET_PACKED_ROTATION,
+	TABLET_PACKED_SLIDER,
+	TABLET_PACKED_WHEEL,
+	TABLET_PACKED_WHEEL_DISCRETE,
+
+	TABLET_PACKED_AXIS_COUNT,
+};
+
+static inline double
+tablet_axes_get_packable(const struct tablet_axes *axes,
+			 enum tablet_packed_axis which)
+{
+	switch (which) {
+	case TABLET_PACKED_DISTANCE:		return axes->distance;
+	case TABLET_PACKED_PRESSURE:		return axes->pressure;
+	case TABLET_PACKED_TILT_X:		return axes->tilt.x;
+	case TABLET_PACKED_TILT_Y:		return axes->tilt.y;
+	case TABLET_PACKED_ROTATION:		return axes->rotation;
+	case TABLET_PACKED_SLIDER:		return axes->slider;
+	case TABLET_PACKED_WHEEL:		return axes->wheel;
+	case TABLET_PACKED_WHEEL_DISCRETE:	return axes->wheel_discrete;
+	case TABLET_PACKED_AXIS_COUNT:
+		break;
+	}
+
+	return 0.0;
+}
+
+/**
+ * Pack the nonzero scalar axes into values, which must have space for
+ * TABLET_PACKED_AXIS_COUNT entries.
+ *
+ * @return the mask of stored axes, the number of values written is the
+ * popcount of the mask
+ */
+static inline uint16_t
+tablet_axes_pack(const struct tablet_axes *axes, double *values)
+{
+	uint16_t mask = 0;
+	int i, n = 0;
+
+	for (i = 0; i < TABLET_PACKED_AXIS_COUNT; i++) {
+		double v = tablet_axes_get_packable(axes, i);
+
+		if (v == 0.0)
+			continue;
+
+		mask |= 1 << i;
+		values[n++] = v;
+	}
+
+	return mask;
+}
+
+static inline double
+tablet_axes_packed_get(uint16_t mask,
+		       const double *values,
+		       enum tablet_packed_axis which)
+{
+	uint16_t bit = 1 << which;
+
+	if ((mask & bit) == 0)
+		return 0.0;
+
+	return values[__builtin_popcount(mask & (bit - 1))];
+}
+
 struct libinput_tablet_tool {
 	struct list link;
 	uint32_t serial;
@@ -379,12 +526,18 @@ struct libinput_event {
 
 struct libinput_event_listener {
 	struct list link;
+	struct libinput_device *device; /* NULL if not added */
+	/* Event types notify_func is called for, see event_type_to_bit() */
+	unsigned char event_types[NCHARS(EVENT_TYPE_BITS)];
 	void (*notify_func)(uint64_t time, struct libinput_event *ev, void *notify_func_data);
 	void *notify_func_data;
 };
 
 typedef void (*libinput_source_dispatch_t)(void *data);
 
+/* Called with the number of bytes read into buf or a negative errno */
+typedef void (*libinput_source_read_t)(void *data, void *buf, int res);
+
 #define log_debug(li_, ...) log_msg((li_), LIBINPUT_LOG_PRIORITY_DEBUG, __VA_ARGS__)
 #define log_info(li_, ...) log_msg((li_), LIBINPUT_LOG_PRIORITY_INFO, __VA_ARGS__)
 #define log_error(li_, ...) log_msg((li_), LIBINPUT_LOG_PRIORITY_ERROR, __VA_ARGS__)
@@ -431,10 +584,23 @@ libinput_add_fd(struct libinput *libinput,
 		libinput_source_dispatch_t dispatch,
 		void *data);
 
+struct libinput_source *
+libinput_add_read_fd(struct libinput *libinput,
+		     int fd,
+		     size_t record_size,
+		     size_t nrecords,
+		     libinput_source_dispatch_t dispatch,
+		     libinput_source_read_t read,
+		     void *data);
+
 void
 libinput_remove_source(struct libinput *libinput,
 		       struct libinput_source *source);
 
+void
+libinput_source_mark_pending(struct libinput *libinput,
+			     struct libinput_source *source);
+
 int
 open_restricted(struct libinput *libinput,
 		const char *path, int flags);
@@ -471,9 +637,15 @@ libinput_device_set_device_group(struct libinput_device *device,
 void
 libinput_device_init_event_listener(struct libinput_event_listener *listener);
 
+/**
+ * Add a listener that is notified of the device's events of the given
+ * types before they are queued. types is terminated by
+ * LIBINPUT_EVENT_NONE.
+ */
 void
 libinput_device_add_event_listener(struct libinput_device *device,
 				   struct libinput_event_listener *listener,
+				   const enum libinput_event_type *types,
 				   void (*notify_func)(
 						uint64_t time,
 						struct libinput_event *event,
@@ -518,7 +690,8 @@ pointer_notify_axis(struct libinput_device *device,
 		    uint32_t axes,
 		    enum libinput_pointer_axis_source source,
 		    const struct normalized_coords *delta,
-		    const struct discrete_coords *discrete);
+		    const struct discrete_coords *discrete,
+		    const struct normalized_coords *velocity);
 
 void
 touch_notify_touch_down(struct libinput_device *device,
@@ -544,6 +717,12 @@ void
 touch_notify_frame(struct libinput_device *device,
 		   uint64_t time);
 
+void
+touch_notify_aggregate_frame(struct libinput_device *device,
+			     uint64_t time,
+			     const struct libinput_touch_slot_change *changes,
+			     size_t nchanges);
+
 void
 gesture_notify_swipe(struct libinput_device *device,
 		     uint64_t time,
@@ -634,6 +813,32 @@ switch_notify_toggle(struct libinput_device *device,
 		     enum libinput_switch sw,
 		     enum libinput_switch_state state);
 
+/* Takes ownership of events, which must be allocated with malloc() */
+void
+raw_notify_frame(struct libinput_device *device,
+		 uint64_t time,
+		 struct input_event *events,
+		 size_t nevents);
+
+static inline unsigned int
+event_type_to_bit(enum libinput_event_type type)
+{
+	return (type / 100) * 8 + type % 100;
+}
+
+/**
+ * @return true if the caller consumes events of this type, see
+ * libinput_set_event_interest(). Pipeline stages whose output types are
+ * all unwanted may skip their processing.
+ */
+static inline bool
+libinput_wants_event_type(struct libinput *libinput,
+			  enum libinput_event_type type)
+{
+	return !bit_is_set(libinput->ignored_event_types,
+			   event_type_to_bit(type));
+}
+
 static inline uint64_t
 libinput_now(struct libinput *libinput)
 {
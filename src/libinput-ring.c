@@ -0,0 +1,572 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/memfd.h>
+
+#include "libinput.h"
+#include "libinput-private.h"
+#include "libinput-ring.h"
+
+/* Upper bound so a client bug can't have us allocate gigabytes */
+#define EVENT_RING_MAX_SLOTS (1 << 16)
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+static_assert(sizeof(struct libinput_ring_header) == 192,
+	      "ring header layout changed");
+static_assert(sizeof(struct libinput_ring_event) == 64,
+	      "ring event layout changed");
+
+struct libinput_event_ring {
+	struct libinput *libinput;
+	struct libinput_ring_header *header;
+	struct libinput_ring_event *slots;
+	size_t map_size;
+	uint64_t head;
+	uint32_t next_device_id;
+
+	/* Devices that existed when the ring was created, announced with a
+	 * DEVICE_ADDED slot before any queued event is published */
+	struct libinput_device **added;
+	size_t nadded;
+	size_t added_next;
+
+	int memfd;
+	int doorbell_fd;
+	int space_fd;
+};
+
+static inline int
+event_ring_memfd_create(const char *name)
+{
+	return syscall(__NR_memfd_create, name, MFD_CLOEXEC|MFD_ALLOW_SEALING);
+}
+
+static inline uint32_t
+event_ring_device_id(struct libinput_event_ring *ring,
+		     struct libinput_device *device)
+{
+	if (device->ring_id == 0)
+		device->ring_id = ++ring->next_device_id;
+
+	return device->ring_id;
+}
+
+static inline void
+event_ring_fill_device(struct libinput_ring_event *slot,
+		       struct libinput_device *device)
+{
+	enum libinput_device_capability cap;
+
+	for (cap = LIBINPUT_DEVICE_CAP_KEYBOARD;
+	     cap <= LIBINPUT_DEVICE_CAP_SWITCH;
+	     cap++) {
+		if (libinput_device_has_capability(device, cap))
+			slot->u.device.capabilities |= 1 << cap;
+	}
+
+	snprintf(slot->u.device.sysname,
+		 sizeof(slot->u.device.sysname),
+		 "%s",
+		 libinput_device_get_sysname(device));
+}
+
+static inline void
+event_ring_fill_device_added(struct libinput_event_ring *ring,
+			     struct libinput_ring_event *slot,
+			     struct libinput_device *device)
+{
+	memset(slot, 0, sizeof(*slot));
+	slot->type = LIBINPUT_EVENT_DEVICE_ADDED;
+	slot->device_id = event_ring_device_id(ring, device);
+	event_ring_fill_device(slot, device);
+}
+
+static inline void
+event_ring_fill_pointer(struct libinput_ring_event *slot,
+			struct libinput_event_pointer *p)
+{
+	enum libinput_pointer_axis axis;
+
+	slot->time_usec = libinput_event_pointer_get_time_usec(p);
+
+	switch (slot->type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		slot->u.motion.dx = libinput_event_pointer_get_dx(p);
+		slot->u.motion.dy = libinput_event_pointer_get_dy(p);
+		slot->u.motion.dx_unaccel = libinput_event_pointer_get_dx_unaccelerated(p);
+		slot->u.motion.dy_unaccel = libinput_event_pointer_get_dy_unaccelerated(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		slot->u.motion.x = libinput_event_pointer_get_absolute_x(p);
+		slot->u.motion.y = libinput_event_pointer_get_absolute_y(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+		slot->u.button.button = libinput_event_pointer_get_button(p);
+		slot->u.button.state = libinput_event_pointer_get_button_state(p);
+		slot->u.button.seat_button_count =
+			libinput_event_pointer_get_seat_button_count(p);
+		break;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		slot->u.axis.source = libinput_event_pointer_get_axis_source(p);
+		for (axis = LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL;
+		     axis <= LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL;
+		     axis++) {
+			if (!libinput_event_pointer_has_axis(p, axis))
+				continue;
+
+			slot->u.axis.axes |= 1 << axis;
+			slot->u.axis.value[axis] =
+				libinput_event_pointer_get_axis_value(p, axis);
+			slot->u.axis.value_discrete[axis] =
+				libinput_event_pointer_get_axis_value_discrete(p, axis);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static inline void
+event_ring_fill_touch(struct libinput_ring_event *slot,
+		      struct libinput_event_touch *t)
+{
+	slot->time_usec = libinput_event_touch_get_time_usec(t);
+
+	if (slot->type == LIBINPUT_EVENT_TOUCH_FRAME)
+		return;
+
+	slot->u.touch.slot = libinput_event_touch_get_slot(t);
+	slot->u.touch.seat_slot = libinput_event_touch_get_seat_slot(t);
+
+	if (slot->type == LIBINPUT_EVENT_TOUCH_DOWN ||
+	    slot->type == LIBINPUT_EVENT_TOUCH_MOTION) {
+		slot->u.touch.x = libinput_event_touch_get_x(t);
+		slot->u.touch.y = libinput_event_touch_get_y(t);
+	}
+}
+
+static inline void
+event_ring_fill_gesture(struct libinput_ring_event *slot,
+			struct libinput_event_gesture *g)
+{
+	slot->time_usec = libinput_event_gesture_get_time_usec(g);
+	slot->u.gesture.finger_count = libinput_event_gesture_get_finger_count(g);
+
+	switch (slot->type) {
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		slot->u.gesture.cancelled = libinput_event_gesture_get_cancelled(g);
+		break;
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+		slot->u.gesture.scale = libinput_event_gesture_get_scale(g);
+		slot->u.gesture.angle_delta = libinput_event_gesture_get_angle_delta(g);
+		/* fallthrough */
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+		slot->u.gesture.dx = libinput_event_gesture_get_dx(g);
+		slot->u.gesture.dy = libinput_event_gesture_get_dy(g);
+		slot->u.gesture.dx_unaccel = libinput_event_gesture_get_dx_unaccelerated(g);
+		slot->u.gesture.dy_unaccel = libinput_event_gesture_get_dy_unaccelerated(g);
+		break;
+	default:
+		break;
+	}
+}
+
+static inline void
+event_ring_fill_tablet_tool(struct libinput_ring_event *slot,
+			    struct libinput_event_tablet_tool *t)
+{
+	struct libinput_tablet_tool *tool = libinput_event_tablet_tool_get_tool(t);
+
+	slot->time_usec = libinput_event_tablet_tool_get_time_usec(t);
+	slot->u.tablet_tool.x = libinput_event_tablet_tool_get_x(t);
+	slot->u.tablet_tool.y = libinput_event_tablet_tool_get_y(t);
+	slot->u.tablet_tool.pressure = libinput_event_tablet_tool_get_pressure(t);
+	slot->u.tablet_tool.distance = libinput_event_tablet_tool_get_distance(t);
+	slot->u.tablet_tool.tilt_x = libinput_event_tablet_tool_get_tilt_x(t);
+	slot->u.tablet_tool.tilt_y = libinput_event_tablet_tool_get_tilt_y(t);
+	slot->u.tablet_tool.rotation = libinput_event_tablet_tool_get_rotation(t);
+	slot->u.tablet_tool.slider = libinput_event_tablet_tool_get_slider_position(t);
+	slot->u.tablet_tool.tool_type = libinput_tablet_tool_get_type(tool);
+	slot->u.tablet_tool.proximity_state =
+		libinput_event_tablet_tool_get_proximity_state(t);
+	slot->u.tablet_tool.tip_state = libinput_event_tablet_tool_get_tip_state(t);
+
+	if (slot->type == LIBINPUT_EVENT_TABLET_TOOL_BUTTON) {
+		slot->u.tablet_tool.button = libinput_event_tablet_tool_get_button(t);
+		slot->u.tablet_tool.button_state =
+			libinput_event_tablet_tool_get_button_state(t);
+	}
+}
+
+static inline void
+event_ring_fill_tablet_pad(struct libinput_ring_event *slot,
+			   struct libinput_event_tablet_pad *p)
+{
+	slot->time_usec = libinput_event_tablet_pad_get_time_usec(p);
+	slot->u.tablet_pad.mode = libinput_event_tablet_pad_get_mode(p);
+
+	switch (slot->type) {
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+		slot->u.tablet_pad.number = libinput_event_tablet_pad_get_button_number(p);
+		slot->u.tablet_pad.state = libinput_event_tablet_pad_get_button_state(p);
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+		slot->u.tablet_pad.number = libinput_event_tablet_pad_get_ring_number(p);
+		slot->u.tablet_pad.source = libinput_event_tablet_pad_get_ring_source(p);
+		slot->u.tablet_pad.position = libinput_event_tablet_pad_get_ring_position(p);
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		slot->u.tablet_pad.number = libinput_event_tablet_pad_get_strip_number(p);
+		slot->u.tablet_pad.source = libinput_event_tablet_pad_get_strip_source(p);
+		slot->u.tablet_pad.position = libinput_event_tablet_pad_get_strip_position(p);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Returns false for events that have no fixed-size representation */
+static bool
+event_ring_fill(struct libinput_event_ring *ring,
+		struct libinput_ring_event *slot,
+		struct libinput_event *event)
+{
+	struct libinput_device *device = libinput_event_get_device(event);
+	enum libinput_event_type type = libinput_event_get_type(event);
+	struct libinput_event_keyboard *k;
+	struct libinput_event_switch *sw;
+
+	/* A device with an id was already announced when the ring was
+	 * created, this is the original DEVICE_ADDED still in the queue */
+	if (type == LIBINPUT_EVENT_DEVICE_ADDED && device->ring_id != 0)
+		return false;
+
+	memset(slot, 0, sizeof(*slot));
+	slot->type = type;
+	slot->device_id = event_ring_device_id(ring, device);
+
+	switch (type) {
+	case LIBINPUT_EVENT_NONE:
+		abort();
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		event_ring_fill_device(slot, device);
+		break;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		k = libinput_event_get_keyboard_event(event);
+		slot->time_usec = libinput_event_keyboard_get_time_usec(k);
+		slot->u.keyboard.key = libinput_event_keyboard_get_key(k);
+		slot->u.keyboard.state = libinput_event_keyboard_get_key_state(k);
+		slot->u.keyboard.seat_key_count =
+			libinput_event_keyboard_get_seat_key_count(k);
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		event_ring_fill_pointer(slot,
+					libinput_event_get_pointer_event(event));
+		break;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		event_ring_fill_touch(slot,
+				      libinput_event_get_touch_event(event));
+		break;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		event_ring_fill_gesture(slot,
+					libinput_event_get_gesture_event(event));
+		break;
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+		event_ring_fill_tablet_tool(slot,
+					    libinput_event_get_tablet_tool_event(event));
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		event_ring_fill_tablet_pad(slot,
+					   libinput_event_get_tablet_pad_event(event));
+		break;
+	case LIBINPUT_EVENT_SWITCH_TOGGLE:
+		sw = libinput_event_get_switch_event(event);
+		slot->time_usec = libinput_event_switch_get_time_usec(sw);
+		slot->u.switch_toggle.sw = libinput_event_switch_get_switch(sw);
+		slot->u.switch_toggle.state = libinput_event_switch_get_switch_state(sw);
+		break;
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+	case LIBINPUT_EVENT_RAW_FRAME:
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+event_ring_snapshot_devices(struct libinput_event_ring *ring)
+{
+	struct libinput *libinput = ring->libinput;
+	struct libinput_seat *seat;
+	struct libinput_device *device;
+	size_t ndevices = 0;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link)
+			ndevices++;
+	}
+
+	if (ndevices == 0)
+		return true;
+
+	ring->added = zalloc(ndevices * sizeof(*ring->added));
+	if (!ring->added)
+		return false;
+
+	list_for_each(seat, &libinput->seat_list, link) {
+		list_for_each(device, &seat->devices_list, link)
+			ring->added[ring->nadded++] = libinput_device_ref(device);
+	}
+
+	return true;
+}
+
+LIBINPUT_EXPORT struct libinput_event_ring *
+libinput_event_ring_new(struct libinput *libinput, unsigned int nslots)
+{
+	struct libinput_event_ring *ring;
+	unsigned int n = 1;
+
+	if (libinput->event_ring) {
+		log_bug_client(libinput,
+			       "context already has an event ring\n");
+		return NULL;
+	}
+
+	if (nslots == 0 || nslots > EVENT_RING_MAX_SLOTS) {
+		log_bug_client(libinput,
+			       "invalid event ring size %u\n",
+			       nslots);
+		return NULL;
+	}
+
+	while (n < nslots)
+		n <<= 1;
+
+	ring = zalloc(sizeof *ring);
+	if (!ring)
+		return NULL;
+
+	ring->libinput = libinput;
+	ring->memfd = -1;
+	ring->doorbell_fd = -1;
+	ring->space_fd = -1;
+	ring->map_size = sizeof(*ring->header) + n * sizeof(*ring->slots);
+
+	ring->memfd = event_ring_memfd_create("libinput-events");
+	if (ring->memfd < 0)
+		goto err;
+
+	if (ftruncate(ring->memfd, ring->map_size) < 0)
+		goto err;
+
+	/* The reader maps whatever size the fd has, make sure that's the
+	 * size we're using */
+	if (fcntl(ring->memfd,
+		  F_ADD_SEALS,
+		  F_SEAL_SHRINK|F_SEAL_GROW|F_SEAL_SEAL) < 0)
+		goto err;
+
+	ring->header = mmap(NULL, ring->map_size,
+			    PROT_READ|PROT_WRITE, MAP_SHARED,
+			    ring->memfd, 0);
+	if (ring->header == MAP_FAILED) {
+		ring->header = NULL;
+		goto err;
+	}
+
+	ring->slots = (struct libinput_ring_event *)(ring->header + 1);
+	ring->header->magic = LIBINPUT_RING_MAGIC;
+	ring->header->version = LIBINPUT_RING_VERSION;
+	ring->header->nslots = n;
+	ring->header->slot_size = sizeof(*ring->slots);
+
+	ring->doorbell_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	ring->space_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	if (ring->doorbell_fd < 0 || ring->space_fd < 0)
+		goto err;
+
+	if (!event_ring_snapshot_devices(ring))
+		goto err;
+
+	libinput->event_ring = ring;
+
+	return ring;
+
+err:
+	log_error(libinput,
+		  "failed to create event ring: %s\n",
+		  strerror(errno));
+	libinput_event_ring_destroy(ring);
+	return NULL;
+}
+
+LIBINPUT_EXPORT void
+libinput_event_ring_destroy(struct libinput_event_ring *ring)
+{
+	struct libinput *libinput;
+	struct libinput_seat *seat;
+	struct libinput_device *device;
+
+	if (!ring)
+		return;
+
+	libinput = ring->libinput;
+	if (libinput->event_ring == ring) {
+		libinput->event_ring = NULL;
+
+		/* ids are per ring, the next ring numbers from 1 again */
+		list_for_each(seat, &libinput->seat_list, link) {
+			list_for_each(device, &seat->devices_list, link)
+				device->ring_id = 0;
+		}
+	}
+
+	while (ring->added_next < ring->nadded)
+		libinput_device_unref(ring->added[ring->added_next++]);
+	free(ring->added);
+
+	if (ring->header)
+		munmap(ring->header, ring->map_size);
+	if (ring->memfd != -1)
+		close(ring->memfd);
+	if (ring->doorbell_fd != -1)
+		close(ring->doorbell_fd);
+	if (ring->space_fd != -1)
+		close(ring->space_fd);
+	free(ring);
+}
+
+LIBINPUT_EXPORT int
+libinput_event_ring_get_memfd(struct libinput_event_ring *ring)
+{
+	return ring->memfd;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_ring_get_doorbell_fd(struct libinput_event_ring *ring)
+{
+	return ring->doorbell_fd;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_ring_get_space_fd(struct libinput_event_ring *ring)
+{
+	return ring->space_fd;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_ring_publish(struct libinput_event_ring *ring)
+{
+	struct libinput *libinput = ring->libinput;
+	struct libinput_ring_header *header = ring->header;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	uint64_t tail, count;
+	int published = 0;
+
+	/* Reset the space doorbell first, the reader rings it again if it
+	 * frees up slots after we looked */
+	while (read(ring->space_fd, &count, sizeof(count)) < 0 &&
+	       errno == EINTR)
+		;
+
+	tail = __atomic_load_n(&header->tail, __ATOMIC_ACQUIRE);
+
+	while (ring->added_next < ring->nadded &&
+	       ring->head - tail < header->nslots) {
+		device = ring->added[ring->added_next++];
+		event_ring_fill_device_added(ring,
+					     &ring->slots[ring->head & (header->nslots - 1)],
+					     device);
+		libinput_device_unref(device);
+		ring->head++;
+		published++;
+	}
+
+	while (ring->added_next == ring->nadded &&
+	       ring->head - tail < header->nslots) {
+		event = libinput_get_event(libinput);
+		if (!event)
+			break;
+
+		if (event_ring_fill(ring,
+				    &ring->slots[ring->head & (header->nslots - 1)],
+				    event)) {
+			ring->head++;
+			published++;
+		}
+
+		libinput_event_destroy(event);
+	}
+
+	if (published == 0)
+		return 0;
+
+	/* One store and one doorbell per batch */
+	__atomic_store_n(&header->head, ring->head, __ATOMIC_RELEASE);
+	count = 1;
+	while (write(ring->doorbell_fd, &count, sizeof(count)) < 0 &&
+	       errno == EINTR)
+		;
+
+	return published;
+}
@@ -0,0 +1,318 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LIBINPUT_RING_H
+#define LIBINPUT_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @defgroup ring Reading an exported event ring
+ *
+ * A libinput context can publish its events into a shared memory ring,
+ * see libinput_event_ring_new(). This header describes the binary layout
+ * of that ring and provides a reader for the other side. The reader is
+ * header-only and does not need libinput itself.
+ *
+ * The ring is a single-producer, single-consumer queue of fixed-size
+ * event records. The producer signals the doorbell fd whenever it
+ * published events, the consumer signals the space fd whenever it
+ * freed slots in a ring that was full.
+ */
+
+/**
+ * @ingroup ring
+ */
+#define LIBINPUT_RING_MAGIC 0x6c697267 /* "lirg" */
+
+/**
+ * @ingroup ring
+ *
+ * Bumped on any incompatible change to the layout below.
+ */
+#define LIBINPUT_RING_VERSION 1
+
+/**
+ * @ingroup ring
+ *
+ * The header at the start of the shared memory. The producer and the
+ * consumer index each live on their own cache line.
+ */
+struct libinput_ring_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nslots; /**< Number of slots, a power of two */
+	uint32_t slot_size; /**< sizeof(struct libinput_ring_event) */
+	uint8_t reserved0[48];
+
+	uint64_t head; /**< Written by the producer only */
+	uint8_t reserved1[56];
+
+	uint64_t tail; /**< Written by the consumer only */
+	uint8_t reserved2[56];
+};
+
+/**
+ * @ingroup ring
+ *
+ * One event, a single cache line. type is an enum libinput_event_type
+ * value, all other enums are stored as their libinput values too.
+ * Coordinates are in mm, as returned by the libinput getters that don't
+ * take a width or height. device_id is assigned by the producer on the
+ * first event of each device, the @ref LIBINPUT_EVENT_DEVICE_ADDED event
+ * carries the device's sysname and capabilities. Devices that exist when
+ * the ring is created get a DEVICE_ADDED event at the start of the ring.
+ */
+struct libinput_ring_event {
+	uint32_t type;
+	uint32_t device_id;
+	uint64_t time_usec;
+
+	/* Which member is valid depends on type */
+	union {
+		struct {
+			uint32_t capabilities; /**< 1 << enum libinput_device_capability */
+			char sysname[44];
+		} device;
+		struct {
+			uint32_t key;
+			uint32_t state;
+			uint32_t seat_key_count;
+		} keyboard;
+		struct {
+			double dx, dy;
+			double dx_unaccel, dy_unaccel;
+			double x, y; /**< absolute motion only */
+		} motion;
+		struct {
+			uint32_t button;
+			uint32_t state;
+			uint32_t seat_button_count;
+		} button;
+		struct {
+			uint32_t source;
+			uint32_t axes; /**< 1 << enum libinput_pointer_axis */
+			double value[2];
+			double value_discrete[2];
+		} axis;
+		struct {
+			int32_t slot;
+			int32_t seat_slot;
+			double x, y;
+		} touch;
+		struct {
+			int32_t finger_count;
+			int32_t cancelled;
+			float dx, dy;
+			float dx_unaccel, dy_unaccel;
+			double scale;
+			double angle_delta;
+		} gesture;
+		struct {
+			double x, y;
+			float pressure, distance;
+			float tilt_x, tilt_y;
+			float rotation, slider;
+			uint32_t button;
+			uint8_t tool_type;
+			uint8_t proximity_state;
+			uint8_t tip_state;
+			uint8_t button_state;
+		} tablet_tool;
+		struct {
+			uint32_t number; /**< button, ring or strip number */
+			uint32_t state; /**< button state */
+			uint32_t source; /**< ring or strip source */
+			uint32_t mode;
+			double position; /**< ring or strip position */
+		} tablet_pad;
+		struct {
+			uint32_t sw;
+			uint32_t state;
+		} switch_toggle;
+		uint8_t reserved[48];
+	} u;
+};
+
+/**
+ * @ingroup ring
+ */
+struct libinput_ring_reader {
+	struct libinput_ring_header *header;
+	struct libinput_ring_event *slots;
+	size_t map_size;
+	uint64_t tail;
+	int doorbell_fd;
+	int space_fd;
+};
+
+/**
+ * @ingroup ring
+ *
+ * Map the ring. The fds are the ones returned by
+ * libinput_event_ring_get_memfd(), libinput_event_ring_get_doorbell_fd()
+ * and libinput_event_ring_get_space_fd() of the producer, passed to this
+ * process e.g. with SCM_RIGHTS. The reader takes ownership of the fds.
+ *
+ * @return 0 on success or a negative errno
+ */
+static inline int
+libinput_ring_reader_init(struct libinput_ring_reader *reader,
+			  int memfd,
+			  int doorbell_fd,
+			  int space_fd)
+{
+	struct libinput_ring_header *header;
+	struct stat st;
+	size_t size;
+	void *map;
+
+	if (fstat(memfd, &st) < 0)
+		return -errno;
+	if ((size_t)st.st_size < sizeof(*header))
+		return -EINVAL;
+
+	map = mmap(NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_SHARED,
+		   memfd, 0);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	header = (struct libinput_ring_header *)map;
+	size = sizeof(*header) +
+	       (size_t)header->nslots * sizeof(struct libinput_ring_event);
+	if (header->magic != LIBINPUT_RING_MAGIC ||
+	    header->version != LIBINPUT_RING_VERSION ||
+	    header->slot_size != sizeof(struct libinput_ring_event) ||
+	    header->nslots == 0 ||
+	    (header->nslots & (header->nslots - 1)) != 0 ||
+	    size > (size_t)st.st_size) {
+		munmap(map, st.st_size);
+		return -EINVAL;
+	}
+
+	reader->header = header;
+	reader->slots = (struct libinput_ring_event *)(header + 1);
+	reader->map_size = st.st_size;
+	reader->tail = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+	reader->doorbell_fd = doorbell_fd;
+	reader->space_fd = space_fd;
+	close(memfd);
+
+	return 0;
+}
+
+/**
+ * @ingroup ring
+ */
+static inline void
+libinput_ring_reader_fini(struct libinput_ring_reader *reader)
+{
+	munmap(reader->header, reader->map_size);
+	close(reader->doorbell_fd);
+	close(reader->space_fd);
+}
+
+/**
+ * @ingroup ring
+ *
+ * The fd to poll for new events. Call libinput_ring_reader_ack() when it
+ * is readable, then read all events.
+ */
+static inline int
+libinput_ring_reader_get_fd(struct libinput_ring_reader *reader)
+{
+	return reader->doorbell_fd;
+}
+
+/**
+ * @ingroup ring
+ *
+ * Reset the doorbell. Do this before reading the events, not after, or
+ * a doorbell for events published in between gets lost.
+ */
+static inline void
+libinput_ring_reader_ack(struct libinput_ring_reader *reader)
+{
+	uint64_t count;
+
+	while (read(reader->doorbell_fd, &count, sizeof(count)) < 0 &&
+	       errno == EINTR)
+		;
+}
+
+/**
+ * @ingroup ring
+ *
+ * @return The next event or NULL if the ring is empty. The event stays
+ * valid until libinput_ring_reader_consume().
+ */
+static inline const struct libinput_ring_event *
+libinput_ring_reader_peek(struct libinput_ring_reader *reader)
+{
+	uint64_t head = __atomic_load_n(&reader->header->head,
+					__ATOMIC_ACQUIRE);
+
+	if (reader->tail == head)
+		return NULL;
+
+	return &reader->slots[reader->tail & (reader->header->nslots - 1)];
+}
+
+/**
+ * @ingroup ring
+ *
+ * Release the event returned by libinput_ring_reader_peek().
+ */
+static inline void
+libinput_ring_reader_consume(struct libinput_ring_reader *reader)
+{
+	uint64_t head = __atomic_load_n(&reader->header->head,
+					__ATOMIC_ACQUIRE);
+	bool was_full = head - reader->tail == reader->header->nslots;
+	uint64_t one = 1;
+
+	reader->tail++;
+	__atomic_store_n(&reader->header->tail, reader->tail,
+			 __ATOMIC_RELEASE);
+
+	if (was_full) {
+		while (write(reader->space_fd, &one, sizeof(one)) < 0 &&
+		       errno == EINTR)
+			;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* LIBINPUT_RING_H */
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LIBINPUT_TRACEPOINT_H
+#define LIBINPUT_TRACEPOINT_H
+
+#include "config.h"
+
+/*
+ * Static userspace tracepoints (USDT) in the "libinput" provider. Where
+ * sys/sdt.h is available each probe compiles into a nop plus an ELF note
+ * that perf, bpftrace and systemtap can attach to, e.g.
+ *
+ *	bpftrace -e 'usdt:/usr/lib64/libinput.so.10:libinput:event_post { ... }'
+ *
+ * Without sys/sdt.h the probes compile to nothing. Probe names and
+ * argument order are considered stable, test/tracepoints-test checks that
+ * all of them are present in the built library.
+ *
+ * Arguments must be integers or pointers, floating point arguments are
+ * not portable across sdt implementations.
+ */
+
+#if HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define LIBINPUT_PROBE(name_) \
+	DTRACE_PROBE(libinput, name_)
+#define LIBINPUT_PROBE1(name_, a1_) \
+	DTRACE_PROBE1(libinput, name_, a1_)
+#define LIBINPUT_PROBE2(name_, a1_, a2_) \
+	DTRACE_PROBE2(libinput, name_, a1_, a2_)
+#define LIBINPUT_PROBE3(name_, a1_, a2_, a3_) \
+	DTRACE_PROBE3(libinput, name_, a1_, a2_, a3_)
+#define LIBINPUT_PROBE4(name_, a1_, a2_, a3_, a4_) \
+	DTRACE_PROBE4(libinput, name_, a1_, a2_, a3_, a4_)
+#else
+#define LIBINPUT_PROBE(name_)
+#define LIBINPUT_PROBE1(name_, a1_)
+#define LIBINPUT_PROBE2(name_, a1_, a2_)
+#define LIBINPUT_PROBE3(name_, a1_, a2_, a3_)
+#define LIBINPUT_PROBE4(name_, a1_, a2_, a3_, a4_)
+#endif
+
+#endif /* LIBINPUT_TRACEPOINT_H */
@@ -37,6 +37,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "libinput-util.h"
 #include "libinput-private.h"
 
@@ -128,6 +134,194 @@ ratelimit_test(struct ratelimit *r)
 	return RATELIMIT_EXCEEDED;
 }
 
+/**
+ * Apply matrix_mult_vec() to count points stored as separate x and y
+ * arrays, in place.
+ *
+ * The vector paths use the same float operations in the same order as
+ * matrix_mult_vec() and truncate towards zero, so the result is identical
+ * to calling matrix_mult_vec() on each point.
+ */
+void
+matrix_mult_vec_batch(const struct matrix *m, int *x, int *y, size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128 m00 = _mm_set1_ps(m->val[0][0]),
+		     m01 = _mm_set1_ps(m->val[0][1]),
+		     m02 = _mm_set1_ps(m->val[0][2]),
+		     m10 = _mm_set1_ps(m->val[1][0]),
+		     m11 = _mm_set1_ps(m->val[1][1]),
+		     m12 = _mm_set1_ps(m->val[1][2]);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx = _mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)&x[i]));
+		__m128 vy = _mm_cvtepi32_ps(_mm_loadu_si128((__m128i*)&y[i]));
+		__m128 tx, ty;
+
+		tx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m00),
+					   _mm_mul_ps(vy, m01)),
+				m02);
+		ty = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, m10),
+					   _mm_mul_ps(vy, m11)),
+				m12);
+
+		_mm_storeu_si128((__m128i*)&x[i], _mm_cvttps_epi32(tx));
+		_mm_storeu_si128((__m128i*)&y[i], _mm_cvttps_epi32(ty));
+	}
+#elif defined(__ARM_NEON)
+	const float32x4_t m00 = vdupq_n_f32(m->val[0][0]),
+			  m01 = vdupq_n_f32(m->val[0][1]),
+			  m02 = vdupq_n_f32(m->val[0][2]),
+			  m10 = vdupq_n_f32(m->val[1][0]),
+			  m11 = vdupq_n_f32(m->val[1][1]),
+			  m12 = vdupq_n_f32(m->val[1][2]);
+
+	/* vmlaq_f32 may be fused, use separate multiply and add to
+	 * match the scalar rounding */
+	for (; i + 4 <= count; i += 4) {
+		float32x4_t vx = vcvtq_f32_s32(vld1q_s32(&x[i]));
+		float32x4_t vy = vcvtq_f32_s32(vld1q_s32(&y[i]));
+		float32x4_t tx, ty;
+
+		tx = vaddq_f32(vaddq_f32(vmulq_f32(vx, m00),
+					 vmulq_f32(vy, m01)),
+			       m02);
+		ty = vaddq_f32(vaddq_f32(vmulq_f32(vx, m10),
+					 vmulq_f32(vy, m11)),
+			       m12);
+
+		vst1q_s32(&x[i], vcvtq_s32_f32(tx));
+		vst1q_s32(&y[i], vcvtq_s32_f32(ty));
+	}
+#endif
+
+	for (; i < count; i++)
+		matrix_mult_vec(m, &x[i], &y[i]);
+}
+
+static inline int
+hysteresis(int in, int center, int margin)
+{
+	int diff = in - center;
+
+	if (diff > margin)
+		return in - margin;
+	else if (diff < -margin)
+		return in + margin;
+	else
+		return center;
+}
+
+/**
+ * Apply a hysteresis of margin_x/margin_y to count points stored as
+ * separate arrays, in place. Each point in x/y is replaced by the
+ * hysteresis output, its center is replaced by the original input.
+ * unchanged[i] is set to true if the hysteresis output for that point
+ * is the same as its input on both axes.
+ *
+ * The per-axis hysteresis is the same as evdev_hysteresis().
+ */
+void
+hysteresis_batch(int *x, int *y,
+		 int *center_x, int *center_y,
+		 int margin_x, int margin_y,
+		 bool *unchanged,
+		 size_t count)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	const __m128i mx = _mm_set1_epi32(margin_x),
+		      my = _mm_set1_epi32(margin_y),
+		      neg_mx = _mm_set1_epi32(-margin_x),
+		      neg_my = _mm_set1_epi32(-margin_y);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128i in_x = _mm_loadu_si128((__m128i*)&x[i]),
+			in_y = _mm_loadu_si128((__m128i*)&y[i]),
+			out_x = _mm_loadu_si128((__m128i*)&center_x[i]),
+			out_y = _mm_loadu_si128((__m128i*)&center_y[i]);
+		__m128i diff, mask, eq;
+		int bits, j;
+
+		/* out = center, replaced by in -/+ margin where the
+		 * difference exceeds the margin */
+		diff = _mm_sub_epi32(in_x, out_x);
+		mask = _mm_cmpgt_epi32(diff, mx);
+		out_x = _mm_or_si128(_mm_and_si128(mask, _mm_sub_epi32(in_x, mx)),
+				     _mm_andnot_si128(mask, out_x));
+		mask = _mm_cmplt_epi32(diff, neg_mx);
+		out_x = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(in_x, mx)),
+				     _mm_andnot_si128(mask, out_x));
+
+		diff = _mm_sub_epi32(in_y, out_y);
+		mask = _mm_cmpgt_epi32(diff, my);
+		out_y = _mm_or_si128(_mm_and_si128(mask, _mm_sub_epi32(in_y, my)),
+				     _mm_andnot_si128(mask, out_y));
+		mask = _mm_cmplt_epi32(diff, neg_my);
+		out_y = _mm_or_si128(_mm_and_si128(mask, _mm_add_epi32(in_y, my)),
+				     _mm_andnot_si128(mask, out_y));
+
+		eq = _mm_and_si128(_mm_cmpeq_epi32(out_x, in_x),
+				   _mm_cmpeq_epi32(out_y, in_y));
+		bits = _mm_movemask_ps(_mm_castsi128_ps(eq));
+		for (j = 0; j < 4; j++)
+			unchanged[i + j] = !!(bits & (1 << j));
+
+		_mm_storeu_si128((__m128i*)&center_x[i], in_x);
+		_mm_storeu_si128((__m128i*)&center_y[i], in_y);
+		_mm_storeu_si128((__m128i*)&x[i], out_x);
+		_mm_storeu_si128((__m128i*)&y[i], out_y);
+	}
+#elif defined(__ARM_NEON)
+	const int32x4_t mx = vdupq_n_s32(margin_x),
+			my = vdupq_n_s32(margin_y),
+			neg_mx = vdupq_n_s32(-margin_x),
+			neg_my = vdupq_n_s32(-margin_y);
+
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t in_x = vld1q_s32(&x[i]),
+			  in_y = vld1q_s32(&y[i]),
+			  out_x = vld1q_s32(&center_x[i]),
+			  out_y = vld1q_s32(&center_y[i]);
+		int32x4_t diff;
+		uint32x4_t eq;
+
+		diff = vsubq_s32(in_x, out_x);
+		out_x = vbslq_s32(vcgtq_s32(diff, mx), vsubq_s32(in_x, mx), out_x);
+		out_x = vbslq_s32(vcltq_s32(diff, neg_mx), vaddq_s32(in_x, mx), out_x);
+
+		diff = vsubq_s32(in_y, out_y);
+		out_y = vbslq_s32(vcgtq_s32(diff, my), vsubq_s32(in_y, my), out_y);
+		out_y = vbslq_s32(vcltq_s32(diff, neg_my), vaddq_s32(in_y, my), out_y);
+
+		eq = vandq_u32(vceqq_s32(out_x, in_x), vceqq_s32(out_y, in_y));
+		unchanged[i] = vgetq_lane_u32(eq, 0) != 0;
+		unchanged[i + 1] = vgetq_lane_u32(eq, 1) != 0;
+		unchanged[i + 2] = vgetq_lane_u32(eq, 2) != 0;
+		unchanged[i + 3] = vgetq_lane_u32(eq, 3) != 0;
+
+		vst1q_s32(&center_x[i], in_x);
+		vst1q_s32(&center_y[i], in_y);
+		vst1q_s32(&x[i], out_x);
+		vst1q_s32(&y[i], out_y);
+	}
+#endif
+
+	for (; i < count; i++) {
+		int in_x = x[i],
+		    in_y = y[i];
+
+		x[i] = hysteresis(in_x, center_x[i], margin_x);
+		y[i] = hysteresis(in_y, center_y[i], margin_y);
+		center_x[i] = in_x;
+		center_y[i] = in_y;
+		unchanged[i] = x[i] == in_x && y[i] == in_y;
+	}
+}
+
 /* Helper function to parse the mouse DPI tag from udev.
  * The tag is of the form:
  * MOUSE_DPI=400 *1000 2000
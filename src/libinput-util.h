@@ -139,6 +139,20 @@ zalloc(size_t size)
 	return calloc(1, size);
 }
 
+/* FNV-1a, good enough for hashing short keys like syspaths */
+static inline uint32_t
+strhash(const char *str)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*str) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
 /* This bitfield helper implementation is taken from from libevdev-util.h,
  * except that it has been modified to work with arrays of unsigned chars
  */
@@ -316,6 +330,16 @@ matrix_mult_vec(const struct matrix *m, int *x, int *y)
 	*y = ty;
 }
 
+void
+matrix_mult_vec_batch(const struct matrix *m, int *x, int *y, size_t count);
+
+void
+hysteresis_batch(int *x, int *y,
+		 int *center_x, int *center_y,
+		 int margin_x, int margin_y,
+		 bool *unchanged,
+		 size_t count);
+
 static inline void
 matrix_to_farray6(const struct matrix *m, float out[6])
 {
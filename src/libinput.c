@@ -35,13 +35,38 @@
 
 #include "libinput.h"
 #include "libinput-private.h"
+#include "libinput-tracepoint.h"
 #include "evdev.h"
 #include "timer.h"
+#include "uring.h"
+
+/* Number of evdev events read from one device before libinput_dispatch()
+ * moves on to the next device. A full 10-finger touchscreen frame is
+ * roughly 40 events */
+#define DEFAULT_DISPATCH_BUDGET 64
+
+/* Submission queue size of the io_uring backend. Each read source needs
+ * two entries (a poll and the linked read) but the ring is submitted
+ * whenever it fills up, so this doesn't limit the number of devices */
+#define URING_ENTRIES 128
+
+/* Upper bounds for the event ordering stage, see
+ * libinput_set_event_ordering_window() */
+#define EVENT_ORDER_MAX_WINDOW ms2us(100)
+#define EVENT_ORDER_MAX_EVENTS 64
+
+/* Deferred motion and scroll events are released this long before the
+ * frame deadline, see libinput_dispatch_coalesced() */
+#define FRAME_STAGE_LEAD_TIME ms2us(2)
+#define FRAME_STAGE_MAX_EVENTS 32
 
 #define require_event_type(li_, type_, retval_, ...)	\
 	if (type_ == LIBINPUT_EVENT_NONE) abort(); \
-	if (!check_event_type(li_, __func__, type_, __VA_ARGS__, -1)) \
+	if (!check_event_type(type_, \
+			      (const unsigned int[]){ __VA_ARGS__, -1U })) { \
+		log_invalid_event_type(li_, __func__, type_); \
 		return retval_; \
+	} \
 
 #define ASSERT_INT_SIZE(type_) \
 	static_assert(sizeof(type_) == sizeof(unsigned int), \
@@ -74,35 +99,29 @@ ASSERT_INT_SIZE(enum libinput_config_middle_emulation_state);
 ASSERT_INT_SIZE(enum libinput_config_scroll_method);
 ASSERT_INT_SIZE(enum libinput_config_dwt_state);
 
+/* types_permitted is a -1U terminated compound literal built by
+ * require_event_type(). Once inlined, the compiler reduces this to a
+ * few compares, unlike the va_arg loop it replaces. */
 static inline bool
-check_event_type(struct libinput *libinput,
-		 const char *function_name,
-		 unsigned int type_in,
-		 ...)
+check_event_type(unsigned int type_in,
+		 const unsigned int *types_permitted)
 {
-	bool rc = false;
-	va_list args;
-	unsigned int type_permitted;
-
-	va_start(args, type_in);
-	type_permitted = va_arg(args, unsigned int);
-
-	while (type_permitted != (unsigned int)-1) {
-		if (type_permitted == type_in) {
-			rc = true;
-			break;
-		}
-		type_permitted = va_arg(args, unsigned int);
+	for (; *types_permitted != -1U; types_permitted++) {
+		if (*types_permitted == type_in)
+			return true;
 	}
 
-	va_end(args);
-
-	if (!rc)
-		log_bug_client(libinput,
-			       "Invalid event type %d passed to %s()\n",
-			       type_in, function_name);
+	return false;
+}
 
-	return rc;
+static void
+log_invalid_event_type(struct libinput *libinput,
+		       const char *function_name,
+		       unsigned int type_in)
+{
+	log_bug_client(libinput,
+		       "Invalid event type %d passed to %s()\n",
+		       type_in, function_name);
 }
 
 static inline const char *
@@ -121,6 +140,7 @@ event_type_to_str(enum libinput_event_type type)
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TOUCH_MOTION);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TOUCH_CANCEL);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TOUCH_FRAME);
+	CASE_RETURN_STRING(LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TABLET_TOOL_AXIS);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_TABLET_TOOL_TIP);
@@ -135,6 +155,7 @@ event_type_to_str(enum libinput_event_type type)
 	CASE_RETURN_STRING(LIBINPUT_EVENT_GESTURE_PINCH_UPDATE);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_GESTURE_PINCH_END);
 	CASE_RETURN_STRING(LIBINPUT_EVENT_SWITCH_TOGGLE);
+	CASE_RETURN_STRING(LIBINPUT_EVENT_RAW_FRAME);
 	case LIBINPUT_EVENT_NONE:
 		abort();
 	}
@@ -147,6 +168,54 @@ struct libinput_source {
 	void *user_data;
 	int fd;
 	struct list link;
+
+	bool pending;
+	uint32_t pending_round;
+	struct list pending_link;
+
+	/* Sources added with libinput_add_read_fd() on the io_uring
+	 * backend */
+	libinput_source_read_t read_func;
+	struct libinput_source_read *read;
+};
+
+/* The buffer of a queued read. It outlives its source until the kernel
+ * gave it back, i.e. until the read completed or got canceled. */
+struct libinput_source_read {
+	struct libinput_source *source; /* NULL once the source is removed */
+	struct list link; /* libinput->source_read_list */
+	bool queued;
+	size_t record_size;
+	size_t nrecords;
+	char buf[];
+};
+
+struct event_order_entry {
+	uint64_t time;
+	struct libinput_event *event;
+};
+
+/* Staging buffer that holds device events for up to window us and
+ * releases them sorted by kernel timestamp. Events of the same device
+ * never overtake each other, only events of different devices are
+ * reordered. */
+struct event_order {
+	uint64_t window;
+	struct libinput_timer timer;
+
+	size_t count;
+	struct event_order_entry entries[EVENT_ORDER_MAX_EVENTS];
+};
+
+/* Staging buffer for pointer motion and scroll events that are deferred
+ * until shortly before the caller's next frame deadline. Consecutive
+ * events of the same type from one device are merged into one. */
+struct frame_stage {
+	uint64_t deadline; /* 0 if not dispatching for a frame */
+	struct libinput_timer timer;
+
+	size_t count;
+	struct libinput_event *events[FRAME_STAGE_MAX_EVENTS];
 };
 
 struct libinput_event_device_notify {
@@ -168,6 +237,7 @@ struct libinput_event_pointer {
 	struct device_float_coords delta_raw;
 	struct device_coords absolute;
 	struct discrete_coords discrete;
+	struct normalized_coords velocity; /* scroll stop events only */
 	uint32_t button;
 	uint32_t seat_button_count;
 	enum libinput_button_state state;
@@ -181,6 +251,11 @@ struct libinput_event_touch {
 	int32_t slot;
 	int32_t seat_slot;
 	struct device_coords point;
+
+	/* LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME only, points to the
+	 * memory allocated past the end of this struct */
+	unsigned int nchanges;
+	struct libinput_touch_slot_change *changes;
 };
 
 struct libinput_event_gesture {
@@ -200,11 +275,19 @@ struct libinput_event_tablet_tool {
 	enum libinput_button_state state;
 	uint32_t seat_button_count;
 	uint64_t time;
-	struct tablet_axes axes;
 	unsigned char changed_axes[NCHARS(LIBINPUT_TABLET_TOOL_AXIS_MAX + 1)];
 	struct libinput_tablet_tool *tool;
 	enum libinput_tablet_tool_proximity_state proximity_state;
 	enum libinput_tablet_tool_tip_state tip_state;
+	/* Coalesced axis events, oldest first */
+	struct libinput_tablet_tool_sample *samples;
+	unsigned int nsamples;
+	unsigned int samples_size;
+	struct device_coords point;
+	struct normalized_coords delta;
+	/* Remaining axes, see tablet_axes_pack() */
+	uint16_t axis_mask;
+	double axis_values[];
 };
 
 struct libinput_event_tablet_pad {
@@ -235,6 +318,13 @@ struct libinput_event_switch {
 	enum libinput_switch_state state;
 };
 
+struct libinput_event_raw {
+	struct libinput_event base;
+	uint64_t time;
+	size_t nevents;
+	struct input_event *events;
+};
+
 LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
 static void
 libinput_default_log_func(struct libinput *libinput,
@@ -382,7 +472,8 @@ libinput_event_get_touch_event(struct libinput_event *event)
 			   LIBINPUT_EVENT_TOUCH_UP,
 			   LIBINPUT_EVENT_TOUCH_MOTION,
 			   LIBINPUT_EVENT_TOUCH_CANCEL,
-			   LIBINPUT_EVENT_TOUCH_FRAME);
+			   LIBINPUT_EVENT_TOUCH_FRAME,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
 	return (struct libinput_event_touch *) event;
 }
 
@@ -452,6 +543,17 @@ libinput_event_get_switch_event(struct libinput_event *event)
 	return (struct libinput_event_switch *) event;
 }
 
+LIBINPUT_EXPORT struct libinput_event_raw *
+libinput_event_get_raw_event(struct libinput_event *event)
+{
+	require_event_type(libinput_event_get_context(event),
+			   event->type,
+			   NULL,
+			   LIBINPUT_EVENT_RAW_FRAME);
+
+	return (struct libinput_event_raw *) event;
+}
+
 LIBINPUT_EXPORT uint32_t
 libinput_event_keyboard_get_time(struct libinput_event_keyboard *event)
 {
@@ -718,6 +820,34 @@ libinput_event_pointer_get_axis_value(struct libinput_event_pointer *event,
 	return value;
 }
 
+LIBINPUT_EXPORT double
+libinput_event_pointer_get_axis_velocity(struct libinput_event_pointer *event,
+					 enum libinput_pointer_axis axis)
+{
+	struct libinput *libinput = event->base.device->seat->libinput;
+	double velocity = 0;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0.0,
+			   LIBINPUT_EVENT_POINTER_AXIS);
+
+	if (!libinput_event_pointer_has_axis(event, axis)) {
+		log_bug_client(libinput, "velocity requested for unset axis\n");
+	} else {
+		switch (axis) {
+		case LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL:
+			velocity = event->velocity.x;
+			break;
+		case LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL:
+			velocity = event->velocity.y;
+			break;
+		}
+	}
+
+	return velocity;
+}
+
 LIBINPUT_EXPORT double
 libinput_event_pointer_get_axis_value_discrete(struct libinput_event_pointer *event,
 					       enum libinput_pointer_axis axis)
@@ -766,7 +896,8 @@ libinput_event_touch_get_time(struct libinput_event_touch *event)
 			   LIBINPUT_EVENT_TOUCH_UP,
 			   LIBINPUT_EVENT_TOUCH_MOTION,
 			   LIBINPUT_EVENT_TOUCH_CANCEL,
-			   LIBINPUT_EVENT_TOUCH_FRAME);
+			   LIBINPUT_EVENT_TOUCH_FRAME,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
 
 	return us2ms(event->time);
 }
@@ -781,7 +912,8 @@ libinput_event_touch_get_time_usec(struct libinput_event_touch *event)
 			   LIBINPUT_EVENT_TOUCH_UP,
 			   LIBINPUT_EVENT_TOUCH_MOTION,
 			   LIBINPUT_EVENT_TOUCH_CANCEL,
-			   LIBINPUT_EVENT_TOUCH_FRAME);
+			   LIBINPUT_EVENT_TOUCH_FRAME,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
 
 	return event->time;
 }
@@ -858,6 +990,28 @@ libinput_event_touch_get_y_transformed(struct libinput_event_touch *event,
 	return evdev_device_transform_y(device, event->point.y, height);
 }
 
+LIBINPUT_EXPORT unsigned int
+libinput_event_touch_get_slot_change_count(struct libinput_event_touch *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
+
+	return event->nchanges;
+}
+
+LIBINPUT_EXPORT const struct libinput_touch_slot_change *
+libinput_event_touch_get_slot_changes(struct libinput_event_touch *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   NULL,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
+
+	return event->changes;
+}
+
 LIBINPUT_EXPORT double
 libinput_event_touch_get_y(struct libinput_event_touch *event)
 {
@@ -1024,6 +1178,15 @@ libinput_event_gesture_get_angle_delta(struct libinput_event_gesture *event)
 	return event->angle;
 }
 
+static inline double
+tablet_tool_event_get_axis(const struct libinput_event_tablet_tool *event,
+			   enum tablet_packed_axis which)
+{
+	return tablet_axes_packed_get(event->axis_mask,
+				      event->axis_values,
+				      which);
+}
+
 LIBINPUT_EXPORT int
 libinput_event_tablet_tool_x_has_changed(
 				struct libinput_event_tablet_tool *event)
@@ -1182,7 +1345,7 @@ libinput_event_tablet_tool_get_x(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
 	return evdev_convert_to_mm(device->abs.absinfo_x,
-				   event->axes.point.x);
+				   event->point.x);
 }
 
 LIBINPUT_EXPORT double
@@ -1198,7 +1361,7 @@ libinput_event_tablet_tool_get_y(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
 	return evdev_convert_to_mm(device->abs.absinfo_y,
-				   event->axes.point.y);
+				   event->point.y);
 }
 
 LIBINPUT_EXPORT double
@@ -1211,7 +1374,7 @@ libinput_event_tablet_tool_get_dx(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.delta.x;
+	return event->delta.x;
 }
 
 LIBINPUT_EXPORT double
@@ -1224,7 +1387,7 @@ libinput_event_tablet_tool_get_dy(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.delta.y;
+	return event->delta.y;
 }
 
 LIBINPUT_EXPORT double
@@ -1237,7 +1400,8 @@ libinput_event_tablet_tool_get_pressure(struct libinput_event_tablet_tool *event
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.pressure;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_PRESSURE);
 }
 
 LIBINPUT_EXPORT double
@@ -1250,7 +1414,8 @@ libinput_event_tablet_tool_get_distance(struct libinput_event_tablet_tool *event
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.distance;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_DISTANCE);
 }
 
 LIBINPUT_EXPORT double
@@ -1263,7 +1428,8 @@ libinput_event_tablet_tool_get_tilt_x(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.tilt.x;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_TILT_X);
 }
 
 LIBINPUT_EXPORT double
@@ -1276,7 +1442,8 @@ libinput_event_tablet_tool_get_tilt_y(struct libinput_event_tablet_tool *event)
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.tilt.y;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_TILT_Y);
 }
 
 LIBINPUT_EXPORT double
@@ -1289,7 +1456,8 @@ libinput_event_tablet_tool_get_rotation(struct libinput_event_tablet_tool *event
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.rotation;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_ROTATION);
 }
 
 LIBINPUT_EXPORT double
@@ -1302,7 +1470,8 @@ libinput_event_tablet_tool_get_slider_position(struct libinput_event_tablet_tool
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.slider;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_SLIDER);
 }
 
 LIBINPUT_EXPORT double
@@ -1315,7 +1484,8 @@ libinput_event_tablet_tool_get_wheel_delta(struct libinput_event_tablet_tool *ev
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.wheel;
+	return tablet_tool_event_get_axis(event,
+					  TABLET_PACKED_WHEEL);
 }
 
 LIBINPUT_EXPORT int
@@ -1329,7 +1499,8 @@ libinput_event_tablet_tool_get_wheel_delta_discrete(
 			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
-	return event->axes.wheel_discrete;
+	return (int)tablet_tool_event_get_axis(event,
+					       TABLET_PACKED_WHEEL_DISCRETE);
 }
 
 LIBINPUT_EXPORT double
@@ -1347,7 +1518,7 @@ libinput_event_tablet_tool_get_x_transformed(struct libinput_event_tablet_tool *
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
 	return evdev_device_transform_x(device,
-					event->axes.point.x,
+					event->point.x,
 					width);
 }
 
@@ -1366,7 +1537,7 @@ libinput_event_tablet_tool_get_y_transformed(struct libinput_event_tablet_tool *
 			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 
 	return evdev_device_transform_y(device,
-					event->axes.point.y,
+					event->point.y,
 					height);
 }
 
@@ -1440,6 +1611,34 @@ libinput_event_tablet_tool_get_time_usec(struct libinput_event_tablet_tool *even
 	return event->time;
 }
 
+LIBINPUT_EXPORT unsigned int
+libinput_event_tablet_tool_get_sample_count(struct libinput_event_tablet_tool *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TABLET_TOOL_AXIS,
+			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
+			   LIBINPUT_EVENT_TABLET_TOOL_BUTTON,
+			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
+
+	return event->nsamples;
+}
+
+LIBINPUT_EXPORT const struct libinput_tablet_tool_sample *
+libinput_event_tablet_tool_get_samples(struct libinput_event_tablet_tool *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   NULL,
+			   LIBINPUT_EVENT_TABLET_TOOL_AXIS,
+			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
+			   LIBINPUT_EVENT_TABLET_TOOL_BUTTON,
+			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
+
+	return event->samples;
+}
+
 LIBINPUT_EXPORT uint32_t
 libinput_event_tablet_tool_get_button(struct libinput_event_tablet_tool *event)
 {
@@ -1638,6 +1837,44 @@ libinput_event_switch_get_time_usec(struct libinput_event_switch *event)
 	return event->time;
 }
 
+LIBINPUT_EXPORT const struct input_event *
+libinput_event_raw_get_events(struct libinput_event_raw *event,
+			      size_t *nevents)
+{
+	*nevents = 0;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   NULL,
+			   LIBINPUT_EVENT_RAW_FRAME);
+
+	*nevents = event->nevents;
+
+	return event->events;
+}
+
+LIBINPUT_EXPORT struct libinput_event *
+libinput_event_raw_get_base_event(struct libinput_event_raw *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   NULL,
+			   LIBINPUT_EVENT_RAW_FRAME);
+
+	return &event->base;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_event_raw_get_time_usec(struct libinput_event_raw *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_RAW_FRAME);
+
+	return event->time;
+}
+
 struct libinput_source *
 libinput_add_fd(struct libinput *libinput,
 		int fd,
@@ -1667,13 +1904,232 @@ libinput_add_fd(struct libinput *libinput,
 	return source;
 }
 
+static inline bool
+libinput_source_queue_read(struct libinput *libinput,
+			   struct libinput_source_read *read)
+{
+	size_t nrecords = read->nrecords;
+
+	/* One read per source and pass, so the budget caps the read */
+	if (libinput->dispatch_budget != 0)
+		nrecords = min(nrecords, libinput->dispatch_budget);
+
+	read->queued = uring_queue_read(libinput->uring,
+					read->source->fd,
+					read->buf,
+					nrecords * read->record_size,
+					(uintptr_t)read);
+	return read->queued;
+}
+
+/**
+ * Like libinput_add_fd() but on the io_uring backend, the read is done
+ * by the kernel and the read function is called with up to nrecords
+ * records of record_size bytes each, fewer if the dispatch budget is
+ * lower. Without io_uring this is the same as libinput_add_fd() and the
+ * read function is never called.
+ */
+struct libinput_source *
+libinput_add_read_fd(struct libinput *libinput,
+		     int fd,
+		     size_t record_size,
+		     size_t nrecords,
+		     libinput_source_dispatch_t dispatch,
+		     libinput_source_read_t read_func,
+		     void *user_data)
+{
+	struct libinput_source *source;
+	struct libinput_source_read *read;
+
+	if (!libinput->uring)
+		return libinput_add_fd(libinput, fd, dispatch, user_data);
+
+	source = zalloc(sizeof *source);
+	if (!source)
+		return NULL;
+
+	read = zalloc(sizeof *read + record_size * nrecords);
+	if (!read) {
+		free(source);
+		return NULL;
+	}
+
+	source->dispatch = dispatch;
+	source->user_data = user_data;
+	source->fd = fd;
+	source->read_func = read_func;
+	source->read = read;
+	read->source = source;
+	read->record_size = record_size;
+	read->nrecords = nrecords;
+
+	if (!libinput_source_queue_read(libinput, read)) {
+		free(read);
+		free(source);
+		return NULL;
+	}
+
+	list_insert(&libinput->source_read_list, &read->link);
+	uring_submit(libinput->uring, 0);
+
+	return source;
+}
+
 void
 libinput_remove_source(struct libinput *libinput,
 		       struct libinput_source *source)
 {
-	epoll_ctl(libinput->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
+	if (source->read) {
+		/* A read that isn't queued is the one whose completion
+		 * we're handling right now, libinput_uring_dispatch()
+		 * frees it */
+		source->read->source = NULL;
+		if (source->read->queued) {
+			uring_queue_cancel(libinput->uring,
+					   (uintptr_t)source->read);
+			uring_submit(libinput->uring, 0);
+		}
+		source->read = NULL;
+	} else {
+		epoll_ctl(libinput->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
+	}
 	source->fd = -1;
 	list_insert(&libinput->source_destroy_list, &source->link);
+
+	if (source->pending) {
+		list_remove(&source->pending_link);
+		source->pending = false;
+	}
+}
+
+/**
+ * Called by a source's dispatch function when it stopped reading because
+ * it used up its budget for this dispatch round. The source is dispatched
+ * again in the next round even if its fd is not readable (the data may be
+ * buffered in userspace already, e.g. in libevdev).
+ */
+void
+libinput_source_mark_pending(struct libinput *libinput,
+			     struct libinput_source *source)
+{
+	if (source->pending)
+		return;
+
+	source->pending = true;
+	source->pending_round = libinput->dispatch_round;
+	list_insert(&libinput->source_pending_list, &source->pending_link);
+}
+
+static void
+libinput_drop_destroyed_sources(struct libinput *libinput)
+{
+	struct libinput_source *source, *next;
+
+	list_for_each_safe(source, next, &libinput->source_destroy_list, link)
+		free(source);
+	list_init(&libinput->source_destroy_list);
+}
+
+static void
+libinput_uring_dispatch(void *data)
+{
+	struct libinput *libinput = data;
+	struct libinput_source_read *read;
+	struct libinput_source *source;
+	unsigned int budget = libinput->dispatch_budget;
+	unsigned int ncompletions = 0;
+	uint64_t user_data;
+	int res;
+	bool harvested;
+
+	/* Re-queued reads of fds that still have data complete right away
+	 * on submit, keep going until a pass comes back empty. Every
+	 * source gets one buffer's worth of data per pass. Like a device
+	 * source, we stop after dispatch_budget completions and leave the
+	 * rest for the next round so timers and other sources get their
+	 * turn. */
+	do {
+		harvested = false;
+
+		while (uring_next_completion(libinput->uring,
+					     &user_data,
+					     &res)) {
+			read = (struct libinput_source_read *)(uintptr_t)user_data;
+			read->queued = false;
+			harvested = true;
+
+			source = read->source;
+			if (source)
+				source->read_func(source->user_data,
+						  read->buf,
+						  res);
+
+			/* The source may be removed in the read func */
+			if (!read->source) {
+				list_remove(&read->link);
+				free(read);
+				continue;
+			}
+
+			if (!libinput_source_queue_read(libinput, read))
+				log_bug_libinput(libinput,
+						 "failed to queue read on fd %d\n",
+						 read->source->fd);
+
+			if (budget != 0 && ++ncompletions == budget) {
+				uring_submit(libinput->uring, 0);
+				libinput_source_mark_pending(libinput,
+							     libinput->uring_source);
+				return;
+			}
+		}
+
+		if (harvested)
+			uring_submit(libinput->uring, 0);
+	} while (harvested);
+}
+
+static void
+libinput_uring_init(struct libinput *libinput)
+{
+	libinput->uring = uring_new(URING_ENTRIES);
+	if (!libinput->uring)
+		return;
+
+	libinput->uring_source = libinput_add_fd(libinput,
+						 uring_get_fd(libinput->uring),
+						 libinput_uring_dispatch,
+						 libinput);
+	if (!libinput->uring_source) {
+		uring_destroy(libinput->uring);
+		libinput->uring = NULL;
+	}
+}
+
+static void
+libinput_uring_destroy(struct libinput *libinput)
+{
+	struct libinput_source_read *read, *tmp;
+	int rc;
+
+	if (!libinput->uring)
+		return;
+
+	/* All sources are removed by now but the kernel may still write
+	 * into the buffers of canceled reads until it completes them */
+	while (!list_empty(&libinput->source_read_list)) {
+		rc = uring_submit(libinput->uring, 1);
+		if (rc < 0 && rc != -EINTR)
+			break;
+		libinput_uring_dispatch(libinput);
+	}
+
+	libinput_remove_source(libinput, libinput->uring_source);
+	uring_destroy(libinput->uring);
+	libinput->uring = NULL;
+
+	list_for_each_safe(read, tmp, &libinput->source_read_list, link)
+		free(read);
 }
 
 int
@@ -1682,6 +2138,8 @@ libinput_init(struct libinput *libinput,
 	      const struct libinput_interface_backend *interface_backend,
 	      void *user_data)
 {
+	size_t i;
+
 	assert(interface->open_restricted != NULL);
 	assert(interface->close_restricted != NULL);
 
@@ -1703,9 +2161,14 @@ libinput_init(struct libinput *libinput,
 	libinput->user_data = user_data;
 	libinput->refcount = 1;
 	list_init(&libinput->source_destroy_list);
+	list_init(&libinput->source_pending_list);
+	list_init(&libinput->source_read_list);
+	libinput->dispatch_budget = DEFAULT_DISPATCH_BUDGET;
 	list_init(&libinput->seat_list);
 	list_init(&libinput->device_group_list);
 	list_init(&libinput->tool_list);
+	for (i = 0; i < ARRAY_LENGTH(libinput->device_index); i++)
+		list_init(&libinput->device_index[i]);
 
 	if (libinput_timer_subsys_init(libinput) != 0) {
 		free(libinput->events);
@@ -1723,14 +2186,17 @@ static void
 libinput_seat_destroy(struct libinput_seat *seat);
 
 static void
-libinput_drop_destroyed_sources(struct libinput *libinput)
-{
-	struct libinput_source *source, *next;
+event_order_release(struct libinput *libinput, uint64_t now);
 
-	list_for_each_safe(source, next, &libinput->source_destroy_list, link)
-		free(source);
-	list_init(&libinput->source_destroy_list);
-}
+static void
+event_order_destroy(struct libinput *libinput);
+
+static void
+frame_stage_release(struct libinput *libinput,
+		    struct libinput_device *device);
+
+static void
+frame_stage_destroy(struct libinput *libinput);
 
 LIBINPUT_EXPORT struct libinput *
 libinput_ref(struct libinput *libinput)
@@ -1760,6 +2226,11 @@ libinput_unref(struct libinput *libinput)
 
 	libinput->interface_backend->destroy(libinput);
 
+	libinput_event_ring_destroy(libinput->event_ring);
+
+	frame_stage_destroy(libinput);
+	event_order_destroy(libinput);
+
 	while ((event = libinput_get_event(libinput)))
 	       libinput_event_destroy(event);
 
@@ -1786,8 +2257,11 @@ libinput_unref(struct libinput *libinput)
 	}
 
 	libinput_timer_subsys_destroy(libinput);
+	libinput_uring_destroy(libinput);
 	libinput_drop_destroyed_sources(libinput);
 	close(libinput->epoll_fd);
+	free(libinput->model_quirks.dmi_modalias);
+	free(libinput->model_quirks.dt_model);
 	free(libinput);
 
 	return NULL;
@@ -1797,6 +2271,7 @@ static void
 libinput_event_tablet_tool_destroy(struct libinput_event_tablet_tool *event)
 {
 	libinput_tablet_tool_unref(event->tool);
+	free(event->samples);
 }
 
 static void
@@ -1811,6 +2286,8 @@ libinput_event_destroy(struct libinput_event *event)
 	if (event == NULL)
 		return;
 
+	LIBINPUT_PROBE2(event_destroy, event, event->type);
+
 	switch(event->type) {
 	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
 	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
@@ -1825,6 +2302,9 @@ libinput_event_destroy(struct libinput_event *event)
 		libinput_event_tablet_pad_destroy(
 		   libinput_event_get_tablet_pad_event(event));
 		break;
+	case LIBINPUT_EVENT_RAW_FRAME:
+		free(libinput_event_get_raw_event(event)->events);
+		break;
 	default:
 		break;
 	}
@@ -1977,54 +2457,193 @@ libinput_get_fd(struct libinput *libinput)
 	return libinput->epoll_fd;
 }
 
-LIBINPUT_EXPORT int
-libinput_dispatch(struct libinput *libinput)
+static inline void
+libinput_source_dispatch(struct libinput_source *source)
+{
+	if (source->pending) {
+		list_remove(&source->pending_link);
+		source->pending = false;
+	}
+
+	source->dispatch(source->user_data);
+}
+
+static int
+libinput_dispatch_sources(struct libinput *libinput)
 {
 	struct libinput_source *source;
+	struct list requeue;
 	struct epoll_event ep[32];
 	int i, count;
 
-	count = epoll_wait(libinput->epoll_fd, ep, ARRAY_LENGTH(ep), 0);
-	if (count < 0)
-		return -errno;
+	/* Each round gives every ready source one go. A device source reads
+	 * at most dispatch_budget events per round, a source that ran out
+	 * of budget marks itself pending and we keep doing rounds until
+	 * nothing is pending. This way a chatty device only delays the
+	 * others by one budget's worth of events. */
+	do {
+		libinput->dispatch_round++;
 
-	for (i = 0; i < count; ++i) {
-		source = ep[i].data.ptr;
-		if (source->fd == -1)
-			continue;
+		count = epoll_wait(libinput->epoll_fd, ep, ARRAY_LENGTH(ep), 0);
+		if (count < 0)
+			return -errno;
 
-		source->dispatch(source->user_data);
-	}
+		for (i = 0; i < count; ++i) {
+			source = ep[i].data.ptr;
+			if (source->fd == -1)
+				continue;
 
-	libinput_drop_destroyed_sources(libinput);
+			libinput_source_dispatch(source);
+		}
+
+		/* Pending sources whose fd wasn't readable and thus weren't
+		 * dispatched above. A source's dispatch may remove any
+		 * other source from the list, so always take the head.
+		 * Sources marked pending in this round are set aside and
+		 * put back for the next round. */
+		list_init(&requeue);
+		while (!list_empty(&libinput->source_pending_list)) {
+			source = list_first_entry(&libinput->source_pending_list,
+						  source,
+						  pending_link);
+			if (source->pending_round == libinput->dispatch_round) {
+				list_remove(&source->pending_link);
+				list_insert(&requeue, &source->pending_link);
+				continue;
+			}
+
+			libinput_source_dispatch(source);
+		}
+
+		while (!list_empty(&requeue)) {
+			source = list_first_entry(&requeue,
+						  source,
+						  pending_link);
+			list_remove(&source->pending_link);
+			list_insert(&libinput->source_pending_list,
+				    &source->pending_link);
+		}
+
+		libinput_drop_destroyed_sources(libinput);
+	} while (!list_empty(&libinput->source_pending_list));
+
+	if (libinput->frame_stage && libinput->frame_stage->count > 0 &&
+	    libinput_now(libinput) + FRAME_STAGE_LEAD_TIME >=
+			libinput->frame_stage->deadline)
+		frame_stage_release(libinput, NULL);
+
+	if (libinput->event_order)
+		event_order_release(libinput, libinput_now(libinput));
 
 	return 0;
 }
 
-void
-libinput_device_init_event_listener(struct libinput_event_listener *listener)
+LIBINPUT_EXPORT int
+libinput_dispatch(struct libinput *libinput)
 {
-	list_init(&listener->link);
+	struct frame_stage *stage = libinput->frame_stage;
+
+	/* A plain dispatch ends frame mode */
+	if (stage) {
+		stage->deadline = 0;
+		frame_stage_release(libinput, NULL);
+	}
+
+	return libinput_dispatch_sources(libinput);
 }
 
-void
+static void
+frame_stage_timer_func(uint64_t now, void *data)
+{
+	struct libinput *libinput = data;
+
+	frame_stage_release(libinput, NULL);
+}
+
+LIBINPUT_EXPORT int
+libinput_dispatch_coalesced(struct libinput *libinput,
+			    uint64_t deadline_usec)
+{
+	struct frame_stage *stage = libinput->frame_stage;
+
+	if (!stage) {
+		stage = zalloc(sizeof *stage);
+		if (!stage)
+			return -ENOMEM;
+
+		libinput_timer_init(&stage->timer,
+				    libinput,
+				    frame_stage_timer_func,
+				    libinput);
+		libinput->frame_stage = stage;
+	}
+
+	/* A new deadline means the previous frame is done, whatever was
+	 * held back for it goes out now */
+	if (stage->deadline != deadline_usec) {
+		frame_stage_release(libinput, NULL);
+		stage->deadline = deadline_usec;
+	}
+
+	return libinput_dispatch_sources(libinput);
+}
+
+void
+libinput_device_init_event_listener(struct libinput_event_listener *listener)
+{
+	list_init(&listener->link);
+	listener->device = NULL;
+	memset(listener->event_types, 0, sizeof(listener->event_types));
+}
+
+static void
+device_update_listener_event_types(struct libinput_device *device)
+{
+	struct libinput_event_listener *listener;
+	size_t i;
+
+	memset(device->listener_event_types,
+	       0,
+	       sizeof(device->listener_event_types));
+
+	list_for_each(listener, &device->event_listeners, link) {
+		for (i = 0; i < ARRAY_LENGTH(listener->event_types); i++)
+			device->listener_event_types[i] |=
+				listener->event_types[i];
+	}
+}
+
+void
 libinput_device_add_event_listener(struct libinput_device *device,
 				   struct libinput_event_listener *listener,
+				   const enum libinput_event_type *types,
 				   void (*notify_func)(
 						uint64_t time,
 						struct libinput_event *event,
 						void *notify_func_data),
 				   void *notify_func_data)
 {
+	memset(listener->event_types, 0, sizeof(listener->event_types));
+	for (; *types != LIBINPUT_EVENT_NONE; types++)
+		set_bit(listener->event_types, event_type_to_bit(*types));
+
+	listener->device = device;
 	listener->notify_func = notify_func;
 	listener->notify_func_data = notify_func_data;
 	list_insert(&device->event_listeners, &listener->link);
+
+	device_update_listener_event_types(device);
 }
 
 void
 libinput_device_remove_event_listener(struct libinput_event_listener *listener)
 {
 	list_remove(&listener->link);
+
+	if (listener->device) {
+		device_update_listener_event_types(listener->device);
+		listener->device = NULL;
+	}
 }
 
 static uint32_t
@@ -2078,12 +2697,311 @@ init_event_base(struct libinput_event *event,
 	event->device = device;
 }
 
+static void
+event_order_release(struct libinput *libinput, uint64_t now)
+{
+	struct event_order *order = libinput->event_order;
+	size_t i;
+
+	if (!order || order->count == 0)
+		return;
+
+	for (i = 0; i < order->count; i++) {
+		if (order->entries[i].time + order->window > now)
+			break;
+
+		libinput_post_event(libinput, order->entries[i].event);
+	}
+
+	order->count -= i;
+	memmove(&order->entries[0],
+		&order->entries[i],
+		order->count * sizeof(order->entries[0]));
+
+	if (order->count > 0)
+		libinput_timer_set_flags(&order->timer,
+					 order->entries[0].time + order->window,
+					 TIMER_FLAG_ALLOW_NEGATIVE);
+	else
+		libinput_timer_cancel(&order->timer);
+}
+
+static inline void
+event_order_flush(struct libinput *libinput)
+{
+	event_order_release(libinput, UINT64_MAX);
+}
+
+static void
+event_order_timer_func(uint64_t now, void *data)
+{
+	struct libinput *libinput = data;
+
+	event_order_release(libinput, now);
+}
+
+static void
+event_order_queue(struct libinput *libinput,
+		  uint64_t time,
+		  struct libinput_event *event)
+{
+	struct event_order *order = libinput->event_order;
+	struct event_order_entry *prev;
+	size_t pos;
+
+	/* Full, release the oldest event early */
+	if (order->count == ARRAY_LENGTH(order->entries))
+		event_order_release(libinput, order->entries[0].time +
+					      order->window);
+
+	/* Walk back past newer events from other devices, but never past
+	 * an event from the same device */
+	pos = order->count;
+	while (pos > 0) {
+		prev = &order->entries[pos - 1];
+		if (prev->time <= time || prev->event->device == event->device)
+			break;
+		pos--;
+	}
+
+	if (pos < order->count) {
+		memmove(&order->entries[pos + 1],
+			&order->entries[pos],
+			(order->count - pos) * sizeof(order->entries[0]));
+		libinput->event_reorder_count++;
+	}
+
+	order->entries[pos].time = time;
+	order->entries[pos].event = event;
+	order->count++;
+
+	if (pos == 0)
+		libinput_timer_set_flags(&order->timer,
+					 time + order->window,
+					 TIMER_FLAG_ALLOW_NEGATIVE);
+}
+
+static void
+event_order_destroy(struct libinput *libinput)
+{
+	struct event_order *order = libinput->event_order;
+
+	if (!order)
+		return;
+
+	event_order_flush(libinput);
+	libinput_timer_cancel(&order->timer);
+	free(order);
+	libinput->event_order = NULL;
+}
+
+static inline void
+queue_device_event(struct libinput *libinput,
+		   uint64_t time,
+		   struct libinput_event *event)
+{
+	if (libinput->event_order)
+		event_order_queue(libinput, time, event);
+	else
+		libinput_post_event(libinput, event);
+}
+
+static inline bool
+frame_stage_can_defer(enum libinput_event_type type)
+{
+	switch (type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline bool
+axis_event_is_stop(struct libinput_event_pointer *event)
+{
+	if ((event->axes & AS_MASK(LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL)) &&
+	    event->delta.y == 0.0)
+		return true;
+	if ((event->axes & AS_MASK(LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL)) &&
+	    event->delta.x == 0.0)
+		return true;
+
+	return false;
+}
+
+/**
+ * Merge event into the staged event prev of the same device. On success,
+ * event can be discarded.
+ */
+static bool
+frame_stage_merge(struct libinput_event *prev_base,
+		  struct libinput_event *event_base)
+{
+	struct libinput_event_pointer *prev, *event;
+
+	if (prev_base->type != event_base->type)
+		return false;
+
+	prev = (struct libinput_event_pointer *)prev_base;
+	event = (struct libinput_event_pointer *)event_base;
+
+	switch (event_base->type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		prev->delta.x += event->delta.x;
+		prev->delta.y += event->delta.y;
+		prev->delta_raw.x += event->delta_raw.x;
+		prev->delta_raw.y += event->delta_raw.y;
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		prev->absolute = event->absolute;
+		break;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		/* Scroll stop events terminate a sequence and carry the
+		 * velocity, never merge them */
+		if (prev->source != event->source ||
+		    prev->axes != event->axes ||
+		    axis_event_is_stop(prev) ||
+		    axis_event_is_stop(event))
+			return false;
+
+		prev->delta.x += event->delta.x;
+		prev->delta.y += event->delta.y;
+		prev->discrete.x += event->discrete.x;
+		prev->discrete.y += event->discrete.y;
+		break;
+	default:
+		return false;
+	}
+
+	prev->time = event->time;
+
+	return true;
+}
+
+/**
+ * Release the staged events of the given device, or of all devices if
+ * device is NULL, in the order they were staged.
+ */
+static void
+frame_stage_release(struct libinput *libinput,
+		    struct libinput_device *device)
+{
+	struct frame_stage *stage = libinput->frame_stage;
+	struct libinput_event *event;
+	size_t i, remaining = 0;
+
+	if (!stage || stage->count == 0)
+		return;
+
+	for (i = 0; i < stage->count; i++) {
+		event = stage->events[i];
+		if (device && event->device != device) {
+			stage->events[remaining++] = event;
+			continue;
+		}
+
+		queue_device_event(libinput,
+				   ((struct libinput_event_pointer *)event)->time,
+				   event);
+	}
+
+	stage->count = remaining;
+	if (stage->count == 0)
+		libinput_timer_cancel(&stage->timer);
+}
+
+/**
+ * Hold back the event until shortly before the frame deadline.
+ *
+ * @return true if the event was staged or merged into a staged event,
+ * false if the caller must queue it
+ */
+static bool
+frame_stage_defer(struct libinput *libinput,
+		  uint64_t time,
+		  struct libinput_event *event)
+{
+	struct frame_stage *stage = libinput->frame_stage;
+	struct libinput_event *prev;
+	size_t i;
+
+	if (!stage || stage->deadline == 0)
+		return false;
+
+	/* Anything else goes out immediately, but must not overtake the
+	 * device's staged events. Same if the deadline is too close to
+	 * hold back anything. */
+	if (!frame_stage_can_defer(event->type) ||
+	    time + FRAME_STAGE_LEAD_TIME >= stage->deadline) {
+		frame_stage_release(libinput, event->device);
+		return false;
+	}
+
+	/* Only the device's most recent staged event may absorb this one,
+	 * otherwise we'd reorder motion and scroll */
+	for (i = stage->count; i > 0; i--) {
+		prev = stage->events[i - 1];
+		if (prev->device != event->device)
+			continue;
+
+		if (frame_stage_merge(prev, event)) {
+			/* libinput_event_destroy() drops the device
+			 * reference libinput_post_event() would have
+			 * taken */
+			libinput_device_ref(event->device);
+			libinput_event_destroy(event);
+			return true;
+		}
+		break;
+	}
+
+	if (stage->count == ARRAY_LENGTH(stage->events))
+		frame_stage_release(libinput, NULL);
+
+	stage->events[stage->count++] = event;
+	if (stage->count == 1)
+		libinput_timer_set_flags(&stage->timer,
+					 stage->deadline - FRAME_STAGE_LEAD_TIME,
+					 TIMER_FLAG_ALLOW_NEGATIVE);
+
+	return true;
+}
+
+static void
+frame_stage_destroy(struct libinput *libinput)
+{
+	struct frame_stage *stage = libinput->frame_stage;
+
+	if (!stage)
+		return;
+
+	frame_stage_release(libinput, NULL);
+	libinput_timer_cancel(&stage->timer);
+	free(stage);
+	libinput->frame_stage = NULL;
+}
+
+static inline bool
+device_wants_event(struct libinput_device *device,
+		   enum libinput_event_type type)
+{
+	/* Internal listeners (e.g. disable-while-typing) need the event
+	 * even if the caller doesn't */
+	return libinput_wants_event_type(device->seat->libinput, type) ||
+	       bit_is_set(device->listener_event_types,
+			  event_type_to_bit(type));
+}
+
 static void
 post_base_event(struct libinput_device *device,
 		enum libinput_event_type type,
 		struct libinput_event *event)
 {
 	struct libinput *libinput = device->seat->libinput;
+
 	init_event_base(event, device, type);
 	libinput_post_event(libinput, event);
 }
@@ -2094,10 +3012,10 @@ post_device_event(struct libinput_device *device,
 		  enum libinput_event_type type,
 		  struct libinput_event *event)
 {
+	struct libinput *libinput = device->seat->libinput;
 	struct libinput_event_listener *listener, *tmp;
+	unsigned int bit = event_type_to_bit(type);
 #if 0
-	struct libinput *libinput = device->seat->libinput;
-
 	if (libinput->last_event_time > time) {
 		log_bug_libinput(device->seat->libinput,
 				 "out-of-order timestamps for %s time %" PRIu64 "\n",
@@ -2109,17 +3027,43 @@ post_device_event(struct libinput_device *device,
 
 	init_event_base(event, device, type);
 
-	list_for_each_safe(listener, tmp, &device->event_listeners, link)
-		listener->notify_func(time, event, listener->notify_func_data);
+	if (bit_is_set(device->listener_event_types, bit)) {
+		list_for_each_safe(listener, tmp,
+				   &device->event_listeners, link) {
+			if (!bit_is_set(listener->event_types, bit))
+				continue;
 
-	libinput_post_event(device->seat->libinput, event);
+			listener->notify_func(time,
+					      event,
+					      listener->notify_func_data);
+		}
+	}
+
+	if (!libinput_wants_event_type(libinput, type)) {
+		/* Only allocated for the internal listeners.
+		 * libinput_event_destroy() drops the device reference
+		 * libinput_post_event() would have taken */
+		libinput_device_ref(device);
+		libinput_event_destroy(event);
+	} else if (!frame_stage_defer(libinput, time, event)) {
+		queue_device_event(libinput, time, event);
+	}
 }
 
 void
 notify_added_device(struct libinput_device *device)
 {
+	struct libinput *libinput = device->seat->libinput;
 	struct libinput_event_device_notify *added_device_event;
 
+	/* Device added/removed events must not overtake or trail the
+	 * device's own events */
+	frame_stage_release(libinput, NULL);
+	event_order_flush(libinput);
+
+	if (!libinput_wants_event_type(libinput, LIBINPUT_EVENT_DEVICE_ADDED))
+		return;
+
 	added_device_event = zalloc(sizeof *added_device_event);
 	if (!added_device_event)
 		return;
@@ -2132,8 +3076,17 @@ notify_added_device(struct libinput_device *device)
 void
 notify_removed_device(struct libinput_device *device)
 {
+	struct libinput *libinput = device->seat->libinput;
 	struct libinput_event_device_notify *removed_device_event;
 
+	/* Device added/removed events must not overtake or trail the
+	 * device's own events */
+	frame_stage_release(libinput, NULL);
+	event_order_flush(libinput);
+
+	if (!libinput_wants_event_type(libinput, LIBINPUT_EVENT_DEVICE_REMOVED))
+		return;
+
 	removed_device_event = zalloc(sizeof *removed_device_event);
 	if (!removed_device_event)
 		return;
@@ -2196,12 +3149,15 @@ keyboard_notify_key(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_KEYBOARD))
 		return;
 
+	seat_key_count = update_seat_key_count(device->seat, key, state);
+
+	if (!device_wants_event(device, LIBINPUT_EVENT_KEYBOARD_KEY))
+		return;
+
 	key_event = zalloc(sizeof *key_event);
 	if (!key_event)
 		return;
 
-	seat_key_count = update_seat_key_count(device->seat, key, state);
-
 	*key_event = (struct libinput_event_keyboard) {
 		.time = time,
 		.key = key,
@@ -2225,6 +3181,9 @@ pointer_notify_motion(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_POINTER_MOTION))
+		return;
+
 	motion_event = zalloc(sizeof *motion_event);
 	if (!motion_event)
 		return;
@@ -2250,6 +3209,9 @@ pointer_notify_motion_absolute(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE))
+		return;
+
 	motion_absolute_event = zalloc(sizeof *motion_absolute_event);
 	if (!motion_absolute_event)
 		return;
@@ -2276,14 +3238,17 @@ pointer_notify_button(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	button_event = zalloc(sizeof *button_event);
-	if (!button_event)
-		return;
-
 	seat_button_count = update_seat_button_count(device->seat,
 						     button,
 						     state);
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_POINTER_BUTTON))
+		return;
+
+	button_event = zalloc(sizeof *button_event);
+	if (!button_event)
+		return;
+
 	*button_event = (struct libinput_event_pointer) {
 		.time = time,
 		.button = button,
@@ -2302,13 +3267,18 @@ pointer_notify_axis(struct libinput_device *device,
 		    uint32_t axes,
 		    enum libinput_pointer_axis_source source,
 		    const struct normalized_coords *delta,
-		    const struct discrete_coords *discrete)
+		    const struct discrete_coords *discrete,
+		    const struct normalized_coords *velocity)
 {
+	const struct normalized_coords zero = { 0.0, 0.0 };
 	struct libinput_event_pointer *axis_event;
 
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_POINTER_AXIS))
+		return;
+
 	axis_event = zalloc(sizeof *axis_event);
 	if (!axis_event)
 		return;
@@ -2319,6 +3289,7 @@ pointer_notify_axis(struct libinput_device *device,
 		.source = source,
 		.axes = axes,
 		.discrete = *discrete,
+		.velocity = velocity ? *velocity : zero,
 	};
 
 	post_device_event(device, time,
@@ -2338,6 +3309,9 @@ touch_notify_touch_down(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TOUCH_DOWN))
+		return;
+
 	touch_event = zalloc(sizeof *touch_event);
 	if (!touch_event)
 		return;
@@ -2366,6 +3340,9 @@ touch_notify_touch_motion(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TOUCH_MOTION))
+		return;
+
 	touch_event = zalloc(sizeof *touch_event);
 	if (!touch_event)
 		return;
@@ -2393,6 +3370,9 @@ touch_notify_touch_up(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TOUCH_UP))
+		return;
+
 	touch_event = zalloc(sizeof *touch_event);
 	if (!touch_event)
 		return;
@@ -2417,6 +3397,9 @@ touch_notify_frame(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TOUCH_FRAME))
+		return;
+
 	touch_event = zalloc(sizeof *touch_event);
 	if (!touch_event)
 		return;
@@ -2430,6 +3413,148 @@ touch_notify_frame(struct libinput_device *device,
 			  &touch_event->base);
 }
 
+void
+touch_notify_aggregate_frame(struct libinput_device *device,
+			     uint64_t time,
+			     const struct libinput_touch_slot_change *changes,
+			     size_t nchanges)
+{
+	struct libinput_event_touch *touch_event;
+	size_t size = nchanges * sizeof(*changes);
+
+	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
+		return;
+
+	if (!device_wants_event(device, LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME))
+		return;
+
+	/* One allocation for the event and its slot changes */
+	touch_event = zalloc(sizeof *touch_event + size);
+	if (!touch_event)
+		return;
+
+	*touch_event = (struct libinput_event_touch) {
+		.time = time,
+		.nchanges = nchanges,
+		.changes = (struct libinput_touch_slot_change *)(touch_event + 1),
+	};
+	memcpy(touch_event->changes, changes, size);
+
+	post_device_event(device, time,
+			  LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME,
+			  &touch_event->base);
+}
+
+/**
+ * Allocate a tablet tool event with the axes in packed form. Only the
+ * nonzero scalar axes are stored, so the allocation size depends on the
+ * tool and its current state.
+ */
+static struct libinput_event_tablet_tool *
+tablet_tool_event_new(uint64_t time,
+		      struct libinput_tablet_tool *tool,
+		      const unsigned char *changed_axes,
+		      const struct tablet_axes *axes)
+{
+	struct libinput_event_tablet_tool *event;
+	double values[TABLET_PACKED_AXIS_COUNT];
+	uint16_t mask;
+	size_t nvalues;
+
+	mask = tablet_axes_pack(axes, values);
+	nvalues = __builtin_popcount(mask);
+
+	event = zalloc(sizeof *event + nvalues * sizeof(*values));
+	if (!event)
+		return NULL;
+
+	event->time = time;
+	event->tool = libinput_tablet_tool_ref(tool);
+	event->point = axes->point;
+	event->delta = axes->delta;
+	event->axis_mask = mask;
+	memcpy(event->axis_values, values, nvalues * sizeof(*values));
+	if (changed_axes)
+		memcpy(event->changed_axes,
+		       changed_axes,
+		       sizeof(event->changed_axes));
+
+	return event;
+}
+
+/**
+ * Merge the queued axis event prev into event, which is about to be
+ * queued. On success, prev's state is appended to event's samples and
+ * prev can be discarded.
+ */
+static bool
+tablet_tool_event_coalesce(struct libinput_event *prev_base,
+			   struct libinput_event *event_base)
+{
+	struct libinput_event_tablet_tool *prev, *event;
+	struct libinput_tablet_tool_sample *samples;
+	struct evdev_device *device;
+	size_t i;
+
+	if (prev_base->type != LIBINPUT_EVENT_TABLET_TOOL_AXIS ||
+	    event_base->type != LIBINPUT_EVENT_TABLET_TOOL_AXIS ||
+	    prev_base->device != event_base->device)
+		return false;
+
+	prev = (struct libinput_event_tablet_tool *)prev_base;
+	event = (struct libinput_event_tablet_tool *)event_base;
+
+	if (prev->tool != event->tool ||
+	    prev->tip_state != event->tip_state)
+		return false;
+
+	/* Wheel deltas are not state, merging them would lose clicks */
+	if (bit_is_set(prev->changed_axes, LIBINPUT_TABLET_TOOL_AXIS_REL_WHEEL) ||
+	    bit_is_set(event->changed_axes, LIBINPUT_TABLET_TOOL_AXIS_REL_WHEEL))
+		return false;
+
+	/* Grow geometrically, a burst merges one sample at a time */
+	samples = prev->samples;
+	if (prev->nsamples == prev->samples_size) {
+		unsigned int size = max(prev->samples_size * 2, 8U);
+
+		samples = realloc(prev->samples, size * sizeof(*samples));
+		if (!samples)
+			return false;
+		prev->samples = samples;
+		prev->samples_size = size;
+	}
+
+	device = evdev_device(prev_base->device);
+	samples[prev->nsamples] = (struct libinput_tablet_tool_sample) {
+		.time_usec = prev->time,
+		.x = evdev_convert_to_mm(device->abs.absinfo_x,
+					 prev->point.x),
+		.y = evdev_convert_to_mm(device->abs.absinfo_y,
+					 prev->point.y),
+		.pressure = tablet_tool_event_get_axis(prev,
+						       TABLET_PACKED_PRESSURE),
+		.tilt_x = tablet_tool_event_get_axis(prev,
+						     TABLET_PACKED_TILT_X),
+		.tilt_y = tablet_tool_event_get_axis(prev,
+						     TABLET_PACKED_TILT_Y),
+	};
+
+	event->samples = samples;
+	event->nsamples = prev->nsamples + 1;
+	event->samples_size = prev->samples_size;
+	prev->samples = NULL;
+	prev->nsamples = 0;
+	prev->samples_size = 0;
+
+	event->delta.x += prev->delta.x;
+	event->delta.y += prev->delta.y;
+	for (i = 0; i < sizeof(event->changed_axes); i++)
+		event->changed_axes[i] |= prev->changed_axes[i];
+
+	return true;
+}
+
 void
 tablet_notify_axis(struct libinput_device *device,
 		   uint64_t time,
@@ -2440,21 +3565,15 @@ tablet_notify_axis(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *axis_event;
 
-	axis_event = zalloc(sizeof *axis_event);
-	if (!axis_event)
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_TOOL_AXIS))
 		return;
 
-	*axis_event = (struct libinput_event_tablet_tool) {
-		.time = time,
-		.tool = libinput_tablet_tool_ref(tool),
-		.proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN,
-		.tip_state = tip_state,
-		.axes = *axes,
-	};
+	axis_event = tablet_tool_event_new(time, tool, changed_axes, axes);
+	if (!axis_event)
+		return;
 
-	memcpy(axis_event->changed_axes,
-	       changed_axes,
-	       sizeof(axis_event->changed_axes));
+	axis_event->proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN;
+	axis_event->tip_state = tip_state;
 
 	post_device_event(device,
 			  time,
@@ -2472,20 +3591,18 @@ tablet_notify_proximity(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *proximity_event;
 
-	proximity_event = zalloc(sizeof *proximity_event);
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY))
+		return;
+
+	proximity_event = tablet_tool_event_new(time,
+						tool,
+						changed_axes,
+						axes);
 	if (!proximity_event)
 		return;
 
-	*proximity_event = (struct libinput_event_tablet_tool) {
-		.time = time,
-		.tool = libinput_tablet_tool_ref(tool),
-		.tip_state = LIBINPUT_TABLET_TOOL_TIP_UP,
-		.proximity_state = proximity_state,
-		.axes = *axes,
-	};
-	memcpy(proximity_event->changed_axes,
-	       changed_axes,
-	       sizeof(proximity_event->changed_axes));
+	proximity_event->tip_state = LIBINPUT_TABLET_TOOL_TIP_UP;
+	proximity_event->proximity_state = proximity_state;
 
 	post_device_event(device,
 			  time,
@@ -2503,20 +3620,15 @@ tablet_notify_tip(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *tip_event;
 
-	tip_event = zalloc(sizeof *tip_event);
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_TOOL_TIP))
+		return;
+
+	tip_event = tablet_tool_event_new(time, tool, changed_axes, axes);
 	if (!tip_event)
 		return;
 
-	*tip_event = (struct libinput_event_tablet_tool) {
-		.time = time,
-		.tool = libinput_tablet_tool_ref(tool),
-		.tip_state = tip_state,
-		.proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN,
-		.axes = *axes,
-	};
-	memcpy(tip_event->changed_axes,
-	       changed_axes,
-	       sizeof(tip_event->changed_axes));
+	tip_event->tip_state = tip_state;
+	tip_event->proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN;
 
 	post_device_event(device,
 			  time,
@@ -2536,24 +3648,22 @@ tablet_notify_button(struct libinput_device *device,
 	struct libinput_event_tablet_tool *button_event;
 	int32_t seat_button_count;
 
-	button_event = zalloc(sizeof *button_event);
-	if (!button_event)
-		return;
-
 	seat_button_count = update_seat_button_count(device->seat,
 						     button,
 						     state);
 
-	*button_event = (struct libinput_event_tablet_tool) {
-		.time = time,
-		.tool = libinput_tablet_tool_ref(tool),
-		.button = button,
-		.state = state,
-		.seat_button_count = seat_button_count,
-		.proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN,
-		.tip_state = tip_state,
-		.axes = *axes,
-	};
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_TOOL_BUTTON))
+		return;
+
+	button_event = tablet_tool_event_new(time, tool, NULL, axes);
+	if (!button_event)
+		return;
+
+	button_event->button = button;
+	button_event->state = state;
+	button_event->seat_button_count = seat_button_count;
+	button_event->proximity_state = LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN;
+	button_event->tip_state = tip_state;
 
 	post_device_event(device,
 			  time,
@@ -2571,6 +3681,9 @@ tablet_pad_notify_button(struct libinput_device *device,
 	struct libinput_event_tablet_pad *button_event;
 	unsigned int mode;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_PAD_BUTTON))
+		return;
+
 	button_event = zalloc(sizeof *button_event);
 	if (!button_event)
 		return;
@@ -2602,6 +3715,9 @@ tablet_pad_notify_ring(struct libinput_device *device,
 	struct libinput_event_tablet_pad *ring_event;
 	unsigned int mode;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_PAD_RING))
+		return;
+
 	ring_event = zalloc(sizeof *ring_event);
 	if (!ring_event)
 		return;
@@ -2634,6 +3750,9 @@ tablet_pad_notify_strip(struct libinput_device *device,
 	struct libinput_event_tablet_pad *strip_event;
 	unsigned int mode;
 
+	if (!device_wants_event(device, LIBINPUT_EVENT_TABLET_PAD_STRIP))
+		return;
+
 	strip_event = zalloc(sizeof *strip_event);
 	if (!strip_event)
 		return;
@@ -2671,6 +3790,9 @@ gesture_notify(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_GESTURE))
 		return;
 
+	if (!device_wants_event(device, type))
+		return;
+
 	gesture_event = zalloc(sizeof *gesture_event);
 	if (!gesture_event)
 		return;
@@ -2746,24 +3868,57 @@ switch_notify_toggle(struct libinput_device *device,
 		     enum libinput_switch sw,
 		     enum libinput_switch_state state)
 {
-	struct libinput_event_switch *switch_event;
+	struct libinput_event_switch *switch_event;
+
+	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_SWITCH))
+		return;
+
+	if (!device_wants_event(device, LIBINPUT_EVENT_SWITCH_TOGGLE))
+		return;
+
+	switch_event = zalloc(sizeof *switch_event);
+	if (!switch_event)
+		return;
+
+	*switch_event = (struct libinput_event_switch) {
+		.time = time,
+		.sw = sw,
+		.state = state,
+	};
+
+	post_device_event(device, time,
+			  LIBINPUT_EVENT_SWITCH_TOGGLE,
+			  &switch_event->base);
+}
+
+void
+raw_notify_frame(struct libinput_device *device,
+		 uint64_t time,
+		 struct input_event *events,
+		 size_t nevents)
+{
+	struct libinput_event_raw *raw_event;
 
-	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_SWITCH))
+	if (!device_wants_event(device, LIBINPUT_EVENT_RAW_FRAME)) {
+		free(events);
 		return;
+	}
 
-	switch_event = zalloc(sizeof *switch_event);
-	if (!switch_event)
+	raw_event = zalloc(sizeof *raw_event);
+	if (!raw_event) {
+		free(events);
 		return;
+	}
 
-	*switch_event = (struct libinput_event_switch) {
+	*raw_event = (struct libinput_event_raw) {
 		.time = time,
-		.sw = sw,
-		.state = state,
+		.nevents = nevents,
+		.events = events,
 	};
 
 	post_device_event(device, time,
-			  LIBINPUT_EVENT_SWITCH_TOGGLE,
-			  &switch_event->base);
+			  LIBINPUT_EVENT_RAW_FRAME,
+			  &raw_event->base);
 }
 
 static void
@@ -2780,6 +3935,27 @@ libinput_post_event(struct libinput *libinput,
 	log_debug(libinput, "Queuing %s\n", event_type_to_str(event->type));
 #endif
 
+	if (libinput->tablet_motion_coalescing && events_count > 0) {
+		size_t last = (libinput->events_in + events_len - 1) %
+				events_len;
+		struct libinput_event *prev = events[last];
+
+		if (tablet_tool_event_coalesce(prev, event)) {
+			if (event->device)
+				libinput_device_ref(event->device);
+			events[last] = event;
+			libinput_event_destroy(prev);
+
+			/* event takes prev's place, the queue length
+			 * doesn't change */
+			LIBINPUT_PROBE3(event_post,
+					event,
+					event->type,
+					events_count);
+			return;
+		}
+	}
+
 	events_count++;
 	if (events_count > events_len) {
 		events_len *= 2;
@@ -2813,6 +3989,8 @@ libinput_post_event(struct libinput *libinput,
 	libinput->events_count = events_count;
 	events[libinput->events_in] = event;
 	libinput->events_in = (libinput->events_in + 1) % libinput->events_len;
+
+	LIBINPUT_PROBE3(event_post, event, event->type, events_count);
 }
 
 LIBINPUT_EXPORT struct libinput_event *
@@ -2828,6 +4006,8 @@ libinput_get_event(struct libinput *libinput)
 		(libinput->events_out + 1) % libinput->events_len;
 	libinput->events_count--;
 
+	LIBINPUT_PROBE3(event_get, event, event->type, libinput->events_count);
+
 	return event;
 }
 
@@ -2856,6 +4036,186 @@ libinput_get_user_data(struct libinput *libinput)
 	return libinput->user_data;
 }
 
+LIBINPUT_EXPORT void
+libinput_set_dispatch_budget(struct libinput *libinput,
+			     unsigned int budget)
+{
+	libinput->dispatch_budget = budget;
+}
+
+LIBINPUT_EXPORT unsigned int
+libinput_get_dispatch_budget(struct libinput *libinput)
+{
+	return libinput->dispatch_budget;
+}
+
+LIBINPUT_EXPORT int
+libinput_set_io_uring(struct libinput *libinput, int enable)
+{
+	if (!!enable == (libinput->uring != NULL))
+		return 0;
+
+	/* Sources don't move between epoll and the ring */
+	if (!list_empty(&libinput->seat_list) ||
+	    !list_empty(&libinput->source_read_list))
+		return -1;
+
+	if (enable) {
+		libinput_uring_init(libinput);
+		return libinput->uring ? 0 : -1;
+	}
+
+	libinput_uring_destroy(libinput);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_io_uring(struct libinput *libinput)
+{
+	return libinput->uring != NULL;
+}
+
+LIBINPUT_EXPORT int
+libinput_set_event_ordering_window(struct libinput *libinput,
+				   unsigned int window_usec)
+{
+	struct event_order *order = libinput->event_order;
+
+	if (window_usec > EVENT_ORDER_MAX_WINDOW)
+		return -1;
+
+	if (window_usec == 0) {
+		event_order_destroy(libinput);
+		return 0;
+	}
+
+	if (!order) {
+		order = zalloc(sizeof *order);
+		if (!order)
+			return -1;
+
+		libinput_timer_init(&order->timer,
+				    libinput,
+				    event_order_timer_func,
+				    libinput);
+		libinput->event_order = order;
+	}
+
+	order->window = window_usec;
+
+	return 0;
+}
+
+LIBINPUT_EXPORT unsigned int
+libinput_get_event_ordering_window(struct libinput *libinput)
+{
+	if (!libinput->event_order)
+		return 0;
+
+	return libinput->event_order->window;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_get_event_ordering_reorder_count(struct libinput *libinput)
+{
+	return libinput->event_reorder_count;
+}
+
+static inline bool
+event_type_is_valid(enum libinput_event_type type)
+{
+	switch (type) {
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+	case LIBINPUT_EVENT_SWITCH_TOGGLE:
+	case LIBINPUT_EVENT_RAW_FRAME:
+		return true;
+	case LIBINPUT_EVENT_NONE:
+		break;
+	}
+
+	return false;
+}
+
+LIBINPUT_EXPORT int
+libinput_set_event_interest(struct libinput *libinput,
+			    enum libinput_event_type type,
+			    int interested)
+{
+	if (!event_type_is_valid(type))
+		return -1;
+
+	if (interested)
+		clear_bit(libinput->ignored_event_types,
+			  event_type_to_bit(type));
+	else
+		set_bit(libinput->ignored_event_types,
+			event_type_to_bit(type));
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_event_interest(struct libinput *libinput,
+			    enum libinput_event_type type)
+{
+	if (!event_type_is_valid(type))
+		return 0;
+
+	return libinput_wants_event_type(libinput, type);
+}
+
+LIBINPUT_EXPORT void
+libinput_set_touch_frame_aggregation(struct libinput *libinput,
+				     int enable)
+{
+	libinput->touch_frame_aggregation = !!enable;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_touch_frame_aggregation(struct libinput *libinput)
+{
+	return libinput->touch_frame_aggregation;
+}
+
+LIBINPUT_EXPORT void
+libinput_set_tablet_motion_coalescing(struct libinput *libinput,
+				      int enable)
+{
+	libinput->tablet_motion_coalescing = !!enable;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_tablet_motion_coalescing(struct libinput *libinput)
+{
+	return libinput->tablet_motion_coalescing;
+}
+
 LIBINPUT_EXPORT int
 libinput_resume(struct libinput *libinput)
 {
@@ -2978,6 +4338,29 @@ libinput_device_pointer_has_button(struct libinput_device *device, uint32_t code
 	return evdev_device_has_button((struct evdev_device *)device, code);
 }
 
+LIBINPUT_EXPORT int
+libinput_device_pointer_predict(struct libinput_device *device,
+				uint64_t time_usec,
+				double *dx,
+				double *dy,
+				double *error,
+				double *confidence)
+{
+	struct filter_prediction prediction;
+
+	if (evdev_device_pointer_predict((struct evdev_device *)device,
+					 time_usec,
+					 &prediction) != 0)
+		return -1;
+
+	*dx = prediction.delta.x;
+	*dy = prediction.delta.y;
+	*error = prediction.error;
+	*confidence = prediction.confidence;
+
+	return 0;
+}
+
 LIBINPUT_EXPORT int
 libinput_device_keyboard_has_key(struct libinput_device *device, uint32_t code)
 {
@@ -3164,7 +4547,8 @@ libinput_event_touch_get_base_event(struct libinput_event_touch *event)
 			   LIBINPUT_EVENT_TOUCH_UP,
 			   LIBINPUT_EVENT_TOUCH_MOTION,
 			   LIBINPUT_EVENT_TOUCH_CANCEL,
-			   LIBINPUT_EVENT_TOUCH_FRAME);
+			   LIBINPUT_EVENT_TOUCH_FRAME,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
 
 	return &event->base;
 }
@@ -3199,6 +4583,272 @@ libinput_event_tablet_tool_get_base_event(struct libinput_event_tablet_tool *eve
 	return &event->base;
 }
 
+static inline bool
+snapshot_version_supported(uint32_t version)
+{
+	return version > 0 && version <= LIBINPUT_EVENT_SNAPSHOT_VERSION;
+}
+
+/* The size of each snapshot struct per version, indexed by version. A
+ * caller only has room for the struct of the version it asked for, so
+ * only that many bytes are copied. A new version appends fields, the
+ * previous entries then become the offsetof() the first new field. */
+static const size_t pointer_snapshot_size[] = {
+	[1] = sizeof(struct libinput_event_pointer_snapshot),
+};
+
+static const size_t touch_snapshot_size[] = {
+	[1] = sizeof(struct libinput_event_touch_snapshot),
+};
+
+static const size_t gesture_snapshot_size[] = {
+	[1] = sizeof(struct libinput_event_gesture_snapshot),
+};
+
+static const size_t tablet_tool_snapshot_size[] = {
+	[1] = sizeof(struct libinput_event_tablet_tool_snapshot),
+};
+
+LIBINPUT_EXPORT int
+libinput_event_pointer_get_snapshot(struct libinput_event_pointer *event,
+				    struct libinput_event_pointer_snapshot *snapshot)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+	struct libinput_event_pointer_snapshot s;
+	uint32_t version = snapshot->version;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   -1,
+			   LIBINPUT_EVENT_POINTER_MOTION,
+			   LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE,
+			   LIBINPUT_EVENT_POINTER_BUTTON,
+			   LIBINPUT_EVENT_POINTER_AXIS);
+
+	if (!snapshot_version_supported(version))
+		return -1;
+
+	s = (struct libinput_event_pointer_snapshot) {
+		.version = version,
+		.type = event->base.type,
+		.time_usec = event->time,
+	};
+
+	switch (event->base.type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+		s.dx = event->delta.x;
+		s.dy = event->delta.y;
+		s.dx_unaccelerated = event->delta_raw.x;
+		s.dy_unaccelerated = event->delta_raw.y;
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+		s.absolute_x = evdev_convert_to_mm(device->abs.absinfo_x,
+						   event->absolute.x);
+		s.absolute_y = evdev_convert_to_mm(device->abs.absinfo_y,
+						   event->absolute.y);
+		break;
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+		s.button = event->button;
+		s.button_state = event->state;
+		s.seat_button_count = event->seat_button_count;
+		break;
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		s.axis_source = event->source;
+		s.axes = event->axes;
+		if (event->axes & AS_MASK(LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL)) {
+			s.axis_value[LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL] =
+				event->delta.y;
+			s.axis_value_discrete[LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL] =
+				event->discrete.y;
+		}
+		if (event->axes & AS_MASK(LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL)) {
+			s.axis_value[LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL] =
+				event->delta.x;
+			s.axis_value_discrete[LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL] =
+				event->discrete.x;
+		}
+		break;
+	default:
+		break;
+	}
+
+	memcpy(snapshot, &s, pointer_snapshot_size[version]);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_touch_get_snapshot(struct libinput_event_touch *event,
+				  struct libinput_event_touch_snapshot *snapshot)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+	struct libinput_event_touch_snapshot s;
+	uint32_t version = snapshot->version;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   -1,
+			   LIBINPUT_EVENT_TOUCH_DOWN,
+			   LIBINPUT_EVENT_TOUCH_UP,
+			   LIBINPUT_EVENT_TOUCH_MOTION,
+			   LIBINPUT_EVENT_TOUCH_CANCEL,
+			   LIBINPUT_EVENT_TOUCH_FRAME,
+			   LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
+
+	if (!snapshot_version_supported(version))
+		return -1;
+
+	s = (struct libinput_event_touch_snapshot) {
+		.version = version,
+		.type = event->base.type,
+		.time_usec = event->time,
+	};
+
+	if (event->base.type != LIBINPUT_EVENT_TOUCH_FRAME &&
+	    event->base.type != LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME) {
+		s.slot = event->slot;
+		s.seat_slot = event->seat_slot;
+	}
+
+	if (event->base.type == LIBINPUT_EVENT_TOUCH_DOWN ||
+	    event->base.type == LIBINPUT_EVENT_TOUCH_MOTION) {
+		s.x = evdev_convert_to_mm(device->abs.absinfo_x,
+					  event->point.x);
+		s.y = evdev_convert_to_mm(device->abs.absinfo_y,
+					  event->point.y);
+	}
+
+	memcpy(snapshot, &s, touch_snapshot_size[version]);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_gesture_get_snapshot(struct libinput_event_gesture *event,
+				    struct libinput_event_gesture_snapshot *snapshot)
+{
+	struct libinput_event_gesture_snapshot s;
+	uint32_t version = snapshot->version;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   -1,
+			   LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN,
+			   LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE,
+			   LIBINPUT_EVENT_GESTURE_SWIPE_END,
+			   LIBINPUT_EVENT_GESTURE_PINCH_BEGIN,
+			   LIBINPUT_EVENT_GESTURE_PINCH_UPDATE,
+			   LIBINPUT_EVENT_GESTURE_PINCH_END);
+
+	if (!snapshot_version_supported(version))
+		return -1;
+
+	s = (struct libinput_event_gesture_snapshot) {
+		.version = version,
+		.type = event->base.type,
+		.time_usec = event->time,
+		.finger_count = event->finger_count,
+		.dx = event->delta.x,
+		.dy = event->delta.y,
+		.dx_unaccelerated = event->delta_unaccel.x,
+		.dy_unaccelerated = event->delta_unaccel.y,
+	};
+
+	switch (event->base.type) {
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+		s.cancelled = event->cancelled;
+		break;
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		s.cancelled = event->cancelled;
+		/* fallthrough */
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+		s.scale = event->scale;
+		s.angle_delta = event->angle;
+		break;
+	default:
+		break;
+	}
+
+	memcpy(snapshot, &s, gesture_snapshot_size[version]);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_event_tablet_tool_get_snapshot(struct libinput_event_tablet_tool *event,
+					struct libinput_event_tablet_tool_snapshot *snapshot)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+	struct libinput_event_tablet_tool_snapshot s;
+	uint32_t version = snapshot->version;
+	uint32_t changed_axes = 0;
+	int axis;
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   -1,
+			   LIBINPUT_EVENT_TABLET_TOOL_AXIS,
+			   LIBINPUT_EVENT_TABLET_TOOL_TIP,
+			   LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY,
+			   LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+
+	if (!snapshot_version_supported(version))
+		return -1;
+
+	/* The public flags are the private axis enum shifted down by one */
+	for (axis = LIBINPUT_TABLET_TOOL_AXIS_X;
+	     axis <= LIBINPUT_TABLET_TOOL_AXIS_MAX;
+	     axis++) {
+		if (bit_is_set(event->changed_axes, axis))
+			changed_axes |= 1 << (axis - 1);
+	}
+
+	s = (struct libinput_event_tablet_tool_snapshot) {
+		.version = version,
+		.type = event->base.type,
+		.time_usec = event->time,
+		.tool = event->tool,
+		.changed_axes = changed_axes,
+		.proximity_state = event->proximity_state,
+		.tip_state = event->tip_state,
+		.x = evdev_convert_to_mm(device->abs.absinfo_x,
+					 event->point.x),
+		.y = evdev_convert_to_mm(device->abs.absinfo_y,
+					 event->point.y),
+	};
+
+	if (event->base.type == LIBINPUT_EVENT_TABLET_TOOL_BUTTON) {
+		s.button = event->button;
+		s.button_state = event->state;
+		s.seat_button_count = event->seat_button_count;
+	}
+
+	s.dx = event->delta.x;
+	s.dy = event->delta.y;
+	s.pressure =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_PRESSURE);
+	s.distance =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_DISTANCE);
+	s.tilt_x =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_TILT_X);
+	s.tilt_y =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_TILT_Y);
+	s.rotation =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_ROTATION);
+	s.slider =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_SLIDER);
+	s.wheel_delta =
+		tablet_tool_event_get_axis(event, TABLET_PACKED_WHEEL);
+	s.wheel_delta_discrete =
+		(int)tablet_tool_event_get_axis(event,
+						TABLET_PACKED_WHEEL_DISCRETE);
+
+	memcpy(snapshot, &s, tablet_tool_snapshot_size[version]);
+
+	return 0;
+}
+
 LIBINPUT_EXPORT double
 libinput_event_tablet_pad_get_ring_position(struct libinput_event_tablet_pad *event)
 {
@@ -4069,6 +5719,48 @@ libinput_device_config_dwt_get_default_enabled(struct libinput_device *device)
 	return device->config.dwt->get_default_enabled(device);
 }
 
+LIBINPUT_EXPORT int
+libinput_device_config_raw_is_available(struct libinput_device *device)
+{
+	if (!device->config.raw)
+		return 0;
+
+	return device->config.raw->is_available(device);
+}
+
+LIBINPUT_EXPORT enum libinput_config_status
+libinput_device_config_raw_set_enabled(struct libinput_device *device,
+				       enum libinput_config_raw_state enable)
+{
+	if (enable != LIBINPUT_CONFIG_RAW_ENABLED &&
+	    enable != LIBINPUT_CONFIG_RAW_DISABLED)
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
+	if (!libinput_device_config_raw_is_available(device))
+		return enable ? LIBINPUT_CONFIG_STATUS_UNSUPPORTED :
+				LIBINPUT_CONFIG_STATUS_SUCCESS;
+
+	return device->config.raw->set_enabled(device, enable);
+}
+
+LIBINPUT_EXPORT enum libinput_config_raw_state
+libinput_device_config_raw_get_enabled(struct libinput_device *device)
+{
+	if (!libinput_device_config_raw_is_available(device))
+		return LIBINPUT_CONFIG_RAW_DISABLED;
+
+	return device->config.raw->get_enabled(device);
+}
+
+LIBINPUT_EXPORT enum libinput_config_raw_state
+libinput_device_config_raw_get_default_enabled(struct libinput_device *device)
+{
+	if (!libinput_device_config_raw_is_available(device))
+		return LIBINPUT_CONFIG_RAW_DISABLED;
+
+	return device->config.raw->get_default_enabled(device);
+}
+
 LIBINPUT_EXPORT int
 libinput_device_config_rotation_is_available(struct libinput_device *device)
 {
@@ -46,6 +46,25 @@ extern "C" {
  */
 struct libinput;
 
+/**
+ * @ingroup base
+ * @struct libinput_udev_monitor
+ *
+ * A udev monitor shared between several libinput contexts, see
+ * libinput_udev_assign_seat_shared(). This struct is refcounted, use
+ * libinput_udev_monitor_ref() and libinput_udev_monitor_unref().
+ */
+struct libinput_udev_monitor;
+
+/**
+ * @ingroup base
+ * @struct libinput_event_ring
+ *
+ * A shared memory ring that a context's events are published into, see
+ * libinput_event_ring_new().
+ */
+struct libinput_event_ring;
+
 /**
  * @ingroup device
  * @struct libinput_device
@@ -135,8 +154,8 @@ struct libinput_event_pointer;
  * Touch event representing a touch down, move or up, as well as a touch
  * cancel and touch frame events. Valid event types for this event are @ref
  * LIBINPUT_EVENT_TOUCH_DOWN, @ref LIBINPUT_EVENT_TOUCH_MOTION, @ref
- * LIBINPUT_EVENT_TOUCH_UP, @ref LIBINPUT_EVENT_TOUCH_CANCEL and @ref
- * LIBINPUT_EVENT_TOUCH_FRAME.
+ * LIBINPUT_EVENT_TOUCH_UP, @ref LIBINPUT_EVENT_TOUCH_CANCEL, @ref
+ * LIBINPUT_EVENT_TOUCH_FRAME and @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME.
  */
 struct libinput_event_touch;
 
@@ -634,6 +653,19 @@ enum libinput_switch {
  */
 struct libinput_event_switch;
 
+/**
+ * @ingroup event_raw
+ * @struct libinput_event_raw
+ *
+ * A raw event carrying one evdev frame of a device in raw mode, see
+ * libinput_device_config_raw_set_enabled(). The only valid event type for
+ * this event is @ref LIBINPUT_EVENT_RAW_FRAME.
+ */
+struct libinput_event_raw;
+
+/* struct input_event is defined in linux/input.h */
+struct input_event;
+
 /**
  * @ingroup base
  *
@@ -679,6 +711,16 @@ enum libinput_event_type {
 	 * time. This event has no coordinate information attached.
 	 */
 	LIBINPUT_EVENT_TOUCH_FRAME,
+	/**
+	 * All touch point changes of one device sample time in a single
+	 * event. This event replaces the @ref LIBINPUT_EVENT_TOUCH_DOWN,
+	 * @ref LIBINPUT_EVENT_TOUCH_MOTION, @ref LIBINPUT_EVENT_TOUCH_UP and
+	 * @ref LIBINPUT_EVENT_TOUCH_FRAME events of multitouch touchscreens
+	 * when enabled with libinput_set_touch_frame_aggregation().
+	 *
+	 * @see libinput_event_touch_get_slot_changes
+	 */
+	LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME,
 
 	/**
 	 * One or more axes have changed state on a device with the @ref
@@ -791,12 +833,35 @@ enum libinput_event_type {
 	LIBINPUT_EVENT_GESTURE_PINCH_END,
 
 	LIBINPUT_EVENT_SWITCH_TOGGLE = 900,
+
+	/**
+	 * One SYN_REPORT-delimited frame of evdev events from a device in
+	 * raw mode. See libinput_device_config_raw_set_enabled().
+	 */
+	LIBINPUT_EVENT_RAW_FRAME = 1000,
 };
 
 /**
  * @defgroup event Accessing and destruction of events
  */
 
+/**
+ * @ingroup event
+ *
+ * The current version of the event snapshot structs, see
+ * libinput_event_pointer_get_snapshot(),
+ * libinput_event_touch_get_snapshot(),
+ * libinput_event_gesture_get_snapshot() and
+ * libinput_event_tablet_tool_get_snapshot().
+ *
+ * The caller sets the version field of a snapshot struct to this value
+ * before passing it to libinput. Future versions only append fields to
+ * the structs and libinput never writes past the struct size of the
+ * version set by the caller, so a caller built against an older version
+ * of this header keeps working.
+ */
+#define LIBINPUT_EVENT_SNAPSHOT_VERSION 1
+
 /**
  * @ingroup event
  *
@@ -940,6 +1005,19 @@ libinput_event_get_tablet_pad_event(struct libinput_event *event);
 struct libinput_event_switch *
 libinput_event_get_switch_event(struct libinput_event *event);
 
+/**
+ * @ingroup event
+ *
+ * Return the raw event that is this input event. If the event type does
+ * not match the raw event types, this function returns NULL.
+ *
+ * The inverse of this function is libinput_event_raw_get_base_event().
+ *
+ * @return A raw event, or NULL for other events
+ */
+struct libinput_event_raw *
+libinput_event_get_raw_event(struct libinput_event *event);
+
 /**
  * @ingroup event
  *
@@ -1395,6 +1473,40 @@ double
 libinput_event_pointer_get_axis_value_discrete(struct libinput_event_pointer *event,
 					       enum libinput_pointer_axis axis);
 
+/**
+ * @ingroup event_pointer
+ *
+ * Return the estimated velocity of a scroll sequence on the given axis,
+ * in the same units as libinput_event_pointer_get_axis_value() per
+ * second.
+ *
+ * The velocity is only set on the terminating event of a scroll sequence
+ * with the source @ref LIBINPUT_POINTER_AXIS_SOURCE_FINGER or @ref
+ * LIBINPUT_POINTER_AXIS_SOURCE_CONTINUOUS, i.e. the event where
+ * libinput_event_pointer_get_axis_value() returns 0. libinput estimates
+ * it from the most recent scroll events of the sequence, it is zero if
+ * the sequence slowed down to a stop before it ended. Callers may use this
+ * value to start kinetic scrolling. For all other axis events, this
+ * function returns 0.
+ *
+ * Natural scrolling is applied to the velocity, the sign of the velocity
+ * matches the sign of the axis values of the sequence.
+ *
+ * @note It is an application bug to call this function for events other
+ * than @ref LIBINPUT_EVENT_POINTER_AXIS or for an axis that
+ * libinput_event_pointer_has_axis() returns 0 for.
+ *
+ * @param event The libinput pointer event
+ * @param axis The axis to get the velocity for
+ * @return The estimated velocity of the scroll sequence on this axis, in
+ * units per second
+ *
+ * @see libinput_event_pointer_get_axis_value
+ */
+double
+libinput_event_pointer_get_axis_velocity(struct libinput_event_pointer *event,
+					 enum libinput_pointer_axis axis);
+
 /**
  * @ingroup event_pointer
  *
@@ -1403,6 +1515,58 @@ libinput_event_pointer_get_axis_value_discrete(struct libinput_event_pointer *ev
 struct libinput_event *
 libinput_event_pointer_get_base_event(struct libinput_event_pointer *event);
 
+/**
+ * @ingroup event_pointer
+ *
+ * A copy of all fields of a pointer event, filled in by
+ * libinput_event_pointer_get_snapshot(). Fields that do not apply to the
+ * event type are zero.
+ */
+struct libinput_event_pointer_snapshot {
+	uint32_t version; /**< Set by the caller, see @ref LIBINPUT_EVENT_SNAPSHOT_VERSION */
+	uint32_t type; /**< The @ref libinput_event_type */
+	uint64_t time_usec;
+	double dx; /**< @ref LIBINPUT_EVENT_POINTER_MOTION only */
+	double dy; /**< @ref LIBINPUT_EVENT_POINTER_MOTION only */
+	double dx_unaccelerated; /**< @ref LIBINPUT_EVENT_POINTER_MOTION only */
+	double dy_unaccelerated; /**< @ref LIBINPUT_EVENT_POINTER_MOTION only */
+	double absolute_x; /**< In mm, @ref LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE only */
+	double absolute_y; /**< In mm, @ref LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE only */
+	uint32_t button; /**< @ref LIBINPUT_EVENT_POINTER_BUTTON only */
+	uint32_t button_state; /**< @ref LIBINPUT_EVENT_POINTER_BUTTON only */
+	uint32_t seat_button_count; /**< @ref LIBINPUT_EVENT_POINTER_BUTTON only */
+	uint32_t axis_source; /**< @ref LIBINPUT_EVENT_POINTER_AXIS only */
+	/**
+	 * A bitmask of (1 << @ref libinput_pointer_axis) for each axis
+	 * present, @ref LIBINPUT_EVENT_POINTER_AXIS only
+	 */
+	uint32_t axes;
+	uint32_t padding;
+	/** Indexed by @ref libinput_pointer_axis */
+	double axis_value[2];
+	/** Indexed by @ref libinput_pointer_axis */
+	double axis_value_discrete[2];
+};
+
+/**
+ * @ingroup event_pointer
+ *
+ * Copy all fields of this event into the snapshot in a single call. This
+ * is equivalent to calling each of the libinput_event_pointer_get_*()
+ * accessors that is valid for this event type but validates the event
+ * type only once.
+ *
+ * The caller must set the version field of the snapshot to @ref
+ * LIBINPUT_EVENT_SNAPSHOT_VERSION before calling this function.
+ *
+ * @param event The libinput pointer event
+ * @param snapshot The snapshot to fill in
+ * @return 0 on success, or -1 if the snapshot version is not supported
+ */
+int
+libinput_event_pointer_get_snapshot(struct libinput_event_pointer *event,
+				    struct libinput_event_pointer_snapshot *snapshot);
+
 /**
  * @defgroup event_touch Touch events
  *
@@ -1565,6 +1729,114 @@ libinput_event_touch_get_y_transformed(struct libinput_event_touch *event,
 struct libinput_event *
 libinput_event_touch_get_base_event(struct libinput_event_touch *event);
 
+/**
+ * @ingroup event_touch
+ *
+ * A copy of all fields of a touch event, filled in by
+ * libinput_event_touch_get_snapshot(). Fields that do not apply to the
+ * event type are zero.
+ */
+struct libinput_event_touch_snapshot {
+	uint32_t version; /**< Set by the caller, see @ref LIBINPUT_EVENT_SNAPSHOT_VERSION */
+	uint32_t type; /**< The @ref libinput_event_type */
+	uint64_t time_usec;
+	int32_t slot;
+	int32_t seat_slot;
+	double x; /**< In mm, @ref LIBINPUT_EVENT_TOUCH_DOWN and @ref LIBINPUT_EVENT_TOUCH_MOTION only */
+	double y; /**< In mm, @ref LIBINPUT_EVENT_TOUCH_DOWN and @ref LIBINPUT_EVENT_TOUCH_MOTION only */
+};
+
+/**
+ * @ingroup event_touch
+ *
+ * Copy all fields of this event into the snapshot in a single call. This
+ * is equivalent to calling each of the libinput_event_touch_get_*()
+ * accessors that is valid for this event type but validates the event
+ * type only once.
+ *
+ * The caller must set the version field of the snapshot to @ref
+ * LIBINPUT_EVENT_SNAPSHOT_VERSION before calling this function.
+ *
+ * @param event The libinput touch event
+ * @param snapshot The snapshot to fill in
+ * @return 0 on success, or -1 if the snapshot version is not supported
+ */
+int
+libinput_event_touch_get_snapshot(struct libinput_event_touch *event,
+				  struct libinput_event_touch_snapshot *snapshot);
+
+/**
+ * @ingroup event_touch
+ *
+ * A single touch point change within an event of type @ref
+ * LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME.
+ */
+struct libinput_touch_slot_change {
+	/**
+	 * @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref LIBINPUT_EVENT_TOUCH_MOTION
+	 * or @ref LIBINPUT_EVENT_TOUCH_UP
+	 */
+	uint32_t type;
+	int32_t slot; /**< See libinput_event_touch_get_slot() */
+	int32_t seat_slot; /**< See libinput_event_touch_get_seat_slot() */
+	uint32_t padding;
+	/** In mm from the top left corner, zero for touch up */
+	double x;
+	/** In mm from the top left corner, zero for touch up */
+	double y;
+	/**
+	 * In the range [0, 1), multiply by the screen width for the
+	 * equivalent of libinput_event_touch_get_x_transformed(). Zero for
+	 * touch up.
+	 */
+	double x_normalized;
+	/**
+	 * In the range [0, 1), multiply by the screen height for the
+	 * equivalent of libinput_event_touch_get_y_transformed(). Zero for
+	 * touch up.
+	 */
+	double y_normalized;
+};
+
+/**
+ * @ingroup event_touch
+ *
+ * Return the number of touch point changes in this event.
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME, this
+ * function returns 0.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME.
+ *
+ * @param event The libinput touch event
+ * @return The number of elements returned by
+ * libinput_event_touch_get_slot_changes()
+ */
+unsigned int
+libinput_event_touch_get_slot_change_count(struct libinput_event_touch *event);
+
+/**
+ * @ingroup event_touch
+ *
+ * Return the touch point changes of this event. Each slot appears at most
+ * once, a touch down followed by motion in the same frame is reported as
+ * touch down at the most recent position. The returned array is owned by
+ * the event and valid until the event is destroyed.
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME, this
+ * function returns NULL.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME.
+ *
+ * @param event The libinput touch event
+ * @return An array of libinput_event_touch_get_slot_change_count()
+ * elements
+ */
+const struct libinput_touch_slot_change *
+libinput_event_touch_get_slot_changes(struct libinput_event_touch *event);
+
 /**
  * @defgroup event_gesture Gesture events
  *
@@ -1609,6 +1881,46 @@ libinput_event_gesture_get_time_usec(struct libinput_event_gesture *event);
 struct libinput_event *
 libinput_event_gesture_get_base_event(struct libinput_event_gesture *event);
 
+/**
+ * @ingroup event_gesture
+ *
+ * A copy of all fields of a gesture event, filled in by
+ * libinput_event_gesture_get_snapshot(). Fields that do not apply to the
+ * event type are zero.
+ */
+struct libinput_event_gesture_snapshot {
+	uint32_t version; /**< Set by the caller, see @ref LIBINPUT_EVENT_SNAPSHOT_VERSION */
+	uint32_t type; /**< The @ref libinput_event_type */
+	uint64_t time_usec;
+	int32_t finger_count;
+	int32_t cancelled; /**< Gesture end events only */
+	double dx;
+	double dy;
+	double dx_unaccelerated;
+	double dy_unaccelerated;
+	double scale; /**< Pinch events only */
+	double angle_delta; /**< Pinch events only */
+};
+
+/**
+ * @ingroup event_gesture
+ *
+ * Copy all fields of this event into the snapshot in a single call. This
+ * is equivalent to calling each of the libinput_event_gesture_get_*()
+ * accessors that is valid for this event type but validates the event
+ * type only once.
+ *
+ * The caller must set the version field of the snapshot to @ref
+ * LIBINPUT_EVENT_SNAPSHOT_VERSION before calling this function.
+ *
+ * @param event The libinput gesture event
+ * @param snapshot The snapshot to fill in
+ * @return 0 on success, or -1 if the snapshot version is not supported
+ */
+int
+libinput_event_gesture_get_snapshot(struct libinput_event_gesture *event,
+				    struct libinput_event_gesture_snapshot *snapshot);
+
 /**
  * @ingroup event_gesture
  *
@@ -1798,6 +2110,79 @@ libinput_event_gesture_get_angle_delta(struct libinput_event_gesture *event);
 struct libinput_event *
 libinput_event_tablet_tool_get_base_event(struct libinput_event_tablet_tool *event);
 
+/**
+ * @ingroup event_tablet
+ *
+ * Flags for the changed_axes field of struct
+ * libinput_event_tablet_tool_snapshot.
+ */
+enum libinput_tablet_tool_snapshot_axis {
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_X = (1 << 0),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_Y = (1 << 1),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_DISTANCE = (1 << 2),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_PRESSURE = (1 << 3),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_TILT_X = (1 << 4),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_TILT_Y = (1 << 5),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_ROTATION = (1 << 6),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_SLIDER = (1 << 7),
+	LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_WHEEL = (1 << 8),
+};
+
+/**
+ * @ingroup event_tablet
+ *
+ * A copy of all fields of a tablet tool event, filled in by
+ * libinput_event_tablet_tool_get_snapshot(). Fields that do not apply to
+ * the event type are zero. For @ref LIBINPUT_EVENT_TABLET_TOOL_BUTTON the
+ * axis fields hold the tool's state at the time of the button event.
+ */
+struct libinput_event_tablet_tool_snapshot {
+	uint32_t version; /**< Set by the caller, see @ref LIBINPUT_EVENT_SNAPSHOT_VERSION */
+	uint32_t type; /**< The @ref libinput_event_type */
+	uint64_t time_usec;
+	/** The tool, not refcounted, see libinput_event_tablet_tool_get_tool() */
+	struct libinput_tablet_tool *tool;
+	/** A bitmask of @ref libinput_tablet_tool_snapshot_axis */
+	uint32_t changed_axes;
+	uint32_t proximity_state; /**< @ref libinput_tablet_tool_proximity_state */
+	uint32_t tip_state; /**< @ref libinput_tablet_tool_tip_state */
+	int32_t wheel_delta_discrete;
+	double x; /**< In mm */
+	double y; /**< In mm */
+	double dx;
+	double dy;
+	double pressure;
+	double distance;
+	double tilt_x;
+	double tilt_y;
+	double rotation;
+	double slider;
+	double wheel_delta;
+	uint32_t button; /**< @ref LIBINPUT_EVENT_TABLET_TOOL_BUTTON only */
+	uint32_t button_state; /**< @ref LIBINPUT_EVENT_TABLET_TOOL_BUTTON only */
+	uint32_t seat_button_count; /**< @ref LIBINPUT_EVENT_TABLET_TOOL_BUTTON only */
+	uint32_t padding;
+};
+
+/**
+ * @ingroup event_tablet
+ *
+ * Copy all fields of this event into the snapshot in a single call. This
+ * is equivalent to calling each of the libinput_event_tablet_tool_get_*()
+ * accessors that is valid for this event type but validates the event
+ * type only once.
+ *
+ * The caller must set the version field of the snapshot to @ref
+ * LIBINPUT_EVENT_SNAPSHOT_VERSION before calling this function.
+ *
+ * @param event The libinput tablet tool event
+ * @param snapshot The snapshot to fill in
+ * @return 0 on success, or -1 if the snapshot version is not supported
+ */
+int
+libinput_event_tablet_tool_get_snapshot(struct libinput_event_tablet_tool *event,
+					struct libinput_event_tablet_tool_snapshot *snapshot);
+
 /**
  * @ingroup event_tablet
  *
@@ -2345,6 +2730,52 @@ libinput_event_tablet_tool_get_time(struct libinput_event_tablet_tool *event);
 uint64_t
 libinput_event_tablet_tool_get_time_usec(struct libinput_event_tablet_tool *event);
 
+/**
+ * @ingroup event_tablet
+ *
+ * An intermediate position of a coalesced @ref
+ * LIBINPUT_EVENT_TABLET_TOOL_AXIS event, see
+ * libinput_set_tablet_motion_coalescing().
+ */
+struct libinput_tablet_tool_sample {
+	uint64_t time_usec; /**< See libinput_event_tablet_tool_get_time_usec() */
+	double x; /**< See libinput_event_tablet_tool_get_x() */
+	double y; /**< See libinput_event_tablet_tool_get_y() */
+	double pressure; /**< See libinput_event_tablet_tool_get_pressure() */
+	double tilt_x; /**< See libinput_event_tablet_tool_get_tilt_x() */
+	double tilt_y; /**< See libinput_event_tablet_tool_get_tilt_y() */
+};
+
+/**
+ * @ingroup event_tablet
+ *
+ * Return the number of intermediate samples merged into this event. This
+ * is nonzero only for events of type @ref LIBINPUT_EVENT_TABLET_TOOL_AXIS
+ * when tablet motion coalescing is enabled, see
+ * libinput_set_tablet_motion_coalescing().
+ *
+ * @param event The libinput tablet tool event
+ * @return The number of elements returned by
+ * libinput_event_tablet_tool_get_samples()
+ */
+unsigned int
+libinput_event_tablet_tool_get_sample_count(struct libinput_event_tablet_tool *event);
+
+/**
+ * @ingroup event_tablet
+ *
+ * Return the intermediate samples merged into this event, oldest first.
+ * The event itself carries the most recent state, it is not part of
+ * the array. The returned array is owned by the event and valid until
+ * the event is destroyed.
+ *
+ * @param event The libinput tablet tool event
+ * @return An array of libinput_event_tablet_tool_get_sample_count()
+ * elements or NULL if the event has no intermediate samples
+ */
+const struct libinput_tablet_tool_sample *
+libinput_event_tablet_tool_get_samples(struct libinput_event_tablet_tool *event);
+
 /**
  * @ingroup event_tablet
  *
@@ -2856,6 +3287,50 @@ libinput_event_switch_get_time(struct libinput_event_switch *event);
 uint64_t
 libinput_event_switch_get_time_usec(struct libinput_event_switch *event);
 
+/**
+ * @defgroup event_raw Raw events
+ *
+ * Events from devices in raw mode. See
+ * libinput_device_config_raw_set_enabled().
+ */
+
+/**
+ * @ingroup event_raw
+ *
+ * Return the evdev events of this frame, in the order they were read from
+ * the kernel, including the terminating SYN_REPORT. The array is owned by
+ * the event and valid until the event is destroyed. The events are not
+ * copied, scaled or otherwise processed by libinput.
+ *
+ * @param event The libinput raw event
+ * @param nevents Set to the number of elements in the returned array
+ * @return The evdev events of this frame
+ */
+const struct input_event *
+libinput_event_raw_get_events(struct libinput_event_raw *event,
+			      size_t *nevents);
+
+/**
+ * @ingroup event_raw
+ *
+ * @return The generic libinput_event of this event
+ */
+struct libinput_event *
+libinput_event_raw_get_base_event(struct libinput_event_raw *event);
+
+/**
+ * @ingroup event_raw
+ *
+ * @note Timestamps may not always increase. See @ref event_timestamps for
+ * details.
+ *
+ * @param event The libinput raw event
+ * @return The time of the SYN_REPORT terminating this frame in
+ * microseconds
+ */
+uint64_t
+libinput_event_raw_get_time_usec(struct libinput_event_raw *event);
+
 /**
  * @defgroup base Initialization and manipulation of libinput contexts
  */
@@ -2937,6 +3412,99 @@ int
 libinput_udev_assign_seat(struct libinput *libinput,
 			  const char *seat_id);
 
+/**
+ * @ingroup base
+ *
+ * Create a udev monitor for the input subsystem that can be shared by
+ * several libinput contexts in the same process, e.g. one context per
+ * seat on a multi-seat server. The monitor enumerates the input devices
+ * once and routes each uevent to the contexts whose seat matches the
+ * device's ID_SEAT property, see libinput_udev_assign_seat_shared().
+ *
+ * The caller must watch the file descriptor returned by
+ * libinput_udev_monitor_get_fd() and call libinput_udev_monitor_dispatch()
+ * when it is readable. Contexts sharing a monitor must be used from the
+ * same thread as the monitor.
+ *
+ * The reference count of the monitor is initialized to 1.
+ *
+ * @param udev An already initialized udev context
+ *
+ * @return A new monitor or NULL on error
+ */
+struct libinput_udev_monitor *
+libinput_udev_monitor_new(struct udev *udev);
+
+/**
+ * @ingroup base
+ *
+ * Add a reference to the monitor.
+ *
+ * @param monitor A previously created monitor
+ * @return The passed monitor
+ */
+struct libinput_udev_monitor *
+libinput_udev_monitor_ref(struct libinput_udev_monitor *monitor);
+
+/**
+ * @ingroup base
+ *
+ * Drop a reference to the monitor. When the reference count reaches
+ * zero, the monitor is destroyed. Each context using the monitor holds a
+ * reference of its own.
+ *
+ * @param monitor A previously created monitor
+ * @return NULL if the monitor was destroyed, otherwise the passed monitor
+ */
+struct libinput_udev_monitor *
+libinput_udev_monitor_unref(struct libinput_udev_monitor *monitor);
+
+/**
+ * @ingroup base
+ *
+ * @param monitor A previously created monitor
+ * @return The file descriptor to poll for uevents
+ */
+int
+libinput_udev_monitor_get_fd(struct libinput_udev_monitor *monitor);
+
+/**
+ * @ingroup base
+ *
+ * Read all pending uevents and hand each one to the contexts assigned to
+ * the device's seat. The contexts process the devices during their next
+ * libinput_dispatch(), their file descriptors become readable when they
+ * have work to do.
+ *
+ * @param monitor A previously created monitor
+ * @return 0 on success
+ */
+int
+libinput_udev_monitor_dispatch(struct libinput_udev_monitor *monitor);
+
+/**
+ * @ingroup base
+ *
+ * Assign a seat to this libinput context and use a shared monitor for
+ * device discovery instead of a monitor of its own. The context takes a
+ * reference to the monitor. Otherwise this function behaves like
+ * libinput_udev_assign_seat().
+ *
+ * This function may only be called once per context, and not in addition
+ * to libinput_udev_assign_seat().
+ *
+ * @param libinput A libinput context initialized with
+ * libinput_udev_create_context()
+ * @param seat_id A seat identifier. This string must not be NULL.
+ * @param monitor A monitor created with libinput_udev_monitor_new()
+ *
+ * @return 0 on success or -1 on failure.
+ */
+int
+libinput_udev_assign_seat_shared(struct libinput *libinput,
+				 const char *seat_id,
+				 struct libinput_udev_monitor *monitor);
+
 /**
  * @ingroup base
  *
@@ -3036,6 +3604,53 @@ libinput_get_fd(struct libinput *libinput);
 int
 libinput_dispatch(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Like libinput_dispatch(), this reads and processes everything pending
+ * on the fd returned by libinput_get_fd() right away. Only the delivery
+ * of some events to the caller is coalesced, for a caller that renders
+ * frames and passes the deadline of its next frame. It does not defer
+ * reading from the kernel and does not save any wakeups, the caller still
+ * calls it whenever the fd becomes readable.
+ *
+ * Pointer motion (relative and absolute) and pointer axis events are held
+ * back until shortly before the deadline and consecutive events of the
+ * same type from the same device are merged into one, e.g. all relative
+ * motion of a device within a frame is delivered as a single @ref
+ * LIBINPUT_EVENT_POINTER_MOTION event with the summed deltas and the
+ * timestamp of the most recent motion. Scroll stop events and events with
+ * different axes or axis sources are never merged.
+ *
+ * All other events, e.g. buttons, keys, touch and tablet events, are
+ * queued immediately. An event that is queued immediately releases the
+ * held-back events of its device first so a device's events are never
+ * reordered.
+ *
+ * Held-back events are released when they become due, libinput signals
+ * the fd returned by libinput_get_fd() when this is needed and the caller
+ * must call libinput_dispatch_coalesced() or libinput_dispatch() then.
+ * Calling this function with a different deadline than the previous call
+ * releases the events held back for the previous deadline. Calling
+ * libinput_dispatch() releases all held-back events and ends frame-based
+ * dispatching until this function is called again.
+ *
+ * Internal features such as disable-while-typing see the events as they
+ * happen, only the delivery to the caller is delayed.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param deadline_usec The presentation deadline of the caller's next
+ * frame in microseconds, in CLOCK_MONOTONIC like the event timestamps. A
+ * deadline of 0 or one that has passed holds back no events.
+ *
+ * @return 0 on success, or a negative errno on failure
+ *
+ * @see libinput_dispatch
+ */
+int
+libinput_dispatch_coalesced(struct libinput *libinput,
+			    uint64_t deadline_usec);
+
 /**
  * @ingroup base
  *
@@ -3091,6 +3706,265 @@ libinput_set_user_data(struct libinput *libinput,
 void *
 libinput_get_user_data(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Set the maximum number of kernel events libinput reads from a single
+ * device before moving on to the next device within libinput_dispatch().
+ * Devices with more events pending are read again in round-robin fashion
+ * until all devices are drained, so this does not change the number of
+ * events processed by one call to libinput_dispatch(), only their order.
+ *
+ * A smaller budget bounds the latency a high-frequency device (e.g. a
+ * gaming mouse or a touchscreen) can add to events from other devices, at
+ * the cost of more epoll_wait() calls. A budget of 0 disables the limit
+ * and each device is drained fully before the next one is read.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param budget The number of kernel events per device and dispatch
+ * round, or 0 for no limit
+ *
+ * @see libinput_get_dispatch_budget
+ */
+void
+libinput_set_dispatch_budget(struct libinput *libinput,
+			     unsigned int budget);
+
+/**
+ * @ingroup base
+ *
+ * Get the maximum number of kernel events libinput reads from a single
+ * device before moving on to the next device within libinput_dispatch().
+ *
+ * @param libinput A previously initialized libinput context
+ * @return The per-device budget, or 0 if there is no limit
+ *
+ * @see libinput_set_dispatch_budget
+ */
+unsigned int
+libinput_get_dispatch_budget(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable reading devices through io_uring. When enabled,
+ * libinput keeps a read queued in the kernel for every device and
+ * collects the completed reads in one system call per
+ * libinput_dispatch(), instead of one read per device. The fd returned by
+ * libinput_get_fd() is unchanged.
+ *
+ * This must be called before any device is added, i.e. before
+ * libinput_udev_assign_seat() or libinput_path_add_device(). io_uring
+ * needs kernel 5.7 or later and may be blocked by a seccomp filter.
+ * Reading through io_uring is disabled by default.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param enable Non-zero to enable io_uring reads, zero to disable them
+ *
+ * @return 0 on success, or -1 if io_uring is not available or devices
+ * have already been added
+ *
+ * @see libinput_get_io_uring
+ */
+int
+libinput_set_io_uring(struct libinput *libinput, int enable);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @return Non-zero if devices are read through io_uring, zero otherwise
+ *
+ * @see libinput_set_io_uring
+ */
+int
+libinput_get_io_uring(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable ordering of events across devices by their kernel
+ * timestamp.
+ *
+ * By default, events are queued in the order libinput reads the devices,
+ * so an event from one device may be queued before an earlier event from
+ * another device (e.g. a pointer button press before the keyboard
+ * modifier press that physically happened first). With a non-zero
+ * window, libinput holds back device events for up to window_usec
+ * microseconds and releases them to the queue in timestamp order.
+ *
+ * Events from the same device are never reordered. Device added and
+ * removed events release all held-back events first. Held-back events
+ * that become due are released during libinput_dispatch(); libinput
+ * signals the fd returned by libinput_get_fd() when this is needed.
+ *
+ * Every event held back delays delivery by up to the window, callers
+ * should keep it in the order of the kernel's event frame interval. The
+ * maximum window is 100ms.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param window_usec The window in microseconds, or 0 to disable
+ * ordering
+ * @return 0 on success or -1 if the window is out of range or the
+ * ordering stage could not be allocated
+ *
+ * @see libinput_get_event_ordering_window
+ * @see libinput_get_event_ordering_reorder_count
+ */
+int
+libinput_set_event_ordering_window(struct libinput *libinput,
+				   unsigned int window_usec);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @return The event ordering window in microseconds, or 0 if ordering is
+ * disabled
+ *
+ * @see libinput_set_event_ordering_window
+ */
+unsigned int
+libinput_get_event_ordering_window(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Return the number of events that were queued ahead of at least one
+ * event they would have followed without timestamp ordering. This
+ * counter is never reset, callers may sample it to measure how much
+ * reordering happens for a given window.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return The number of reordered events since the context was created
+ *
+ * @see libinput_set_event_ordering_window
+ */
+uint64_t
+libinput_get_event_ordering_reorder_count(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Declare whether the caller consumes events of the given type. By
+ * default, the caller is assumed to consume all event types.
+ *
+ * libinput does not allocate or queue events of types the caller is not
+ * interested in. Where all events a processing stage generates are
+ * unwanted, the stage is disabled for devices added after this call:
+ * - without @ref LIBINPUT_EVENT_POINTER_BUTTON, tapping and middle button
+ *   emulation are unavailable
+ * - without @ref LIBINPUT_EVENT_POINTER_AXIS, touchpads have no scroll
+ *   method
+ * - without any gesture event types, touchpads do not detect swipe and
+ *   pinch gestures and lack the @ref LIBINPUT_DEVICE_CAP_GESTURE
+ *   capability
+ * - without any tablet tool event types, tablet axes are not smoothed
+ *
+ * The configuration interfaces of disabled stages report these features
+ * as unavailable. This call should thus be made immediately after
+ * creating the context, before any devices are added.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param type The event type
+ * @param interested Non-zero if the caller consumes events of this type,
+ * zero otherwise
+ * @return 0 on success or -1 if the event type is invalid
+ *
+ * @see libinput_get_event_interest
+ */
+int
+libinput_set_event_interest(struct libinput *libinput,
+			    enum libinput_event_type type,
+			    int interested);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @param type The event type
+ * @return Non-zero if the caller consumes events of this type, zero if
+ * the caller declared no interest or the event type is invalid
+ *
+ * @see libinput_set_event_interest
+ */
+int
+libinput_get_event_interest(struct libinput *libinput,
+			    enum libinput_event_type type);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable aggregated touch frames. When enabled, multitouch
+ * touchscreens send one event of type @ref
+ * LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME per device sample time instead of
+ * individual @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION, @ref LIBINPUT_EVENT_TOUCH_UP and @ref
+ * LIBINPUT_EVENT_TOUCH_FRAME events. Single-touch touchscreens are
+ * unaffected.
+ *
+ * The change takes effect at the start of the next frame of each device.
+ * Aggregation is disabled by default.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param enable Non-zero to enable aggregated touch frames, zero to
+ * disable them
+ *
+ * @see libinput_get_touch_frame_aggregation
+ */
+void
+libinput_set_touch_frame_aggregation(struct libinput *libinput,
+				     int enable);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @return Non-zero if aggregated touch frames are enabled, zero otherwise
+ *
+ * @see libinput_set_touch_frame_aggregation
+ */
+int
+libinput_get_touch_frame_aggregation(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable tablet motion coalescing. When enabled, an event of
+ * type @ref LIBINPUT_EVENT_TABLET_TOOL_AXIS that is queued directly after
+ * another such event of the same tool replaces the earlier event. The
+ * earlier event's position, pressure and tilt are kept as intermediate
+ * sample, see libinput_event_tablet_tool_get_samples(). The deltas are
+ * accumulated and the changed axes are the union of both events.
+ *
+ * Tip, button and proximity events are never coalesced and end the
+ * sequence, as does any other event in the queue. Events with a wheel
+ * delta are not coalesced.
+ *
+ * Only events still in the queue are merged, a caller that reads events
+ * once per frame gets one axis event per tool per frame. Coalescing is
+ * disabled by default.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param enable Non-zero to enable coalescing, zero to disable it
+ *
+ * @see libinput_get_tablet_motion_coalescing
+ */
+void
+libinput_set_tablet_motion_coalescing(struct libinput *libinput,
+				      int enable);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @return Non-zero if tablet motion coalescing is enabled, zero otherwise
+ *
+ * @see libinput_set_tablet_motion_coalescing
+ */
+int
+libinput_get_tablet_motion_coalescing(struct libinput *libinput);
+
 /**
  * @ingroup base
  *
@@ -3236,6 +4110,91 @@ void
 libinput_log_set_handler(struct libinput *libinput,
 			 libinput_log_handler log_handler);
 
+/**
+ * @ingroup base
+ *
+ * Create a shared memory ring to publish this context's events into, for
+ * a consumer in a different process. The consumer maps the ring with the
+ * reader in libinput-ring.h, which also describes the binary event
+ * format. A context can have at most one ring.
+ *
+ * The ring holds nslots events, rounded up to the next power of two.
+ * Pass the fds returned by libinput_event_ring_get_memfd(),
+ * libinput_event_ring_get_doorbell_fd() and
+ * libinput_event_ring_get_space_fd() to the consumer, e.g. with
+ * SCM_RIGHTS.
+ *
+ * Devices that already exist when the ring is created are announced with
+ * a @ref LIBINPUT_EVENT_DEVICE_ADDED event at the start of the ring, so
+ * the consumer sees every device before its first event. Device ids in
+ * the ring are per ring, a new ring numbers the devices from 1 again.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param nslots The number of events the ring can hold, at most 65536
+ *
+ * @return A new ring or NULL on error
+ *
+ * @see libinput_event_ring_publish
+ */
+struct libinput_event_ring *
+libinput_event_ring_new(struct libinput *libinput, unsigned int nslots);
+
+/**
+ * @ingroup base
+ *
+ * Destroy the ring and close all its fds. A consumer that has the ring
+ * mapped can keep reading the events already published.
+ *
+ * @param ring A ring created with libinput_event_ring_new()
+ */
+void
+libinput_event_ring_destroy(struct libinput_event_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * @param ring A ring created with libinput_event_ring_new()
+ * @return The memfd backing the ring. It is sealed against resizing.
+ */
+int
+libinput_event_ring_get_memfd(struct libinput_event_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * @param ring A ring created with libinput_event_ring_new()
+ * @return An eventfd that libinput signals whenever it published events
+ */
+int
+libinput_event_ring_get_doorbell_fd(struct libinput_event_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * @param ring A ring created with libinput_event_ring_new()
+ * @return An eventfd that the consumer signals whenever it freed up slots
+ * in a full ring. Poll it when libinput_event_ring_publish() left events
+ * in the queue.
+ */
+int
+libinput_event_ring_get_space_fd(struct libinput_event_ring *ring);
+
+/**
+ * @ingroup base
+ *
+ * Move the events in the context's event queue into the ring, in order,
+ * until the queue is empty or the ring is full. Call this instead of
+ * libinput_get_event() after libinput_dispatch(). Each event is destroyed
+ * once published, events without a fixed-size representation (@ref
+ * LIBINPUT_EVENT_RAW_FRAME, @ref LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME)
+ * are dropped. The doorbell is signalled once per call.
+ *
+ * @param ring A ring created with libinput_event_ring_new()
+ * @return The number of events published
+ */
+int
+libinput_event_ring_publish(struct libinput_event_ring *ring);
+
 /**
  * @defgroup seat Initialization and manipulation of seats
  *
@@ -3679,6 +4638,49 @@ libinput_device_get_size(struct libinput_device *device,
 int
 libinput_device_pointer_has_button(struct libinput_device *device, uint32_t code);
 
+/**
+ * @ingroup device
+ *
+ * Predict the accelerated pointer motion of a @ref
+ * LIBINPUT_DEVICE_CAP_POINTER device between its most recent motion event
+ * and the given time. This is intended for callers that position the
+ * cursor for a future point in time, e.g. the time the next frame is
+ * scanned out.
+ *
+ * The prediction is based on the velocity and acceleration of the recent
+ * motion events. No prediction is available if the device has not
+ * moved recently, if its most recent motion changed direction or if the
+ * given time is too far ahead of the most recent motion event. Callers
+ * should not move the cursor ahead in that case.
+ *
+ * The returned delta is in the same coordinate space as
+ * libinput_event_pointer_get_dx() and libinput_event_pointer_get_dy(). The
+ * actual motion is within the error radius around the predicted delta with
+ * the returned confidence, in the range [0, 1]. Callers should weigh
+ * or discard the prediction accordingly.
+ *
+ * The prediction only reflects the events that have been processed with
+ * libinput_dispatch(), the caller should call libinput_dispatch() first.
+ *
+ * @param device A current input device
+ * @param time_usec The time to predict the motion for in microseconds, in
+ * the same clock as the event timestamps
+ * @param[out] dx The predicted x delta
+ * @param[out] dy The predicted y delta
+ * @param[out] error The radius around the predicted delta
+ * @param[out] confidence The confidence in the prediction in [0, 1]
+ *
+ * @return 0 on success or -1 if no prediction is available. On failure,
+ * dx, dy, error and confidence are unmodified.
+ */
+int
+libinput_device_pointer_predict(struct libinput_device *device,
+				uint64_t time_usec,
+				double *dx,
+				double *dy,
+				double *error,
+				double *confidence);
+
 /**
  * @ingroup device
  *
@@ -5241,6 +6243,97 @@ libinput_device_config_dwt_get_enabled(struct libinput_device *device);
 enum libinput_config_dwt_state
 libinput_device_config_dwt_get_default_enabled(struct libinput_device *device);
 
+/**
+ * @ingroup config
+ *
+ * Possible states for the raw mode of a device.
+ */
+enum libinput_config_raw_state {
+	LIBINPUT_CONFIG_RAW_DISABLED,
+	LIBINPUT_CONFIG_RAW_ENABLED,
+};
+
+/**
+ * @ingroup config
+ *
+ * Check if this device can be switched into raw mode.
+ *
+ * @param device The device to configure
+ * @return 0 if this device does not support raw mode, or 1 otherwise.
+ *
+ * @see libinput_device_config_raw_set_enabled
+ * @see libinput_device_config_raw_get_enabled
+ * @see libinput_device_config_raw_get_default_enabled
+ */
+int
+libinput_device_config_raw_is_available(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Enable or disable raw mode. In raw mode, the device's evdev events
+ * bypass all of libinput's processing: there is no pointer acceleration,
+ * hysteresis, button debouncing, middle button emulation, tapping,
+ * scrolling or gesture detection. Instead, each SYN_REPORT-delimited
+ * frame is sent as one event of type @ref LIBINPUT_EVENT_RAW_FRAME. The
+ * device keeps its capabilities, seat and device group.
+ *
+ * When raw mode is enabled, libinput releases any buttons, keys and
+ * touches currently logically down. When raw mode is disabled, state
+ * changes that occurred in raw mode are not replayed, e.g. a key held
+ * down across the switch does not generate a press event.
+ *
+ * @param device The device to configure
+ * @param enable @ref LIBINPUT_CONFIG_RAW_DISABLED to disable raw mode,
+ * @ref LIBINPUT_CONFIG_RAW_ENABLED to enable it
+ *
+ * @return A config status code. Disabling raw mode on a device that does
+ * not support it always succeeds.
+ *
+ * @see libinput_device_config_raw_is_available
+ * @see libinput_device_config_raw_get_enabled
+ * @see libinput_device_config_raw_get_default_enabled
+ */
+enum libinput_config_status
+libinput_device_config_raw_set_enabled(struct libinput_device *device,
+				       enum libinput_config_raw_state enable);
+
+/**
+ * @ingroup config
+ *
+ * Check if raw mode is currently enabled on this device. If the device
+ * does not support raw mode, this function returns @ref
+ * LIBINPUT_CONFIG_RAW_DISABLED.
+ *
+ * @param device The device to configure
+ * @return @ref LIBINPUT_CONFIG_RAW_DISABLED if disabled, @ref
+ * LIBINPUT_CONFIG_RAW_ENABLED if enabled.
+ *
+ * @see libinput_device_config_raw_is_available
+ * @see libinput_device_config_raw_set_enabled
+ * @see libinput_device_config_raw_get_default_enabled
+ */
+enum libinput_config_raw_state
+libinput_device_config_raw_get_enabled(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Check if raw mode is enabled on this device by default. If the device
+ * does not support raw mode, this function returns @ref
+ * LIBINPUT_CONFIG_RAW_DISABLED.
+ *
+ * @param device The device to configure
+ * @return @ref LIBINPUT_CONFIG_RAW_DISABLED if disabled, @ref
+ * LIBINPUT_CONFIG_RAW_ENABLED if enabled.
+ *
+ * @see libinput_device_config_raw_is_available
+ * @see libinput_device_config_raw_set_enabled
+ * @see libinput_device_config_raw_get_enabled
+ */
+enum libinput_config_raw_state
+libinput_device_config_raw_get_default_enabled(struct libinput_device *device);
+
 /**
  * @ingroup config
  *
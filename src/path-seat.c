@@ -39,17 +39,10 @@ static void
 path_disable_device(struct libinput *libinput,
 		    struct evdev_device *device)
 {
-	struct libinput_seat *seat = device->base.seat;
-	struct evdev_device *dev, *next;
-
-	list_for_each_safe(dev, next,
-			   &seat->devices_list, base.link) {
-		if (dev != device)
-			continue;
+	if (device->was_removed)
+		return;
 
-		evdev_device_remove(device);
-		break;
-	}
+	evdev_device_remove(device);
 }
 
 static void
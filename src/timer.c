@@ -31,6 +31,7 @@
 #include <unistd.h>
 
 #include "libinput-private.h"
+#include "libinput-tracepoint.h"
 #include "timer.h"
 
 void
@@ -92,6 +93,7 @@ libinput_timer_set_flags(struct libinput_timer *timer,
 		list_insert(&timer->libinput->timer.list, &timer->link);
 
 	timer->expire = expire;
+	LIBINPUT_PROBE3(timer_arm, timer, timer->timer_func, expire);
 	libinput_timer_arm_timer_fd(timer->libinput);
 }
 
@@ -134,6 +136,11 @@ libinput_timer_handler(void *data)
 
 	list_for_each_safe(timer, tmp, &libinput->timer.list, link) {
 		if (timer->expire <= now) {
+			LIBINPUT_PROBE4(timer_fire,
+					timer,
+					timer->timer_func,
+					timer->expire,
+					now);
 			/* Clear the timer before calling timer_func,
 			   as timer_func may re-arm it */
 			libinput_timer_cancel(timer);
@@ -24,6 +24,7 @@
 
 #include "config.h"
 
+#include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -33,6 +34,11 @@
 #include "evdev.h"
 #include "udev-seat.h"
 
+/* An add that follows an add or remove of the same device within this
+ * time is held back until the device settles, so a device that flaps
+ * (docks, KVM switches) is set up once */
+#define UDEV_HOTPLUG_DEBOUNCE ms2us(20)
+
 static const char default_seat[] = "seat0";
 static const char default_seat_name[] = "default";
 
@@ -111,30 +117,26 @@ device_added(struct udev_device *udev_device,
 static void
 device_removed(struct udev_device *udev_device, struct udev_input *input)
 {
-	struct evdev_device *device, *next;
-	struct udev_seat *seat;
+	struct evdev_device *device;
 	const char *syspath;
 
 	syspath = udev_device_get_syspath(udev_device);
-	list_for_each(seat, &input->base.seat_list, base.link) {
-		list_for_each_safe(device, next,
-				   &seat->base.devices_list, base.link) {
-			if (streq(syspath,
-				  udev_device_get_syspath(device->udev_device))) {
-				evdev_device_remove(device);
-				break;
-			}
-		}
-	}
+	device = evdev_device_find(&input->base, syspath);
+	if (device)
+		evdev_device_remove(device);
 }
 
 static int
-udev_input_add_devices(struct udev_input *input, struct udev *udev)
+udev_enumerate_event_nodes(struct udev *udev,
+			   int (*func)(struct udev_device *udev_device,
+				       void *data),
+			   void *data)
 {
 	struct udev_enumerate *e;
 	struct udev_list_entry *entry;
 	struct udev_device *device;
 	const char *path, *sysname;
+	int rc = 0;
 
 	e = udev_enumerate_new(udev);
 	udev_enumerate_add_match_subsystem(e, "input");
@@ -151,44 +153,226 @@ udev_input_add_devices(struct udev_input *input, struct udev *udev)
 			continue;
 		}
 
-		if (device_added(device, input, NULL) < 0) {
-			udev_device_unref(device);
-			udev_enumerate_unref(e);
-			return -1;
-		}
-
+		rc = func(device, data);
 		udev_device_unref(device);
+		if (rc < 0)
+			break;
 	}
 	udev_enumerate_unref(e);
 
-	return 0;
+	return rc;
 }
 
-static void
-evdev_udev_handler(void *data)
+static int
+udev_input_add_enumerated_device(struct udev_device *udev_device, void *data)
 {
 	struct udev_input *input = data;
-	struct udev_device *udev_device;
-	const char *action;
 
-	udev_device = udev_monitor_receive_device(input->udev_monitor);
-	if (!udev_device)
+	return device_added(udev_device, input, NULL);
+}
+
+static int
+udev_input_add_devices(struct udev_input *input, struct udev *udev)
+{
+	return udev_enumerate_event_nodes(udev,
+					  udev_input_add_enumerated_device,
+					  input);
+}
+
+static struct udev_pending_device *
+udev_pending_find(struct udev_input *input, const char *syspath)
+{
+	struct udev_pending_device *pending;
+
+	list_for_each(pending, &input->pending_devices, link) {
+		if (streq(syspath,
+			  udev_device_get_syspath(pending->udev_device)))
+			return pending;
+	}
+
+	return NULL;
+}
+
+static void
+udev_pending_destroy(struct udev_pending_device *pending)
+{
+	list_remove(&pending->link);
+	udev_device_unref(pending->udev_device);
+	free(pending);
+}
+
+static void
+udev_pending_queue(struct udev_input *input,
+		   struct udev_device *udev_device,
+		   enum udev_pending_action action,
+		   uint64_t now)
+{
+	struct udev_pending_device *pending;
+
+	pending = zalloc(sizeof *pending);
+	if (!pending) {
+		if (action == UDEV_PENDING_ADD)
+			device_added(udev_device, input, NULL);
 		return;
+	}
 
-	action = udev_device_get_action(udev_device);
-	if (!action)
-		goto out;
+	pending->udev_device = udev_device_ref(udev_device);
+	pending->action = action;
+	pending->deadline = now + UDEV_HOTPLUG_DEBOUNCE;
+	/* append, so the list stays sorted by deadline */
+	list_insert(input->pending_devices.prev, &pending->link);
+}
 
-	if (strncmp("event", udev_device_get_sysname(udev_device), 5) != 0)
-		goto out;
+/**
+ * @return true if the device was added right away
+ */
+static bool
+udev_pending_add(struct udev_input *input,
+		 struct udev_device *udev_device,
+		 uint64_t now)
+{
+	struct udev_pending_device *pending;
 
-	if (streq(action, "add"))
+	pending = udev_pending_find(input,
+				    udev_device_get_syspath(udev_device));
+	if (!pending) {
 		device_added(udev_device, input, NULL);
-	else if (streq(action, "remove"))
+		return true;
+	}
+
+	/* The device flaps, hold it back until it settles. The latest
+	 * uevent wins and restarts the timeout */
+	udev_pending_destroy(pending);
+	udev_pending_queue(input, udev_device, UDEV_PENDING_ADD, now);
+
+	return false;
+}
+
+static void
+udev_pending_remove(struct udev_input *input,
+		    struct udev_device *udev_device,
+		    uint64_t now)
+{
+	struct udev_pending_device *pending;
+
+	/* A pending add was never created, drop it. Either way an add
+	 * soon after this remove is held back */
+	pending = udev_pending_find(input,
+				    udev_device_get_syspath(udev_device));
+	if (pending)
+		udev_pending_destroy(pending);
+
+	udev_pending_queue(input, udev_device, UDEV_PENDING_REMOVE, now);
+}
+
+static void
+udev_pending_clear(struct udev_input *input)
+{
+	struct udev_pending_device *pending, *tmp;
+
+	libinput_timer_cancel(&input->hotplug_timer);
+
+	list_for_each_safe(pending, tmp, &input->pending_devices, link)
+		udev_pending_destroy(pending);
+}
+
+static void
+udev_pending_arm_timer(struct udev_input *input)
+{
+	struct udev_pending_device *pending;
+
+	if (list_empty(&input->pending_devices)) {
+		libinput_timer_cancel(&input->hotplug_timer);
+	} else {
+		pending = list_first_entry(&input->pending_devices,
+					   pending,
+					   link);
+		libinput_timer_set(&input->hotplug_timer, pending->deadline);
+	}
+}
+
+static void
+udev_pending_flush(struct udev_input *input, uint64_t now)
+{
+	struct udev_pending_device *pending, *tmp;
+
+	list_for_each_safe(pending, tmp, &input->pending_devices, link) {
+		if (pending->deadline > now)
+			break;
+
+		if (pending->action == UDEV_PENDING_ADD)
+			device_added(pending->udev_device, input, NULL);
+		udev_pending_destroy(pending);
+	}
+
+	udev_pending_arm_timer(input);
+}
+
+static void
+udev_hotplug_timeout(uint64_t now, void *data)
+{
+	struct udev_input *input = data;
+
+	udev_pending_flush(input, now);
+}
+
+/**
+ * @return true if a device was added or removed
+ */
+static bool
+udev_input_handle_uevent(struct udev_input *input,
+			 struct udev_device *udev_device,
+			 const char *action,
+			 uint64_t now)
+{
+	/* Removal of an existing device is immediate, the fd is dead
+	 * anyway. */
+	if (streq(action, "add")) {
+		return udev_pending_add(input, udev_device, now);
+	} else if (streq(action, "remove")) {
+		udev_pending_remove(input, udev_device, now);
 		device_removed(udev_device, input);
+		return true;
+	}
 
-out:
-	udev_device_unref(udev_device);
+	return false;
+}
+
+static struct udev_device *
+udev_monitor_receive_event_node(struct udev_monitor *monitor,
+				const char **action)
+{
+	struct udev_device *udev_device;
+
+	while ((udev_device = udev_monitor_receive_device(monitor))) {
+		*action = udev_device_get_action(udev_device);
+		if (*action &&
+		    strncmp("event", udev_device_get_sysname(udev_device), 5) == 0)
+			break;
+
+		udev_device_unref(udev_device);
+	}
+
+	return udev_device;
+}
+
+static void
+evdev_udev_handler(void *data)
+{
+	struct udev_input *input = data;
+	struct udev_device *udev_device;
+	const char *action;
+	uint64_t now = libinput_now(&input->base);
+
+	/* Drain everything that is queued, a hotplug storm arrives as many
+	 * uevents in quick succession */
+	while ((udev_device = udev_monitor_receive_event_node(input->udev_monitor,
+							      &action))) {
+		udev_input_handle_uevent(input, udev_device, action, now);
+		udev_device_unref(udev_device);
+	}
+
+	udev_pending_flush(input, now);
 }
 
 static void
@@ -212,17 +396,52 @@ udev_input_disable(struct libinput *libinput)
 {
 	struct udev_input *input = (struct udev_input*)libinput;
 
-	if (!input->udev_monitor)
-		return;
+	if (input->shared) {
+		if (!input->shared_enabled)
+			return;
 
-	udev_monitor_unref(input->udev_monitor);
-	input->udev_monitor = NULL;
-	libinput_remove_source(&input->base, input->udev_monitor_source);
-	input->udev_monitor_source = NULL;
+		list_remove(&input->shared_link);
+		input->shared_enabled = false;
+	} else {
+		if (!input->udev_monitor)
+			return;
 
+		udev_monitor_unref(input->udev_monitor);
+		input->udev_monitor = NULL;
+		libinput_remove_source(&input->base,
+				       input->udev_monitor_source);
+		input->udev_monitor_source = NULL;
+	}
+
+	udev_pending_clear(input);
 	udev_input_remove_devices(input);
 }
 
+static int
+udev_input_enable_shared(struct udev_input *input)
+{
+	struct libinput_udev_monitor *monitor = input->shared;
+	struct udev_shared_device *sdev;
+
+	if (input->shared_enabled)
+		return 0;
+
+	list_insert(&monitor->inputs, &input->shared_link);
+	input->shared_enabled = true;
+
+	list_for_each(sdev, &monitor->devices, link) {
+		if (!streq(sdev->seat, input->seat_id))
+			continue;
+
+		if (device_added(sdev->udev_device, input, NULL) < 0) {
+			udev_input_disable(&input->base);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 static int
 udev_input_enable(struct libinput *libinput)
 {
@@ -230,6 +449,9 @@ udev_input_enable(struct libinput *libinput)
 	struct udev *udev = input->udev;
 	int fd;
 
+	if (input->shared)
+		return udev_input_enable_shared(input);
+
 	if (input->udev_monitor)
 		return 0;
 
@@ -278,6 +500,7 @@ udev_input_destroy(struct libinput *input)
 		return;
 
 	udev_unref(udev_input->udev);
+	libinput_udev_monitor_unref(udev_input->shared);
 	free(udev_input->seat_id);
 }
 
@@ -344,6 +567,189 @@ static const struct libinput_interface_backend interface_backend = {
 	.device_change_seat = udev_device_change_seat,
 };
 
+static const char *
+device_get_seat_id(struct udev_device *udev_device)
+{
+	const char *seat;
+
+	seat = udev_device_get_property_value(udev_device, "ID_SEAT");
+
+	return seat ? seat : default_seat;
+}
+
+static struct udev_shared_device *
+udev_shared_device_find(struct libinput_udev_monitor *monitor,
+			const char *syspath)
+{
+	struct udev_shared_device *sdev;
+
+	list_for_each(sdev, &monitor->devices, link) {
+		if (streq(syspath, udev_device_get_syspath(sdev->udev_device)))
+			return sdev;
+	}
+
+	return NULL;
+}
+
+static void
+udev_shared_device_destroy(struct udev_shared_device *sdev)
+{
+	list_remove(&sdev->link);
+	udev_device_unref(sdev->udev_device);
+	free(sdev);
+}
+
+static int
+udev_shared_device_add(struct udev_device *udev_device, void *data)
+{
+	struct libinput_udev_monitor *monitor = data;
+	struct udev_shared_device *sdev;
+
+	sdev = udev_shared_device_find(monitor,
+				       udev_device_get_syspath(udev_device));
+	if (sdev)
+		udev_shared_device_destroy(sdev);
+
+	sdev = zalloc(sizeof *sdev);
+	if (!sdev)
+		return -1;
+
+	sdev->udev_device = udev_device_ref(udev_device);
+	sdev->seat = device_get_seat_id(udev_device);
+	list_insert(monitor->devices.prev, &sdev->link);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT struct libinput_udev_monitor *
+libinput_udev_monitor_new(struct udev *udev)
+{
+	struct libinput_udev_monitor *monitor;
+
+	if (!udev)
+		return NULL;
+
+	monitor = zalloc(sizeof *monitor);
+	if (!monitor)
+		return NULL;
+
+	monitor->refcount = 1;
+	monitor->udev = udev_ref(udev);
+	list_init(&monitor->devices);
+	list_init(&monitor->inputs);
+
+	monitor->udev_monitor = udev_monitor_new_from_netlink(udev, "udev");
+	if (!monitor->udev_monitor)
+		goto err;
+
+	udev_monitor_filter_add_match_subsystem_devtype(monitor->udev_monitor,
+							"input",
+							NULL);
+	if (udev_monitor_enable_receiving(monitor->udev_monitor))
+		goto err;
+
+	if (udev_enumerate_event_nodes(udev,
+				       udev_shared_device_add,
+				       monitor) < 0)
+		goto err;
+
+	return monitor;
+
+err:
+	libinput_udev_monitor_unref(monitor);
+	return NULL;
+}
+
+LIBINPUT_EXPORT struct libinput_udev_monitor *
+libinput_udev_monitor_ref(struct libinput_udev_monitor *monitor)
+{
+	monitor->refcount++;
+	return monitor;
+}
+
+LIBINPUT_EXPORT struct libinput_udev_monitor *
+libinput_udev_monitor_unref(struct libinput_udev_monitor *monitor)
+{
+	struct udev_shared_device *sdev, *tmp;
+
+	if (monitor == NULL)
+		return NULL;
+
+	assert(monitor->refcount > 0);
+	monitor->refcount--;
+	if (monitor->refcount > 0)
+		return monitor;
+
+	/* every context holds a reference */
+	assert(list_empty(&monitor->inputs));
+
+	list_for_each_safe(sdev, tmp, &monitor->devices, link)
+		udev_shared_device_destroy(sdev);
+
+	if (monitor->udev_monitor)
+		udev_monitor_unref(monitor->udev_monitor);
+	udev_unref(monitor->udev);
+	free(monitor);
+
+	return NULL;
+}
+
+LIBINPUT_EXPORT int
+libinput_udev_monitor_get_fd(struct libinput_udev_monitor *monitor)
+{
+	return udev_monitor_get_fd(monitor->udev_monitor);
+}
+
+LIBINPUT_EXPORT int
+libinput_udev_monitor_dispatch(struct libinput_udev_monitor *monitor)
+{
+	struct udev_device *udev_device;
+	struct udev_input *input;
+	const char *action, *seat;
+
+	while ((udev_device = udev_monitor_receive_event_node(monitor->udev_monitor,
+							      &action))) {
+		seat = device_get_seat_id(udev_device);
+
+		if (streq(action, "add")) {
+			udev_shared_device_add(udev_device, monitor);
+		} else if (streq(action, "remove")) {
+			struct udev_shared_device *sdev;
+
+			sdev = udev_shared_device_find(monitor,
+						       udev_device_get_syspath(udev_device));
+			if (sdev)
+				udev_shared_device_destroy(sdev);
+		}
+
+		list_for_each(input, &monitor->inputs, shared_link) {
+			uint64_t now;
+
+			if (!streq(seat, input->seat_id))
+				continue;
+
+			now = libinput_now(&input->base);
+			if (udev_input_handle_uevent(input,
+						     udev_device,
+						     action,
+						     now)) {
+				/* The added or removed event is already
+				 * queued, fire the timer so the context's
+				 * fd wakes up the caller */
+				libinput_timer_set_flags(&input->hotplug_timer,
+							 now,
+							 TIMER_FLAG_ALLOW_NEGATIVE);
+			} else {
+				udev_pending_arm_timer(input);
+			}
+		}
+
+		udev_device_unref(udev_device);
+	}
+
+	return 0;
+}
+
 LIBINPUT_EXPORT struct libinput *
 libinput_udev_create_context(const struct libinput_interface *interface,
 			     void *user_data,
@@ -366,6 +772,11 @@ libinput_udev_create_context(const struct libinput_interface *interface,
 	}
 
 	input->udev = udev_ref(udev);
+	list_init(&input->pending_devices);
+	libinput_timer_init(&input->hotplug_timer,
+			    &input->base,
+			    udev_hotplug_timeout,
+			    input);
 
 	return &input->base;
 }
@@ -394,3 +805,30 @@ libinput_udev_assign_seat(struct libinput *libinput,
 
 	return 0;
 }
+
+LIBINPUT_EXPORT int
+libinput_udev_assign_seat_shared(struct libinput *libinput,
+				 const char *seat_id,
+				 struct libinput_udev_monitor *monitor)
+{
+	struct udev_input *input = (struct udev_input*)libinput;
+
+	if (!seat_id || !monitor)
+		return -1;
+
+	if (libinput->interface_backend != &interface_backend) {
+		log_bug_client(libinput, "Mismatching backends.\n");
+		return -1;
+	}
+
+	if (input->seat_id != NULL)
+		return -1;
+
+	input->seat_id = strdup(seat_id);
+	input->shared = libinput_udev_monitor_ref(monitor);
+
+	if (udev_input_enable(&input->base) < 0)
+		return -1;
+
+	return 0;
+}
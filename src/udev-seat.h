@@ -28,17 +28,55 @@
 
 #include <libudev.h>
 #include "libinput-private.h"
+#include "timer.h"
 
 struct udev_seat {
 	struct libinput_seat base;
 };
 
+enum udev_pending_action {
+	UDEV_PENDING_ADD,	/* a held back "add", created at the deadline */
+	UDEV_PENDING_REMOVE,	/* a recent "remove", holds back the next add */
+};
+
+/* A uevent waiting for the hotplug debounce timeout */
+struct udev_pending_device {
+	struct list link;
+	struct udev_device *udev_device;
+	enum udev_pending_action action;
+	uint64_t deadline;
+};
+
 struct udev_input {
 	struct libinput base;
 	struct udev *udev;
 	struct udev_monitor *udev_monitor;
 	struct libinput_source *udev_monitor_source;
 	char *seat_id;
+
+	struct list pending_devices; /* oldest deadline first */
+	struct libinput_timer hotplug_timer;
+
+	/* Set if assigned with libinput_udev_assign_seat_shared(), then
+	 * udev_monitor is always NULL */
+	struct libinput_udev_monitor *shared;
+	struct list shared_link; /* libinput_udev_monitor.inputs */
+	bool shared_enabled;
+};
+
+/* A device known to a shared monitor */
+struct udev_shared_device {
+	struct list link;
+	struct udev_device *udev_device;
+	const char *seat; /* ID_SEAT, owned by udev_device */
+};
+
+struct libinput_udev_monitor {
+	int refcount;
+	struct udev *udev;
+	struct udev_monitor *udev_monitor;
+	struct list devices; /* udev_shared_device, kept current */
+	struct list inputs; /* enabled udev_inputs */
 };
 
 #endif
@@ -0,0 +1,385 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+#include "libinput-util.h"
+#include "uring.h"
+
+/* Without fast poll (5.7) a read on an fd with no data pins an io-wq
+ * worker thread, one per device. Not worth it, use epoll instead. */
+#if HAVE_LINUX_IO_URING_H && defined(IORING_FEAT_FAST_POLL) && \
+    defined(__NR_io_uring_setup)
+
+/* Tags the completions of our internal requests (the poll in front of
+ * each read and the cancel requests), the callers never see those */
+#define URING_INTERNAL 0x1
+
+struct uring {
+	int fd;
+	uint32_t features;
+
+	void *sq_map;
+	size_t sq_map_size;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_entries;
+	unsigned *sq_flags;
+	unsigned *sq_array;
+	unsigned sq_local_tail;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	void *cq_map;
+	size_t cq_map_size;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+};
+
+static inline int
+sys_io_uring_setup(unsigned int entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static inline int
+sys_io_uring_enter(int fd,
+		   unsigned int to_submit,
+		   unsigned int min_complete,
+		   unsigned int flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, NULL, 0);
+}
+
+struct uring *
+uring_new(unsigned int entries)
+{
+	struct io_uring_params p;
+	struct uring *ring;
+	char *sq, *cq;
+
+	ring = zalloc(sizeof *ring);
+	if (!ring)
+		return NULL;
+
+	memset(&p, 0, sizeof p);
+	ring->fd = sys_io_uring_setup(entries, &p);
+	if (ring->fd < 0) {
+		free(ring);
+		return NULL;
+	}
+
+	ring->features = p.features;
+	if (!(ring->features & IORING_FEAT_FAST_POLL))
+		goto err;
+
+	ring->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_map_size = p.cq_off.cqes +
+			    p.cq_entries * sizeof(struct io_uring_cqe);
+	if (ring->features & IORING_FEAT_SINGLE_MMAP) {
+		ring->sq_map_size = max(ring->sq_map_size, ring->cq_map_size);
+		ring->cq_map_size = ring->sq_map_size;
+	}
+
+	ring->sq_map = mmap(NULL, ring->sq_map_size,
+			    PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			    ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sq_map == MAP_FAILED) {
+		ring->sq_map = NULL;
+		goto err;
+	}
+
+	if (ring->features & IORING_FEAT_SINGLE_MMAP) {
+		ring->cq_map = ring->sq_map;
+	} else {
+		ring->cq_map = mmap(NULL, ring->cq_map_size,
+				    PROT_READ|PROT_WRITE,
+				    MAP_SHARED|MAP_POPULATE,
+				    ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cq_map == MAP_FAILED) {
+			ring->cq_map = NULL;
+			goto err;
+		}
+	}
+
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size,
+			  PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE,
+			  ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED) {
+		ring->sqes = NULL;
+		goto err;
+	}
+
+	sq = ring->sq_map;
+	ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+	ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	ring->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	ring->sq_entries = (unsigned *)(sq + p.sq_off.ring_entries);
+	ring->sq_flags = (unsigned *)(sq + p.sq_off.flags);
+	ring->sq_array = (unsigned *)(sq + p.sq_off.array);
+	ring->sq_local_tail = *ring->sq_tail;
+
+	cq = ring->cq_map;
+	ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+	ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	ring->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return ring;
+
+err:
+	uring_destroy(ring);
+	return NULL;
+}
+
+void
+uring_destroy(struct uring *ring)
+{
+	if (!ring)
+		return;
+
+	if (ring->sqes)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_map && ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_map_size);
+	if (ring->sq_map)
+		munmap(ring->sq_map, ring->sq_map_size);
+	close(ring->fd);
+	free(ring);
+}
+
+int
+uring_get_fd(struct uring *ring)
+{
+	return ring->fd;
+}
+
+static inline unsigned int
+uring_sq_space(struct uring *ring)
+{
+	unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+	return *ring->sq_entries - (ring->sq_local_tail - head);
+}
+
+/* Makes sure there are n free SQEs, submitting what's queued if
+ * necessary, so a linked chain is never split across a full ring */
+static inline bool
+uring_reserve(struct uring *ring, unsigned int n)
+{
+	if (uring_sq_space(ring) >= n)
+		return true;
+
+	uring_submit(ring, 0);
+
+	return uring_sq_space(ring) >= n;
+}
+
+static inline struct io_uring_sqe *
+uring_get_sqe(struct uring *ring)
+{
+	unsigned idx = ring->sq_local_tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[idx];
+
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq_array[idx] = idx;
+	ring->sq_local_tail++;
+
+	return sqe;
+}
+
+bool
+uring_queue_read(struct uring *ring,
+		 int fd,
+		 void *buf,
+		 size_t len,
+		 uint64_t user_data)
+{
+	struct io_uring_sqe *sqe;
+
+	assert((user_data & URING_INTERNAL) == 0);
+
+	if (!uring_reserve(ring, 2))
+		return false;
+
+	/* Our fds are O_NONBLOCK, so a plain read would complete with
+	 * -EAGAIN right away. Put a poll in front and link the read to it.
+	 * The poll's completion is of no interest, if it fails the read
+	 * completes with -ECANCELED. Don't be tempted by
+	 * IOSQE_CQE_SKIP_SUCCESS here, a failed head with that flag
+	 * swallows the completions of the linked requests and we'd never
+	 * learn that the read buffer is free. */
+	sqe = uring_get_sqe(ring);
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = fd;
+	sqe->poll_events = POLLIN;
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = user_data | URING_INTERNAL;
+
+	sqe = uring_get_sqe(ring);
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)buf;
+	sqe->len = len;
+	sqe->off = (uint64_t)-1;
+	sqe->user_data = user_data;
+
+	return true;
+}
+
+bool
+uring_queue_cancel(struct uring *ring, uint64_t user_data)
+{
+	struct io_uring_sqe *sqe;
+
+	if (!uring_reserve(ring, 1))
+		return false;
+
+	/* Canceling the poll cancels the linked read too */
+	sqe = uring_get_sqe(ring);
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = user_data | URING_INTERNAL;
+	sqe->user_data = URING_INTERNAL;
+
+	return true;
+}
+
+int
+uring_submit(struct uring *ring, unsigned int min_complete)
+{
+	unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+	unsigned to_submit = ring->sq_local_tail - head;
+	unsigned flags = 0;
+	int rc;
+
+	__atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+	if (min_complete > 0)
+		flags |= IORING_ENTER_GETEVENTS;
+#ifdef IORING_SQ_CQ_OVERFLOW
+	/* With IORING_FEAT_NODROP completions that didn't fit into the CQ
+	 * ring are held back until we enter the kernel for them */
+	if (__atomic_load_n(ring->sq_flags, __ATOMIC_RELAXED) &
+	    IORING_SQ_CQ_OVERFLOW)
+		flags |= IORING_ENTER_GETEVENTS;
+#endif
+
+	if (to_submit == 0 && flags == 0)
+		return 0;
+
+	rc = sys_io_uring_enter(ring->fd, to_submit, min_complete, flags);
+
+	return rc < 0 ? -errno : rc;
+}
+
+bool
+uring_next_completion(struct uring *ring, uint64_t *user_data, int *res)
+{
+	unsigned head = *ring->cq_head;
+
+	while (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+		struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+		uint64_t data = cqe->user_data;
+		int result = cqe->res;
+
+		head++;
+		__atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+		if (data & URING_INTERNAL)
+			continue;
+
+		*user_data = data;
+		*res = result;
+		return true;
+	}
+
+	return false;
+}
+
+#else /* HAVE_LINUX_IO_URING_H */
+
+struct uring *
+uring_new(unsigned int entries)
+{
+	return NULL;
+}
+
+void
+uring_destroy(struct uring *ring)
+{
+}
+
+int
+uring_get_fd(struct uring *ring)
+{
+	return -1;
+}
+
+bool
+uring_queue_read(struct uring *ring,
+		 int fd,
+		 void *buf,
+		 size_t len,
+		 uint64_t user_data)
+{
+	return false;
+}
+
+bool
+uring_queue_cancel(struct uring *ring, uint64_t user_data)
+{
+	return false;
+}
+
+int
+uring_submit(struct uring *ring, unsigned int min_complete)
+{
+	return -ENOSYS;
+}
+
+bool
+uring_next_completion(struct uring *ring, uint64_t *user_data, int *res)
+{
+	return false;
+}
+
+#endif /* HAVE_LINUX_IO_URING_H */
@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef URING_H
+#define URING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* A minimal io_uring wrapper, just enough to keep a read queued on each
+ * device fd and harvest all completions in one go. */
+struct uring;
+
+/**
+ * Returns NULL if io_uring isn't available or lacks the features we
+ * need, in which case the caller should stick to epoll.
+ */
+struct uring *
+uring_new(unsigned int entries);
+
+void
+uring_destroy(struct uring *ring);
+
+/**
+ * The ring fd is readable whenever there are completions to harvest.
+ */
+int
+uring_get_fd(struct uring *ring);
+
+/**
+ * Queue a read of up to len bytes from fd into buf, to be issued once fd
+ * is readable. user_data must have the lowest bit clear, it is returned
+ * with the completion and identifies the read for uring_queue_cancel().
+ */
+bool
+uring_queue_read(struct uring *ring,
+		 int fd,
+		 void *buf,
+		 size_t len,
+		 uint64_t user_data);
+
+bool
+uring_queue_cancel(struct uring *ring, uint64_t user_data);
+
+/**
+ * Submit all queued requests and wait for at least min_complete
+ * completions. Returns the number of requests submitted or a negative
+ * errno.
+ */
+int
+uring_submit(struct uring *ring, unsigned int min_complete);
+
+/**
+ * Pop the next completion. res is the number of bytes read or a negative
+ * errno, -ECANCELED for a canceled read.
+ */
+bool
+uring_next_completion(struct uring *ring, uint64_t *user_data, int *res);
+
+#endif
@@ -2409,6 +2409,9 @@ litest_event_type_str(enum libinput_event_type type)
 	case LIBINPUT_EVENT_TOUCH_FRAME:
 		str = "TOUCH FRAME";
 		break;
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+		str = "TOUCH AGGREGATE FRAME";
+		break;
 	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
 		str = "GESTURE SWIPE START";
 		break;
@@ -2451,6 +2454,9 @@ litest_event_type_str(enum libinput_event_type type)
 	case LIBINPUT_EVENT_SWITCH_TOGGLE:
 		str = "SWITCH TOGGLE";
 		break;
+	case LIBINPUT_EVENT_RAW_FRAME:
+		str = "RAW FRAME";
+		break;
 	}
 	return str;
 }
@@ -2900,6 +2906,7 @@ litest_is_touch_event(struct libinput_event *event,
 	case LIBINPUT_EVENT_TOUCH_UP:
 	case LIBINPUT_EVENT_TOUCH_MOTION:
 	case LIBINPUT_EVENT_TOUCH_FRAME:
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
 		litest_assert_event_type(event, type);
 		break;
 	default:
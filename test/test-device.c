@@ -502,6 +502,108 @@ START_TEST(device_disable_release_buttons)
 }
 END_TEST
 
+START_TEST(device_raw_config)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	enum libinput_config_status status;
+
+	ck_assert_int_ne(libinput_device_config_raw_is_available(device), 0);
+	ck_assert_int_eq(libinput_device_config_raw_get_enabled(device),
+			 LIBINPUT_CONFIG_RAW_DISABLED);
+	ck_assert_int_eq(libinput_device_config_raw_get_default_enabled(device),
+			 LIBINPUT_CONFIG_RAW_DISABLED);
+
+	status = libinput_device_config_raw_set_enabled(device, 3);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_INVALID);
+
+	status = libinput_device_config_raw_set_enabled(device,
+					LIBINPUT_CONFIG_RAW_ENABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	ck_assert_int_eq(libinput_device_config_raw_get_enabled(device),
+			 LIBINPUT_CONFIG_RAW_ENABLED);
+
+	status = libinput_device_config_raw_set_enabled(device,
+					LIBINPUT_CONFIG_RAW_DISABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	ck_assert_int_eq(libinput_device_config_raw_get_enabled(device),
+			 LIBINPUT_CONFIG_RAW_DISABLED);
+}
+END_TEST
+
+START_TEST(device_raw_frames)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput_event *event;
+	struct libinput_event_raw *rawevent;
+	const struct input_event *events;
+	size_t nevents;
+	enum libinput_config_status status;
+
+	litest_button_click(dev, BTN_LEFT, true);
+	litest_drain_events(li);
+
+	/* switching to raw mode releases the button */
+	status = libinput_device_config_raw_set_enabled(device,
+					LIBINPUT_CONFIG_RAW_ENABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_RELEASED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_REL, REL_Y, -2);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	/* the button release frame */
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_RAW_FRAME);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_RAW_FRAME);
+	rawevent = libinput_event_get_raw_event(event);
+	ck_assert(libinput_event_raw_get_base_event(rawevent) == event);
+	ck_assert_int_ne(libinput_event_raw_get_time_usec(rawevent), 0);
+	events = libinput_event_raw_get_events(rawevent, &nevents);
+	ck_assert_int_eq(nevents, 3);
+	ck_assert_int_eq(events[0].type, EV_REL);
+	ck_assert_int_eq(events[0].code, REL_X);
+	ck_assert_int_eq(events[0].value, 1);
+	ck_assert_int_eq(events[1].type, EV_REL);
+	ck_assert_int_eq(events[1].code, REL_Y);
+	ck_assert_int_eq(events[1].value, -2);
+	ck_assert_int_eq(events[2].type, EV_SYN);
+	ck_assert_int_eq(events[2].code, SYN_REPORT);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* and back to processed events */
+	status = libinput_device_config_raw_set_enabled(device,
+					LIBINPUT_CONFIG_RAW_DISABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_REL, REL_Y, -2);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_motion_event(event);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 START_TEST(device_disable_release_keys)
 {
 	struct litest_device *dev = litest_current_device();
@@ -1617,6 +1719,8 @@ litest_setup_tests_device(void)
 	litest_add_no_device("device:sendevents", device_reenable_device_removed);
 	litest_add_for_device("device:sendevents", device_disable_release_buttons, LITEST_MOUSE);
 	litest_add_for_device("device:sendevents", device_disable_release_keys, LITEST_KEYBOARD);
+	litest_add("device:raw", device_raw_config, LITEST_ANY, LITEST_ANY);
+	litest_add_for_device("device:raw", device_raw_frames, LITEST_MOUSE);
 	litest_add("device:sendevents", device_disable_release_tap, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("device:sendevents", device_disable_release_tap_n_drag, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("device:sendevents", device_disable_release_softbutton, LITEST_CLICKPAD, LITEST_APPLE_CLICKPAD);
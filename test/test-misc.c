@@ -28,10 +28,13 @@
 #include <fcntl.h>
 #include <libinput.h>
 #include <libinput-util.h>
+#include <libinput-ring.h>
+#include <poll.h>
 #include <unistd.h>
 
 #include "litest.h"
 #include "libinput-util.h"
+#include "evdev-model-quirks.h"
 
 static int open_restricted(const char *path, int flags, void *data)
 {
@@ -690,6 +693,67 @@ START_TEST(matrix_helpers)
 }
 END_TEST
 
+START_TEST(matrix_batch_helpers)
+{
+	struct matrix m;
+	int x[11], y[11];
+	int ref_x, ref_y;
+	float f[6] = { 0.5, -0.3, 10, 0.25, 1.7, -20 };
+	size_t count, i;
+
+	matrix_from_farray6(&m, f);
+
+	/* all counts up to a few full vectors plus a remainder */
+	for (count = 0; count <= ARRAY_LENGTH(x); count++) {
+		for (i = 0; i < count; i++) {
+			x[i] = 100 + i * 37;
+			y[i] = 2000 - i * 113;
+		}
+
+		matrix_mult_vec_batch(&m, x, y, count);
+
+		for (i = 0; i < count; i++) {
+			ref_x = 100 + i * 37;
+			ref_y = 2000 - i * 113;
+			matrix_mult_vec(&m, &ref_x, &ref_y);
+			ck_assert_int_eq(x[i], ref_x);
+			ck_assert_int_eq(y[i], ref_y);
+		}
+	}
+}
+END_TEST
+
+START_TEST(hysteresis_batch_helpers)
+{
+	/* within margin, beyond margin in both directions, on the
+	   margin, unchanged, and one past a full vector */
+	int x[] =          { 100, 110,  90, 103, 100, 100 };
+	int y[] =          { 200, 200, 200, 200, 200, 220 };
+	int center_x[] =   { 101, 100, 100, 100, 100, 100 };
+	int center_y[] =   { 199, 200, 200, 200, 200, 200 };
+	int expected_x[] = { 101, 107,  93, 100, 100, 100 };
+	int expected_y[] = { 199, 200, 200, 200, 200, 217 };
+	bool expected_unchanged[] = { false, false, false, false, true, false };
+	int in_x[ARRAY_LENGTH(x)], in_y[ARRAY_LENGTH(y)];
+	bool unchanged[ARRAY_LENGTH(x)];
+	size_t i;
+
+	memcpy(in_x, x, sizeof(x));
+	memcpy(in_y, y, sizeof(y));
+
+	hysteresis_batch(x, y, center_x, center_y, 3, 3,
+			 unchanged, ARRAY_LENGTH(x));
+
+	for (i = 0; i < ARRAY_LENGTH(x); i++) {
+		ck_assert_int_eq(x[i], expected_x[i]);
+		ck_assert_int_eq(y[i], expected_y[i]);
+		ck_assert_int_eq(center_x[i], in_x[i]);
+		ck_assert_int_eq(center_y[i], in_y[i]);
+		ck_assert_int_eq(unchanged[i], expected_unchanged[i]);
+	}
+}
+END_TEST
+
 START_TEST(ratelimit_helpers)
 {
 	struct ratelimit rl;
@@ -1044,6 +1108,44 @@ START_TEST(pressure_range_prop_parser)
 }
 END_TEST
 
+START_TEST(model_quirks_table)
+{
+	const char *x230 = "libinput:name:SynPS/2 Synaptics TouchPad:"
+			   "dmi:bvnLENOVO:bvrG2ET86WW(2.06):bd11/13/2012:"
+			   "svnLENOVO:pn23252FG:pvrThinkPadX230:rvnLENOVO:"
+			   "rn23252FG:rvrWin8STDDPO:cvnLENOVO:ct10:cvrNotAvailable:";
+	const char *x220 = "libinput:name:SynPS/2 Synaptics TouchPad:"
+			   "dmi:bvnLENOVO:bvr8DET69WW(1.39):bd07/18/2013:"
+			   "svnLENOVO:pn4286CTO:pvrThinkPadX220:rvnLENOVO:"
+			   "rn4286CTO:rvrNotAvailable:cvnLENOVO:ct10:cvrNotAvailable:";
+	uint64_t key;
+
+	/* libinput:mouse:input:b0003v046DpC408* */
+	key = model_quirk_id_key(MODEL_QUIRK_MOUSE, 0x3, 0x46d, 0xc408);
+	ck_assert_int_eq(model_quirk_id_lookup(key),
+			 EVDEV_MODEL_LOGITECH_MARBLE_MOUSE);
+	key = model_quirk_id_key(MODEL_QUIRK_TOUCHPAD, 0x3, 0x46d, 0xc408);
+	ck_assert_int_eq(model_quirk_id_lookup(key), 0);
+	key = model_quirk_id_key(MODEL_QUIRK_MOUSE, 0x3, 0x46d, 0xc409);
+	ck_assert_int_eq(model_quirk_id_lookup(key), 0);
+
+	/* libinput:touchpad:input:b0003v05ACp* */
+	key = model_quirk_id_key(MODEL_QUIRK_TOUCHPAD, 0x3, 0x5ac, 0) |
+		MODEL_QUIRK_ANY_PRODUCT;
+	ck_assert_int_eq(model_quirk_id_lookup(key),
+			 EVDEV_MODEL_APPLE_TOUCHPAD);
+	/* libinput:touchpad:input:b0003v05ACp021A* */
+	key = model_quirk_id_key(MODEL_QUIRK_TOUCHPAD, 0x3, 0x5ac, 0x21a);
+	ck_assert_int_eq(model_quirk_id_lookup(key),
+			 EVDEV_MODEL_APPLE_TOUCHPAD_ONEBUTTON);
+
+	/* libinput:name:SynPS/2 Synaptics TouchPad:dmi:*svnLENOVO:*:pvrThinkPadX230* */
+	ck_assert_int_eq(model_quirk_glob_lookup(x230),
+			 EVDEV_MODEL_LENOVO_X230);
+	ck_assert_int_eq(model_quirk_glob_lookup(x220), 0);
+}
+END_TEST
+
 START_TEST(time_conversion)
 {
 	ck_assert_int_eq(us(10), 10);
@@ -1259,6 +1361,736 @@ START_TEST(fd_no_event_leak)
 }
 END_TEST
 
+START_TEST(dispatch_budget)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_device *keyboard;
+	struct libinput_event *event;
+	enum libinput_event_type type;
+	int nmotion = 0, nmotion_before_key = -1;
+	int i;
+
+	ck_assert_int_gt(libinput_get_dispatch_budget(li), 0);
+	libinput_set_dispatch_budget(li, 0);
+	ck_assert_int_eq(libinput_get_dispatch_budget(li), 0);
+	/* 3 events is one REL_X/SYN_REPORT frame and a bit */
+	libinput_set_dispatch_budget(li, 3);
+	ck_assert_int_eq(libinput_get_dispatch_budget(li), 3);
+
+	keyboard = litest_add_device(li, LITEST_KEYBOARD);
+	litest_drain_events(li);
+
+	for (i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_keyboard_key(keyboard, KEY_A, true);
+	litest_keyboard_key(keyboard, KEY_A, false);
+
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		type = libinput_event_get_type(event);
+		if (type == LIBINPUT_EVENT_POINTER_MOTION)
+			nmotion++;
+		else if (type == LIBINPUT_EVENT_KEYBOARD_KEY &&
+			 nmotion_before_key == -1)
+			nmotion_before_key = nmotion;
+		libinput_event_destroy(event);
+	}
+
+	/* the keyboard must not wait for the mouse to drain but no
+	 * events may get lost either */
+	ck_assert_int_ge(nmotion_before_key, 0);
+	ck_assert_int_le(nmotion_before_key, 1);
+	ck_assert_int_eq(nmotion, 10);
+
+	litest_delete_device(keyboard);
+}
+END_TEST
+
+START_TEST(dispatch_event_ordering)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_device *keyboard;
+	struct libinput_event *event;
+	int nmotion = 0;
+
+	ck_assert_int_eq(libinput_get_event_ordering_window(li), 0);
+	ck_assert_int_eq(libinput_set_event_ordering_window(li, ms2us(1000)),
+			 -1);
+	ck_assert_int_eq(libinput_get_event_ordering_window(li), 0);
+	ck_assert_int_eq(libinput_set_event_ordering_window(li, ms2us(10)),
+			 0);
+	ck_assert_int_eq(libinput_get_event_ordering_window(li), ms2us(10));
+
+	keyboard = litest_add_device(li, LITEST_KEYBOARD);
+	litest_drain_events(li);
+
+	/* Whichever device libinput reads first, the key happened first */
+	litest_keyboard_key(keyboard, KEY_A, true);
+	msleep(2);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+
+	libinput_dispatch(li);
+	msleep(15);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event,
+				 KEY_A,
+				 LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	while ((event = libinput_get_event(li))) {
+		ck_assert_int_eq(libinput_event_get_type(event),
+				 LIBINPUT_EVENT_POINTER_MOTION);
+		nmotion++;
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_eq(nmotion, 2);
+
+	/* Disabling releases everything held back */
+	litest_keyboard_key(keyboard, KEY_A, false);
+	libinput_dispatch(li);
+	ck_assert_int_eq(libinput_set_event_ordering_window(li, 0), 0);
+	ck_assert_int_eq(libinput_get_event_ordering_window(li), 0);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_KEYBOARD_KEY);
+
+	litest_delete_device(keyboard);
+}
+END_TEST
+
+static uint64_t
+frame_deadline(unsigned int ms)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return s2us(ts.tv_sec) + ns2us(ts.tv_nsec) + ms2us(ms);
+}
+
+START_TEST(dispatch_coalesced)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	uint64_t deadline;
+	int i;
+
+	litest_drain_events(li);
+
+	deadline = frame_deadline(50);
+
+	for (i = 0; i < 3; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_button_click(dev, BTN_LEFT, true);
+	for (i = 0; i < 2; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	ck_assert_int_eq(libinput_dispatch_coalesced(li, deadline), 0);
+
+	/* The button releases the motion before it, merged into one */
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	litest_assert_double_eq(
+		libinput_event_pointer_get_dx_unaccelerated(ptrev), 3.0);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+
+	/* The rest goes out shortly before the deadline */
+	msleep(50);
+	ck_assert_int_eq(libinput_dispatch_coalesced(li, deadline), 0);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	litest_assert_double_eq(
+		libinput_event_pointer_get_dx_unaccelerated(ptrev), 2.0);
+	libinput_event_destroy(event);
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+
+	/* A plain dispatch releases everything */
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	ck_assert_int_eq(libinput_dispatch_coalesced(li, frame_deadline(50)),
+			 0);
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_BUTTON);
+}
+END_TEST
+
+static int io_uring_syn_dropped;
+
+static void
+io_uring_log_handler(struct libinput *libinput,
+		     enum libinput_log_priority priority,
+		     const char *format,
+		     va_list args)
+{
+	if (strstr(format, "SYN_DROPPED"))
+		io_uring_syn_dropped++;
+}
+
+START_TEST(io_uring_reads)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	struct libinput_event *event;
+	int nmotion = 0;
+	int i;
+
+	ck_assert_int_eq(libinput_get_io_uring(li), 0);
+	ck_assert_int_eq(libinput_set_io_uring(li, 0), 0);
+
+	/* kernel without io_uring, nothing to test */
+	if (libinput_set_io_uring(li, 1) != 0) {
+		ck_assert_int_eq(libinput_get_io_uring(li), 0);
+		libinput_unref(li);
+		return;
+	}
+	ck_assert_int_ne(libinput_get_io_uring(li), 0);
+
+	dev = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	/* devices are on the ring now */
+	ck_assert_int_eq(libinput_set_io_uring(li, 0), -1);
+	ck_assert_int_ne(libinput_get_io_uring(li), 0);
+
+	/* more than one read's worth, each frame is two events */
+	for (i = 0; i < 50; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		ck_assert_int_eq(libinput_event_get_type(event),
+				 LIBINPUT_EVENT_POINTER_MOTION);
+		nmotion++;
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_eq(nmotion, 50);
+
+	litest_button_click(dev, BTN_LEFT, true);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_PRESSED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_RELEASED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(io_uring_budget)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *dev1, *dev2;
+	struct libinput_event *event;
+	int nmotion = 0;
+	int i;
+
+	if (libinput_set_io_uring(li, 1) != 0) {
+		libinput_unref(li);
+		return;
+	}
+
+	/* one event per read and one completion per round */
+	libinput_set_dispatch_budget(li, 1);
+
+	dev1 = litest_add_device(li, LITEST_MOUSE);
+	dev2 = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	for (i = 0; i < 20; i++) {
+		litest_event(dev1, EV_REL, REL_X, 1);
+		litest_event(dev1, EV_SYN, SYN_REPORT, 0);
+		litest_event(dev2, EV_REL, REL_Y, 1);
+		litest_event(dev2, EV_SYN, SYN_REPORT, 0);
+	}
+
+	/* the rounds still drain everything in one dispatch */
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		ck_assert_int_eq(libinput_event_get_type(event),
+				 LIBINPUT_EVENT_POINTER_MOTION);
+		nmotion++;
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_eq(nmotion, 40);
+
+	litest_delete_device(dev1);
+	litest_delete_device(dev2);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(io_uring_syn_dropped)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	struct libinput_event *event;
+	int npressed = 0;
+	int i;
+
+	if (libinput_set_io_uring(li, 1) != 0) {
+		libinput_unref(li);
+		return;
+	}
+
+	libinput_log_set_handler(li, io_uring_log_handler);
+	libinput_log_set_priority(li, LIBINPUT_LOG_PRIORITY_INFO);
+	io_uring_syn_dropped = 0;
+
+	dev = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	/* The first read completes in the kernel, everything after that
+	 * sits in the evdev buffer until we dispatch and overflows it. The
+	 * button press is likely lost and must come back through the
+	 * resync. */
+	for (i = 0; i < 200; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	for (i = 0; i < 200; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+
+	libinput_dispatch(li);
+	ck_assert_int_gt(io_uring_syn_dropped, 0);
+
+	while ((event = libinput_get_event(li))) {
+		switch (libinput_event_get_type(event)) {
+		case LIBINPUT_EVENT_POINTER_MOTION:
+			break;
+		case LIBINPUT_EVENT_POINTER_BUTTON:
+			litest_is_button_event(event,
+					       BTN_LEFT,
+					       LIBINPUT_BUTTON_STATE_PRESSED);
+			npressed++;
+			break;
+		default:
+			ck_abort();
+		}
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_eq(npressed, 1);
+
+	/* back in sync, reads continue on the ring */
+	litest_button_click(dev, BTN_LEFT, false);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_RELEASED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(event_interest)
+{
+	struct libinput *li = litest_create_context();
+
+	ck_assert_int_ne(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_KEYBOARD_KEY),
+			 0);
+	ck_assert_int_ne(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_SWITCH_TOGGLE),
+			 0);
+	ck_assert_int_eq(libinput_get_event_interest(li, LIBINPUT_EVENT_NONE),
+			 0);
+
+	ck_assert_int_eq(libinput_set_event_interest(li,
+						     LIBINPUT_EVENT_NONE,
+						     1),
+			 -1);
+	ck_assert_int_eq(libinput_set_event_interest(li, 301, 0), -1);
+	ck_assert_int_eq(libinput_set_event_interest(li, 1100, 0), -1);
+
+	ck_assert_int_eq(libinput_set_event_interest(li,
+						     LIBINPUT_EVENT_TOUCH_FRAME,
+						     0),
+			 0);
+	ck_assert_int_eq(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_TOUCH_FRAME),
+			 0);
+	/* neighbours are unaffected */
+	ck_assert_int_ne(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_TOUCH_CANCEL),
+			 0);
+	ck_assert_int_ne(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_TABLET_TOOL_AXIS),
+			 0);
+
+	ck_assert_int_eq(libinput_set_event_interest(li,
+						     LIBINPUT_EVENT_TOUCH_FRAME,
+						     1),
+			 0);
+	ck_assert_int_ne(libinput_get_event_interest(li,
+						     LIBINPUT_EVENT_TOUCH_FRAME),
+			 0);
+
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(event_interest_skips_events)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	struct libinput_event *event;
+
+	libinput_set_event_interest(li, LIBINPUT_EVENT_POINTER_MOTION, 0);
+
+	dev = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_REL, REL_Y, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_button_click(dev, BTN_LEFT, true);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_PRESSED);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	litest_drain_events(li);
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(event_interest_prunes_touchpad)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *dev;
+	struct libinput_device *device;
+	enum libinput_event_type type;
+
+	libinput_set_event_interest(li, LIBINPUT_EVENT_POINTER_BUTTON, 0);
+	libinput_set_event_interest(li, LIBINPUT_EVENT_POINTER_AXIS, 0);
+	for (type = LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN;
+	     type <= LIBINPUT_EVENT_GESTURE_PINCH_END;
+	     type++)
+		libinput_set_event_interest(li, type, 0);
+
+	dev = litest_add_device(li, LITEST_BCM5974);
+	device = dev->libinput_device;
+	litest_drain_events(li);
+
+	ck_assert(!libinput_device_has_capability(device,
+						  LIBINPUT_DEVICE_CAP_GESTURE));
+	ck_assert_int_eq(libinput_device_config_tap_get_finger_count(device),
+			 0);
+	ck_assert_int_eq(libinput_device_config_scroll_get_methods(device),
+			 LIBINPUT_CONFIG_SCROLL_NO_SCROLL);
+
+	/* a tap and a two-finger scroll produce nothing */
+	litest_touch_down(dev, 0, 50, 50);
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+	litest_timeout_tap();
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_touch_down(dev, 0, 40, 40);
+	litest_touch_down(dev, 1, 50, 40);
+	litest_touch_move_two_touches(dev, 40, 40, 50, 40, 0, 20, 10, 0);
+	litest_touch_up(dev, 1);
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_delete_device(dev);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(event_interest_seat_button_count)
+{
+	struct libinput *li = litest_create_context();
+	struct litest_device *tablet1, *tablet2;
+	struct libinput_event *event;
+	struct libinput_event_tablet_tool *tev;
+	struct axis_replacement axes[] = {
+		{ ABS_DISTANCE, 10 },
+		{ ABS_PRESSURE, 0 },
+		{ -1, -1 }
+	};
+
+	libinput_set_event_interest(li, LIBINPUT_EVENT_TABLET_TOOL_BUTTON, 0);
+
+	tablet1 = litest_add_device(li, LITEST_WACOM_INTUOS);
+	tablet2 = litest_add_device(li, LITEST_WACOM_INTUOS);
+	litest_tablet_proximity_in(tablet1, 10, 10, axes);
+	litest_tablet_proximity_in(tablet2, 10, 10, axes);
+	litest_drain_events(li);
+
+	/* no event, but the seat still sees the button */
+	litest_event(tablet1, EV_KEY, BTN_STYLUS, 1);
+	litest_event(tablet1, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	libinput_set_event_interest(li, LIBINPUT_EVENT_TABLET_TOOL_BUTTON, 1);
+
+	litest_event(tablet2, EV_KEY, BTN_STYLUS, 1);
+	litest_event(tablet2, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+	ck_assert_int_eq(libinput_event_tablet_tool_get_button(tev),
+			 BTN_STYLUS);
+	ck_assert_int_eq(libinput_event_tablet_tool_get_seat_button_count(tev),
+			 2);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	litest_delete_device(tablet1);
+	litest_delete_device(tablet2);
+	libinput_unref(li);
+}
+END_TEST
+
+START_TEST(event_ring)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event_ring *ring;
+	struct libinput_ring_reader reader;
+	const struct libinput_ring_event *e;
+	struct pollfd fds;
+	int i, rc;
+
+	ck_assert(libinput_event_ring_new(li, 0) == NULL);
+
+	/* rounded up to 4 slots */
+	ring = libinput_event_ring_new(li, 3);
+	ck_assert_notnull(ring);
+	ck_assert(libinput_event_ring_new(li, 3) == NULL);
+
+	rc = libinput_ring_reader_init(&reader,
+				       dup(libinput_event_ring_get_memfd(ring)),
+				       dup(libinput_event_ring_get_doorbell_fd(ring)),
+				       dup(libinput_event_ring_get_space_fd(ring)));
+	ck_assert_int_eq(rc, 0);
+	ck_assert_int_eq(reader.header->nslots, 4);
+	ck_assert(libinput_ring_reader_peek(&reader) == NULL);
+
+	litest_drain_events(li);
+
+	/* the mouse existed before the ring and is announced first */
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 1);
+	e = libinput_ring_reader_peek(&reader);
+	ck_assert_notnull(e);
+	ck_assert_int_eq(e->type, LIBINPUT_EVENT_DEVICE_ADDED);
+	ck_assert_int_eq(e->device_id, 1);
+	ck_assert_str_eq(e->u.device.sysname,
+			 libinput_device_get_sysname(dev->libinput_device));
+	libinput_ring_reader_consume(&reader);
+
+	for (i = 0; i < 6; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+
+	/* the ring is full after 4, the rest stays queued */
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 4);
+	ck_assert_int_eq(libinput_next_event_type(li),
+			 LIBINPUT_EVENT_POINTER_MOTION);
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 0);
+
+	fds.fd = libinput_ring_reader_get_fd(&reader);
+	fds.events = POLLIN;
+	ck_assert_int_eq(poll(&fds, 1, 0), 1);
+	libinput_ring_reader_ack(&reader);
+	ck_assert_int_eq(poll(&fds, 1, 0), 0);
+
+	fds.fd = libinput_event_ring_get_space_fd(ring);
+	ck_assert_int_eq(poll(&fds, 1, 0), 0);
+
+	for (i = 0; i < 4; i++) {
+		e = libinput_ring_reader_peek(&reader);
+		ck_assert_notnull(e);
+		ck_assert_int_eq(e->type, LIBINPUT_EVENT_POINTER_MOTION);
+		ck_assert_int_eq(e->device_id, 1);
+		ck_assert_int_ne(e->time_usec, 0);
+		ck_assert(e->u.motion.dx > 0.0);
+		ck_assert(e->u.motion.dy == 0.0);
+		libinput_ring_reader_consume(&reader);
+
+		/* consuming from a full ring rings the space doorbell */
+		if (i == 0)
+			ck_assert_int_eq(poll(&fds, 1, 0), 1);
+	}
+	ck_assert(libinput_ring_reader_peek(&reader) == NULL);
+
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 2);
+	ck_assert_int_eq(libinput_next_event_type(li), LIBINPUT_EVENT_NONE);
+	ck_assert_int_eq(poll(&fds, 1, 0), 0);
+
+	for (i = 0; i < 2; i++) {
+		e = libinput_ring_reader_peek(&reader);
+		ck_assert_notnull(e);
+		ck_assert_int_eq(e->type, LIBINPUT_EVENT_POINTER_MOTION);
+		libinput_ring_reader_consume(&reader);
+	}
+
+	libinput_event_ring_destroy(ring);
+	libinput_ring_reader_fini(&reader);
+}
+END_TEST
+
+START_TEST(event_ring_device_ids)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_device *keyboard;
+	struct libinput_event_ring *ring;
+	struct libinput_ring_reader reader;
+	const struct libinput_ring_event *e;
+	uint32_t mouse_id = 0, keyboard_id = 0;
+	int i, rc;
+
+	ring = libinput_event_ring_new(li, 8);
+	ck_assert_notnull(ring);
+	rc = libinput_ring_reader_init(&reader,
+				       dup(libinput_event_ring_get_memfd(ring)),
+				       dup(libinput_event_ring_get_doorbell_fd(ring)),
+				       dup(libinput_event_ring_get_space_fd(ring)));
+	ck_assert_int_eq(rc, 0);
+
+	/* if the mouse's own DEVICE_ADDED is still queued, it must not be
+	 * published a second time */
+	libinput_dispatch(li);
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 1);
+	e = libinput_ring_reader_peek(&reader);
+	ck_assert_int_eq(e->type, LIBINPUT_EVENT_DEVICE_ADDED);
+	ck_assert_int_eq(e->device_id, 1);
+	libinput_ring_reader_consume(&reader);
+
+	keyboard = litest_add_device(li, LITEST_KEYBOARD);
+	libinput_dispatch(li);
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 1);
+	e = libinput_ring_reader_peek(&reader);
+	ck_assert_int_eq(e->type, LIBINPUT_EVENT_DEVICE_ADDED);
+	ck_assert_int_eq(e->device_id, 2);
+	libinput_ring_reader_consume(&reader);
+
+	libinput_event_ring_destroy(ring);
+	libinput_ring_reader_fini(&reader);
+
+	/* a new ring announces both devices and numbers them again */
+	ring = libinput_event_ring_new(li, 8);
+	ck_assert_notnull(ring);
+	rc = libinput_ring_reader_init(&reader,
+				       dup(libinput_event_ring_get_memfd(ring)),
+				       dup(libinput_event_ring_get_doorbell_fd(ring)),
+				       dup(libinput_event_ring_get_space_fd(ring)));
+	ck_assert_int_eq(rc, 0);
+
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_keyboard_key(keyboard, KEY_A, true);
+	litest_keyboard_key(keyboard, KEY_A, false);
+	libinput_dispatch(li);
+
+	ck_assert_int_eq(libinput_event_ring_publish(ring), 5);
+
+	for (i = 0; i < 2; i++) {
+		e = libinput_ring_reader_peek(&reader);
+		ck_assert_int_eq(e->type, LIBINPUT_EVENT_DEVICE_ADDED);
+		if (streq(e->u.device.sysname,
+			  libinput_device_get_sysname(dev->libinput_device)))
+			mouse_id = e->device_id;
+		else
+			keyboard_id = e->device_id;
+		libinput_ring_reader_consume(&reader);
+	}
+	ck_assert_int_ne(mouse_id, 0);
+	ck_assert_int_ne(keyboard_id, 0);
+	ck_assert_int_ne(mouse_id, keyboard_id);
+	ck_assert_int_le(mouse_id, 2);
+	ck_assert_int_le(keyboard_id, 2);
+
+	e = libinput_ring_reader_peek(&reader);
+	ck_assert_int_eq(e->type, LIBINPUT_EVENT_POINTER_MOTION);
+	ck_assert_int_eq(e->device_id, mouse_id);
+	libinput_ring_reader_consume(&reader);
+
+	for (i = 0; i < 2; i++) {
+		e = libinput_ring_reader_peek(&reader);
+		ck_assert_int_eq(e->type, LIBINPUT_EVENT_KEYBOARD_KEY);
+		ck_assert_int_eq(e->device_id, keyboard_id);
+		libinput_ring_reader_consume(&reader);
+	}
+	ck_assert(libinput_ring_reader_peek(&reader) == NULL);
+
+	libinput_event_ring_destroy(ring);
+	libinput_ring_reader_fini(&reader);
+
+	litest_delete_device(keyboard);
+}
+END_TEST
+
 START_TEST(library_version)
 {
 	const char *version = LIBINPUT_LT_VERSION;
@@ -1299,6 +2131,8 @@ litest_setup_tests_misc(void)
 	litest_add_no_device("config:status string", config_status_string);
 
 	litest_add_no_device("misc:matrix", matrix_helpers);
+	litest_add_no_device("misc:matrix", matrix_batch_helpers);
+	litest_add_no_device("misc:matrix", hysteresis_batch_helpers);
 	litest_add_no_device("misc:ratelimit", ratelimit_helpers);
 	litest_add_no_device("misc:parser", dpi_parser);
 	litest_add_no_device("misc:parser", wheel_click_parser);
@@ -1311,9 +2145,26 @@ litest_setup_tests_misc(void)
 	litest_add_no_device("misc:parser", safe_atoi_test);
 	litest_add_no_device("misc:parser", safe_atod_test);
 	litest_add_no_device("misc:parser", strsplit_test);
+	litest_add_no_device("misc:parser", model_quirks_table);
 	litest_add_no_device("misc:time", time_conversion);
 
 	litest_add_no_device("misc:fd", fd_no_event_leak);
 
 	litest_add_no_device("misc:library_version", library_version);
+
+	litest_add_for_device("context:dispatch", dispatch_budget, LITEST_MOUSE);
+	litest_add_for_device("context:dispatch", dispatch_event_ordering, LITEST_MOUSE);
+	litest_add_for_device("context:dispatch", dispatch_coalesced, LITEST_MOUSE);
+
+	litest_add_no_device("context:io_uring", io_uring_reads);
+	litest_add_no_device("context:io_uring", io_uring_budget);
+	litest_add_no_device("context:io_uring", io_uring_syn_dropped);
+
+	litest_add_no_device("context:interest", event_interest);
+	litest_add_no_device("context:interest", event_interest_skips_events);
+	litest_add_no_device("context:interest", event_interest_prunes_touchpad);
+	litest_add_no_device("context:interest", event_interest_seat_button_count);
+
+	litest_add_for_device("context:ring", event_ring, LITEST_MOUSE);
+	litest_add_for_device("context:ring", event_ring_device_ids, LITEST_MOUSE);
 }
@@ -343,6 +343,79 @@ START_TEST(pointer_motion_unaccel)
 }
 END_TEST
 
+static uint64_t
+pointer_predict_move(struct litest_device *dev, int dx, int count)
+{
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	uint64_t time = 0;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		litest_event(dev, EV_REL, REL_X, dx);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		msleep(5);
+	}
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		struct libinput_event_pointer *ptrev;
+
+		ptrev = litest_is_motion_event(event);
+		time = libinput_event_pointer_get_time_usec(ptrev);
+		libinput_event_destroy(event);
+	}
+
+	litest_assert(time != 0);
+
+	return time;
+}
+
+START_TEST(pointer_motion_predict)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	double dx, dy, error, confidence;
+	uint64_t time;
+	int rc;
+
+	litest_drain_events(dev->libinput);
+
+	time = pointer_predict_move(dev, 5, 8);
+
+	rc = libinput_device_pointer_predict(device, time + 8000,
+					     &dx, &dy,
+					     &error, &confidence);
+	litest_assert_int_eq(rc, 0);
+	litest_assert_double_gt(dx, 0.0);
+	litest_assert_double_lt(fabs(dy), dx);
+	litest_assert_double_ge(error, 0.0);
+	litest_assert_double_gt(confidence, 0.0);
+	litest_assert_double_le(confidence, 1.0);
+
+	/* Too far ahead of the last event */
+	rc = libinput_device_pointer_predict(device, time + 500000,
+					     &dx, &dy,
+					     &error, &confidence);
+	litest_assert_int_eq(rc, -1);
+
+	/* Direction change stops prediction */
+	time = pointer_predict_move(dev, -5, 1);
+	rc = libinput_device_pointer_predict(device, time + 8000,
+					     &dx, &dy,
+					     &error, &confidence);
+	litest_assert_int_eq(rc, -1);
+
+	/* And it picks up again in the new direction */
+	time = pointer_predict_move(dev, -5, 8);
+	rc = libinput_device_pointer_predict(device, time + 8000,
+					     &dx, &dy,
+					     &error, &confidence);
+	litest_assert_int_eq(rc, 0);
+	litest_assert_double_lt(dx, 0.0);
+}
+END_TEST
+
 static void
 test_button_event(struct litest_device *dev, unsigned int button, int state)
 {
@@ -746,6 +819,100 @@ START_TEST(pointer_scroll_has_axis_invalid)
 }
 END_TEST
 
+START_TEST(pointer_snapshot)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	struct libinput_event_pointer_snapshot snapshot;
+
+	litest_drain_events(li);
+
+	litest_event(dev, EV_REL, REL_X, 5);
+	litest_event(dev, EV_REL, REL_Y, -3);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+
+	snapshot.version = 0;
+	ck_assert_int_eq(libinput_event_pointer_get_snapshot(ptrev, &snapshot),
+			 -1);
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION + 1;
+	ck_assert_int_eq(libinput_event_pointer_get_snapshot(ptrev, &snapshot),
+			 -1);
+
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	ck_assert_int_eq(libinput_event_pointer_get_snapshot(ptrev, &snapshot),
+			 0);
+	ck_assert_int_eq(snapshot.version, LIBINPUT_EVENT_SNAPSHOT_VERSION);
+	ck_assert_int_eq(snapshot.type, LIBINPUT_EVENT_POINTER_MOTION);
+	ck_assert_int_eq(snapshot.time_usec,
+			 libinput_event_pointer_get_time_usec(ptrev));
+	litest_assert_double_eq(snapshot.dx,
+				libinput_event_pointer_get_dx(ptrev));
+	litest_assert_double_eq(snapshot.dy,
+				libinput_event_pointer_get_dy(ptrev));
+	litest_assert_double_eq(snapshot.dx_unaccelerated, 5.0);
+	litest_assert_double_eq(snapshot.dy_unaccelerated, -3.0);
+	ck_assert_int_eq(snapshot.button, 0);
+	ck_assert_int_eq(snapshot.axes, 0);
+	libinput_event_destroy(event);
+
+	litest_button_click(dev, BTN_LEFT, true);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_button_event(event,
+				       BTN_LEFT,
+				       LIBINPUT_BUTTON_STATE_PRESSED);
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	ck_assert_int_eq(libinput_event_pointer_get_snapshot(ptrev, &snapshot),
+			 0);
+	ck_assert_int_eq(snapshot.type, LIBINPUT_EVENT_POINTER_BUTTON);
+	ck_assert_int_eq(snapshot.button, BTN_LEFT);
+	ck_assert_int_eq(snapshot.button_state,
+			 LIBINPUT_BUTTON_STATE_PRESSED);
+	ck_assert_int_eq(snapshot.seat_button_count, 1);
+	litest_assert_double_eq(snapshot.dx, 0.0);
+	litest_assert_double_eq(snapshot.dy, 0.0);
+	libinput_event_destroy(event);
+
+	litest_button_click(dev, BTN_LEFT, false);
+	litest_drain_events(li);
+
+	litest_event(dev, EV_REL, REL_WHEEL, -1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_axis_event(event,
+				     LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL,
+				     LIBINPUT_POINTER_AXIS_SOURCE_WHEEL);
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	ck_assert_int_eq(libinput_event_pointer_get_snapshot(ptrev, &snapshot),
+			 0);
+	ck_assert_int_eq(snapshot.type, LIBINPUT_EVENT_POINTER_AXIS);
+	ck_assert_int_eq(snapshot.axis_source,
+			 LIBINPUT_POINTER_AXIS_SOURCE_WHEEL);
+	ck_assert_int_eq(snapshot.axes,
+			 1 << LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL);
+	litest_assert_double_eq(
+		snapshot.axis_value[LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL],
+		libinput_event_pointer_get_axis_value(ptrev,
+				LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL));
+	litest_assert_double_eq(
+		snapshot.axis_value_discrete[LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL],
+		1.0);
+	litest_assert_double_eq(
+		snapshot.axis_value[LIBINPUT_POINTER_AXIS_SCROLL_HORIZONTAL],
+		0.0);
+	libinput_event_destroy(event);
+}
+END_TEST
+
 START_TEST(pointer_seat_button_count)
 {
 	const int num_devices = 4;
@@ -945,6 +1112,70 @@ START_TEST(pointer_left_handed_during_click)
 }
 END_TEST
 
+START_TEST(pointer_left_handed_switch_mid_frame)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *d = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	enum libinput_config_status status;
+
+	status = libinput_device_config_left_handed_set(d, 1);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	litest_drain_events(li);
+	litest_button_click(dev, BTN_LEFT, 1);
+	libinput_dispatch(li);
+
+	/* Takes effect on the release, in the middle of the frame below.
+	 * The mouse switches event processing paths there, no motion may
+	 * get lost or stuck */
+	status = libinput_device_config_left_handed_set(d, 0);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	litest_assert_button_event(li,
+				   BTN_RIGHT,
+				   LIBINPUT_BUTTON_STATE_PRESSED);
+
+	litest_event(dev, EV_REL, REL_X, 5);
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_REL, REL_Y, 3);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	ck_assert(libinput_event_pointer_get_dx_unaccelerated(ptrev) == 5.0);
+	ck_assert(libinput_event_pointer_get_dy_unaccelerated(ptrev) == 0.0);
+	libinput_event_destroy(event);
+
+	litest_assert_button_event(li,
+				   BTN_RIGHT,
+				   LIBINPUT_BUTTON_STATE_RELEASED);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	ck_assert(libinput_event_pointer_get_dx_unaccelerated(ptrev) == 0.0);
+	ck_assert(libinput_event_pointer_get_dy_unaccelerated(ptrev) == 3.0);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* and nothing left over for the next frame */
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_button_click(dev, BTN_LEFT, 1);
+	litest_button_click(dev, BTN_LEFT, 0);
+	litest_assert_button_event(li,
+				   BTN_LEFT,
+				   LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li,
+				   BTN_LEFT,
+				   LIBINPUT_BUTTON_STATE_RELEASED);
+}
+END_TEST
+
 START_TEST(pointer_left_handed_during_click_multiple_buttons)
 {
 	struct litest_device *dev = litest_current_device();
@@ -1512,6 +1743,65 @@ START_TEST(middlebutton)
 }
 END_TEST
 
+START_TEST(middlebutton_enable_disable)
+{
+	struct litest_device *device = litest_current_device();
+	struct libinput *li = device->libinput;
+	enum libinput_config_status status;
+
+	disable_button_scrolling(device);
+
+	status = libinput_device_config_middle_emulation_set_enabled(
+					    device->libinput_device,
+					    LIBINPUT_CONFIG_MIDDLE_EMULATION_ENABLED);
+	if (status == LIBINPUT_CONFIG_STATUS_UNSUPPORTED)
+		return;
+
+	litest_drain_events(li);
+
+	litest_button_click(device, BTN_LEFT, true);
+	litest_button_click(device, BTN_RIGHT, true);
+	litest_assert_button_event(li,
+				   BTN_MIDDLE,
+				   LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_button_click(device, BTN_LEFT, false);
+	litest_button_click(device, BTN_RIGHT, false);
+	litest_assert_button_event(li,
+				   BTN_MIDDLE,
+				   LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	/* Back to plain buttons, and still plain motion */
+	status = libinput_device_config_middle_emulation_set_enabled(
+					    device->libinput_device,
+					    LIBINPUT_CONFIG_MIDDLE_EMULATION_DISABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	litest_button_click(device, BTN_LEFT, true);
+	litest_button_click(device, BTN_RIGHT, true);
+	litest_assert_button_event(li,
+				   BTN_LEFT,
+				   LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_button_event(li,
+				   BTN_RIGHT,
+				   LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_button_click(device, BTN_LEFT, false);
+	litest_button_click(device, BTN_RIGHT, false);
+	litest_assert_button_event(li,
+				   BTN_LEFT,
+				   LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_button_event(li,
+				   BTN_RIGHT,
+				   LIBINPUT_BUTTON_STATE_RELEASED);
+
+	litest_event(device, EV_REL, REL_X, 1);
+	litest_event(device, EV_REL, REL_Y, 1);
+	litest_event(device, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+}
+END_TEST
+
 START_TEST(middlebutton_nostart_while_down)
 {
 	struct litest_device *device = litest_current_device();
@@ -2084,9 +2374,11 @@ litest_setup_tests_pointer(void)
 	litest_add_ranged("pointer:motion", pointer_motion_relative_min_decel, LITEST_RELATIVE, LITEST_ANY, &compass);
 	litest_add("pointer:motion", pointer_motion_absolute, LITEST_ABSOLUTE, LITEST_ANY);
 	litest_add("pointer:motion", pointer_motion_unaccel, LITEST_RELATIVE, LITEST_ANY);
+	litest_add_for_device("pointer:motion", pointer_motion_predict, LITEST_MOUSE);
 	litest_add("pointer:button", pointer_button, LITEST_BUTTON, LITEST_CLICKPAD);
 	litest_add_no_device("pointer:button", pointer_button_auto_release);
 	litest_add_no_device("pointer:button", pointer_seat_button_count);
+	litest_add_for_device("pointer:snapshot", pointer_snapshot, LITEST_MOUSE);
 	litest_add_for_device("pointer:button", pointer_button_has_no_button, LITEST_KEYBOARD);
 	litest_add("pointer:scroll", pointer_scroll_wheel, LITEST_WHEEL, LITEST_TABLET);
 	litest_add("pointer:scroll", pointer_scroll_button, LITEST_RELATIVE|LITEST_BUTTON, LITEST_ANY);
@@ -2109,6 +2401,7 @@ litest_setup_tests_pointer(void)
 	litest_add("pointer:left-handed", pointer_left_handed, LITEST_RELATIVE|LITEST_BUTTON, LITEST_ANY);
 	litest_add("pointer:left-handed", pointer_left_handed_during_click, LITEST_RELATIVE|LITEST_BUTTON, LITEST_ANY);
 	litest_add("pointer:left-handed", pointer_left_handed_during_click_multiple_buttons, LITEST_RELATIVE|LITEST_BUTTON, LITEST_ANY);
+	litest_add_for_device("pointer:left-handed", pointer_left_handed_switch_mid_frame, LITEST_MOUSE);
 
 	litest_add("pointer:accel", pointer_accel_defaults, LITEST_RELATIVE, LITEST_ANY);
 	litest_add("pointer:accel", pointer_accel_invalid, LITEST_RELATIVE, LITEST_ANY);
@@ -2122,6 +2415,7 @@ litest_setup_tests_pointer(void)
 	litest_add("pointer:accel", pointer_accel_profile_flat_motion_relative, LITEST_RELATIVE, LITEST_TOUCHPAD);
 
 	litest_add("pointer:middlebutton", middlebutton, LITEST_BUTTON, LITEST_CLICKPAD);
+	litest_add_for_device("pointer:middlebutton", middlebutton_enable_disable, LITEST_MOUSE);
 	litest_add("pointer:middlebutton", middlebutton_nostart_while_down, LITEST_BUTTON, LITEST_CLICKPAD);
 	litest_add("pointer:middlebutton", middlebutton_timeout, LITEST_BUTTON, LITEST_CLICKPAD);
 	litest_add("pointer:middlebutton", middlebutton_doubleclick, LITEST_BUTTON, LITEST_CLICKPAD);
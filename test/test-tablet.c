@@ -1720,6 +1720,193 @@ START_TEST(left_handed_artpen_rotation)
 }
 END_TEST
 
+START_TEST(motion_snapshot)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_tablet_tool *tev;
+	struct libinput_event_tablet_tool_snapshot snapshot;
+	uint32_t changed = 0;
+	struct axis_replacement axes[] = {
+		{ ABS_DISTANCE, 10 },
+		{ ABS_PRESSURE, 0 },
+		{ -1, -1 }
+	};
+
+	litest_drain_events(li);
+	litest_tablet_proximity_in(dev, 5, 100, axes);
+	litest_drain_events(li);
+
+	litest_tablet_motion(dev, 20, 80, axes);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
+
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	ck_assert_int_eq(libinput_event_tablet_tool_get_snapshot(tev, &snapshot),
+			 0);
+	ck_assert_int_eq(snapshot.type, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
+	ck_assert_int_eq(snapshot.time_usec,
+			 libinput_event_tablet_tool_get_time_usec(tev));
+	ck_assert_ptr_eq(snapshot.tool, libinput_event_tablet_tool_get_tool(tev));
+	ck_assert_int_eq(snapshot.proximity_state,
+			 LIBINPUT_TABLET_TOOL_PROXIMITY_STATE_IN);
+	litest_assert_double_eq(snapshot.x,
+				libinput_event_tablet_tool_get_x(tev));
+	litest_assert_double_eq(snapshot.y,
+				libinput_event_tablet_tool_get_y(tev));
+	litest_assert_double_eq(snapshot.dx,
+				libinput_event_tablet_tool_get_dx(tev));
+	litest_assert_double_eq(snapshot.dy,
+				libinput_event_tablet_tool_get_dy(tev));
+	litest_assert_double_eq(snapshot.distance,
+				libinput_event_tablet_tool_get_distance(tev));
+	litest_assert_double_eq(snapshot.pressure,
+				libinput_event_tablet_tool_get_pressure(tev));
+	ck_assert_int_eq(snapshot.button, 0);
+
+	if (libinput_event_tablet_tool_x_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_X;
+	if (libinput_event_tablet_tool_y_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_Y;
+	if (libinput_event_tablet_tool_distance_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_DISTANCE;
+	if (libinput_event_tablet_tool_pressure_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_PRESSURE;
+	if (libinput_event_tablet_tool_tilt_x_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_TILT_X;
+	if (libinput_event_tablet_tool_tilt_y_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_TILT_Y;
+	if (libinput_event_tablet_tool_rotation_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_ROTATION;
+	if (libinput_event_tablet_tool_slider_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_SLIDER;
+	if (libinput_event_tablet_tool_wheel_has_changed(tev))
+		changed |= LIBINPUT_TABLET_TOOL_SNAPSHOT_AXIS_WHEEL;
+	ck_assert_int_ne(changed, 0);
+	ck_assert_int_eq(snapshot.changed_axes, changed);
+
+	libinput_event_destroy(event);
+}
+END_TEST
+
+START_TEST(button_snapshot)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_tablet_tool *tev;
+	struct libinput_event_tablet_tool_snapshot snapshot;
+	struct axis_replacement axes[] = {
+		{ ABS_DISTANCE, 10 },
+		{ ABS_PRESSURE, 0 },
+		{ -1, -1 }
+	};
+
+	if (!libevdev_has_event_code(dev->evdev, EV_KEY, BTN_STYLUS))
+		return;
+
+	litest_tablet_proximity_in(dev, 10, 10, axes);
+	litest_drain_events(li);
+
+	litest_event(dev, EV_KEY, BTN_STYLUS, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+
+	snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	ck_assert_int_eq(libinput_event_tablet_tool_get_snapshot(tev, &snapshot),
+			 0);
+	ck_assert_int_eq(snapshot.type, LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+	ck_assert_int_eq(snapshot.button, BTN_STYLUS);
+	ck_assert_int_eq(snapshot.button_state, LIBINPUT_BUTTON_STATE_PRESSED);
+	litest_assert_double_eq(snapshot.x,
+				libinput_event_tablet_tool_get_x(tev));
+	litest_assert_double_eq(snapshot.y,
+				libinput_event_tablet_tool_get_y(tev));
+
+	/* the axes are the tool's state at the time of the button event */
+	if (libevdev_has_event_code(dev->evdev, EV_ABS, ABS_DISTANCE))
+		ck_assert(snapshot.distance > 0.0);
+
+	libinput_event_destroy(event);
+}
+END_TEST
+
+START_TEST(motion_coalescing)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_tablet_tool *tev;
+	const struct libinput_tablet_tool_sample *samples;
+	unsigned int nsamples, i;
+	struct axis_replacement axes[] = {
+		{ ABS_DISTANCE, 10 },
+		{ ABS_PRESSURE, 0 },
+		{ -1, -1 }
+	};
+	int x;
+
+	ck_assert_int_eq(libinput_get_tablet_motion_coalescing(li), 0);
+	libinput_set_tablet_motion_coalescing(li, 1);
+	ck_assert_int_ne(libinput_get_tablet_motion_coalescing(li), 0);
+
+	litest_drain_events(li);
+	litest_tablet_proximity_in(dev, 10, 10, axes);
+	litest_drain_events(li);
+
+	for (x = 11; x < 16; x++)
+		litest_tablet_motion(dev, x, 10, axes);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
+
+	nsamples = libinput_event_tablet_tool_get_sample_count(tev);
+	samples = libinput_event_tablet_tool_get_samples(tev);
+	ck_assert_int_eq(nsamples, 4);
+	ck_assert_notnull(samples);
+
+	for (i = 0; i < nsamples; i++) {
+		ck_assert_int_le(samples[i].time_usec,
+				 libinput_event_tablet_tool_get_time_usec(tev));
+		ck_assert(samples[i].x <= libinput_event_tablet_tool_get_x(tev));
+		if (i > 0)
+			ck_assert_int_le(samples[i - 1].time_usec,
+					 samples[i].time_usec);
+	}
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	/* a single axis event has no samples */
+	litest_tablet_motion(dev, 20, 10, axes);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	tev = litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
+	ck_assert_int_eq(libinput_event_tablet_tool_get_sample_count(tev), 0);
+	ck_assert(libinput_event_tablet_tool_get_samples(tev) == NULL);
+	libinput_event_destroy(event);
+
+	/* proximity out ends the sequence */
+	litest_tablet_motion(dev, 21, 10, axes);
+	litest_tablet_proximity_out(dev);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_tablet_event(event, LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
+	libinput_event_destroy(event);
+
+	libinput_set_tablet_motion_coalescing(li, 0);
+}
+END_TEST
+
 START_TEST(motion_event_state)
 {
 	struct litest_device *dev = litest_current_device();
@@ -4362,6 +4549,9 @@ litest_setup_tests_tablet(void)
 	litest_add("tablet:tip", tip_state_button, LITEST_TABLET, LITEST_ANY);
 	litest_add("tablet:motion", motion, LITEST_TABLET, LITEST_ANY);
 	litest_add("tablet:motion", motion_event_state, LITEST_TABLET, LITEST_ANY);
+	litest_add("tablet:motion", motion_snapshot, LITEST_TABLET, LITEST_ANY);
+	litest_add("tablet:button", button_snapshot, LITEST_TABLET, LITEST_ANY);
+	litest_add("tablet:motion", motion_coalescing, LITEST_TABLET, LITEST_ANY);
 	litest_add_for_device("tablet:motion", motion_outside_bounds, LITEST_WACOM_CINTIQ_24HD);
 	litest_add("tablet:tilt", tilt_available, LITEST_TABLET|LITEST_TILT, LITEST_ANY);
 	litest_add("tablet:tilt", tilt_not_available, LITEST_TABLET, LITEST_TILT);
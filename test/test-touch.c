@@ -241,6 +241,77 @@ START_TEST(touch_many_slots)
 }
 END_TEST
 
+START_TEST(touch_aggregate_frame)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *ev;
+	struct libinput_event_touch *tev;
+	const struct libinput_touch_slot_change *changes;
+	int i;
+
+	ck_assert_int_eq(libinput_get_touch_frame_aggregation(li), 0);
+	libinput_set_touch_frame_aggregation(li, 1);
+	ck_assert_int_ne(libinput_get_touch_frame_aggregation(li), 0);
+
+	litest_drain_events(li);
+
+	litest_push_event_frame(dev);
+	litest_touch_down(dev, 0, 30, 30);
+	litest_touch_down(dev, 1, 70, 70);
+	litest_pop_event_frame(dev);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
+	ck_assert_int_eq(libinput_event_touch_get_slot_change_count(tev), 2);
+	changes = libinput_event_touch_get_slot_changes(tev);
+	for (i = 0; i < 2; i++) {
+		ck_assert_int_eq(changes[i].type, LIBINPUT_EVENT_TOUCH_DOWN);
+		ck_assert_int_eq(changes[i].slot, i);
+		ck_assert_int_eq(changes[i].seat_slot, i);
+		ck_assert(changes[i].x_normalized > 0.0);
+		ck_assert(changes[i].x_normalized < 1.0);
+		ck_assert(changes[i].y_normalized > 0.0);
+		ck_assert(changes[i].y_normalized < 1.0);
+	}
+	ck_assert(changes[0].x < changes[1].x);
+	ck_assert(changes[0].y < changes[1].y);
+	libinput_event_destroy(ev);
+	litest_assert_empty_queue(li);
+
+	litest_push_event_frame(dev);
+	litest_touch_move(dev, 1, 75, 75);
+	litest_touch_up(dev, 0);
+	litest_pop_event_frame(dev);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME);
+	ck_assert_int_eq(libinput_event_touch_get_slot_change_count(tev), 2);
+	changes = libinput_event_touch_get_slot_changes(tev);
+	ck_assert_int_eq(changes[0].type, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(changes[0].slot, 1);
+	ck_assert_int_eq(changes[1].type, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(changes[1].slot, 0);
+	libinput_event_destroy(ev);
+	litest_assert_empty_queue(li);
+
+	/* back to individual events on the next frame */
+	libinput_set_touch_frame_aggregation(li, 0);
+	litest_touch_up(dev, 1);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_UP);
+	libinput_event_destroy(ev);
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 START_TEST(touch_double_touch_down_up)
 {
 	struct libinput *libinput;
@@ -776,6 +847,161 @@ START_TEST(touch_protocol_a_2fg_touch)
 }
 END_TEST
 
+START_TEST(touch_protocol_a_contact_order)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *ev;
+	struct libinput_event_touch *tev;
+	double x, y;
+
+	litest_drain_events(li);
+
+	litest_push_event_frame(dev);
+	litest_touch_down(dev, 0, 20, 20);
+	litest_touch_down(dev, 1, 80, 80);
+	litest_pop_event_frame(dev);
+	litest_drain_events(li);
+
+	/* same two touches, reported in the reverse order. The slots
+	 * must stick to the touch closest to them */
+	litest_push_event_frame(dev);
+	litest_touch_move(dev, 1, 81, 81);
+	litest_touch_move(dev, 0, 21, 21);
+	litest_pop_event_frame(dev);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 0);
+	x = libinput_event_touch_get_x_transformed(tev, 100);
+	y = libinput_event_touch_get_y_transformed(tev, 100);
+	ck_assert_int_eq(round(x), 21);
+	ck_assert_int_eq(round(y), 21);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	x = libinput_event_touch_get_x_transformed(tev, 100);
+	y = libinput_event_touch_get_y_transformed(tev, 100);
+	ck_assert_int_eq(round(x), 81);
+	ck_assert_int_eq(round(y), 81);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+
+	/* only the second touch remains */
+	litest_touch_move(dev, 1, 82, 82);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 0);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+
+	litest_event(dev, EV_SYN, SYN_MT_REPORT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_assignment)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *ev;
+	struct libinput_event_touch *tev;
+	double x;
+
+	litest_drain_events(li);
+
+	litest_push_event_frame(dev);
+	litest_touch_down(dev, 0, 20, 50);
+	litest_touch_down(dev, 1, 30, 50);
+	litest_pop_event_frame(dev);
+	litest_drain_events(li);
+
+	/* Both touches move right. The closest pair is slot 1 and the
+	 * contact at 26, but then slot 0 would jump to 36 */
+	litest_push_event_frame(dev);
+	litest_touch_move(dev, 1, 36, 50);
+	litest_touch_move(dev, 0, 26, 50);
+	litest_pop_event_frame(dev);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 0);
+	x = libinput_event_touch_get_x_transformed(tev, 100);
+	ck_assert_int_eq(round(x), 26);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	x = libinput_event_touch_get_x_transformed(tev, 100);
+	ck_assert_int_eq(round(x), 36);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+}
+END_TEST
+
+START_TEST(touch_protocol_a_jump)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *ev;
+	struct libinput_event_touch *tev;
+
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_drain_events(li);
+
+	/* too far to be the same touch */
+	litest_touch_move(dev, 0, 90, 90);
+	libinput_dispatch(li);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_UP);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 0);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	tev = litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_DOWN);
+	ck_assert_int_eq(libinput_event_touch_get_slot(tev), 1);
+	libinput_event_destroy(ev);
+
+	ev = libinput_get_event(li);
+	litest_is_touch_event(ev, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(ev);
+}
+END_TEST
+
 START_TEST(touch_initial_state)
 {
 	struct litest_device *dev;
@@ -911,6 +1137,40 @@ START_TEST(touch_fuzz)
 }
 END_TEST
 
+START_TEST(touch_fuzz_raw_position)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	double x, y;
+
+	litest_drain_events(dev->libinput);
+
+	litest_event(dev, EV_ABS, ABS_MT_TRACKING_ID, 30);
+	litest_event(dev, EV_ABS, ABS_MT_SLOT, 0);
+	litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 700);
+	litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, 300);
+	litest_event(dev, EV_KEY, BTN_TOUCH, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_drain_events(li);
+
+	/* Beyond the hysteresis margin, the motion carries the position
+	 * the device sent, not one offset by the margin */
+	litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 730);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_MOTION);
+	x = libinput_event_touch_get_x_transformed(tev, 1501);
+	y = libinput_event_touch_get_y_transformed(tev, 2501);
+	ck_assert_int_eq(round(x), 730);
+	ck_assert_int_eq(round(y), 300);
+	libinput_event_destroy(event);
+}
+END_TEST
+
 void
 litest_setup_tests_touch(void)
 {
@@ -921,6 +1181,7 @@ litest_setup_tests_touch(void)
 	litest_add("touch:slots", touch_seat_slot, LITEST_TOUCH, LITEST_TOUCHPAD);
 	litest_add_no_device("touch:slots", touch_many_slots);
 	litest_add("touch:double-touch-down-up", touch_double_touch_down_up, LITEST_TOUCH, LITEST_ANY);
+	litest_add("touch:aggregate", touch_aggregate_frame, LITEST_TOUCH, LITEST_TOUCHPAD|LITEST_PROTOCOL_A);
 	litest_add("touch:calibration", touch_calibration_scale, LITEST_TOUCH, LITEST_TOUCHPAD);
 	litest_add("touch:calibration", touch_calibration_scale, LITEST_SINGLE_TOUCH, LITEST_TOUCHPAD);
 	litest_add("touch:calibration", touch_calibration_rotation, LITEST_TOUCH, LITEST_TOUCHPAD);
@@ -938,10 +1199,14 @@ litest_setup_tests_touch(void)
 	litest_add("touch:protocol a", touch_protocol_a_init, LITEST_PROTOCOL_A, LITEST_ANY);
 	litest_add("touch:protocol a", touch_protocol_a_touch, LITEST_PROTOCOL_A, LITEST_ANY);
 	litest_add("touch:protocol a", touch_protocol_a_2fg_touch, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add("touch:protocol a", touch_protocol_a_contact_order, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add("touch:protocol a", touch_protocol_a_assignment, LITEST_PROTOCOL_A, LITEST_ANY);
+	litest_add("touch:protocol a", touch_protocol_a_jump, LITEST_PROTOCOL_A, LITEST_ANY);
 
 	litest_add_ranged("touch:state", touch_initial_state, LITEST_TOUCH, LITEST_PROTOCOL_A, &axes);
 
 	litest_add("touch:time", touch_time_usec, LITEST_TOUCH, LITEST_TOUCHPAD);
 
 	litest_add_for_device("touch:fuzz", touch_fuzz, LITEST_MULTITOUCH_FUZZ_SCREEN);
+	litest_add_for_device("touch:fuzz", touch_fuzz_raw_position, LITEST_MULTITOUCH_FUZZ_SCREEN);
 }
@@ -299,6 +299,72 @@ START_TEST(touchpad_2fg_scroll_semi_mt)
 }
 END_TEST
 
+static double
+test_2fg_scroll_velocity(struct litest_device *dev, bool rest)
+{
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	enum libinput_pointer_axis axis = LIBINPUT_POINTER_AXIS_SCROLL_VERTICAL;
+	double value = -1, velocity = 0;
+
+	litest_touch_down(dev, 0, 49, 30);
+	litest_touch_down(dev, 1, 51, 30);
+	litest_touch_move_two_touches(dev, 49, 30, 51, 30, 0, 40, 10, 2);
+	libinput_dispatch(li);
+
+	/* rest for longer than the velocity window */
+	if (rest) {
+		msleep(150);
+		libinput_dispatch(li);
+	}
+
+	litest_touch_up(dev, 1);
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		ptrev = litest_is_axis_event(event,
+					     axis,
+					     LIBINPUT_POINTER_AXIS_SOURCE_FINGER);
+		value = libinput_event_pointer_get_axis_value(ptrev, axis);
+		velocity = libinput_event_pointer_get_axis_velocity(ptrev, axis);
+		libinput_event_destroy(event);
+
+		/* only the stop event carries a velocity */
+		if (value != 0.0)
+			ck_assert_double_eq(velocity, 0.0);
+	}
+
+	/* last event was the stop event */
+	ck_assert_double_eq(value, 0.0);
+
+	return velocity;
+}
+
+START_TEST(touchpad_2fg_scroll_velocity)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+
+	if (!litest_has_2fg_scroll(dev))
+		return;
+
+	litest_enable_2fg_scroll(dev);
+	litest_drain_events(li);
+
+	ck_assert_double_gt(test_2fg_scroll_velocity(dev, false), 0.0);
+	ck_assert_double_eq(test_2fg_scroll_velocity(dev, true), 0.0);
+
+	if (!libinput_device_config_scroll_has_natural_scroll(device))
+		return;
+
+	libinput_device_config_scroll_set_natural_scroll_enabled(device, 1);
+	ck_assert_double_lt(test_2fg_scroll_velocity(dev, false), 0.0);
+}
+END_TEST
+
 START_TEST(touchpad_2fg_scroll_return_to_motion)
 {
 	struct litest_device *dev = litest_current_device();
@@ -4968,6 +5034,7 @@ litest_setup_tests_touchpad(void)
 	litest_add("touchpad:scroll", touchpad_2fg_scroll_slow_distance, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 	litest_add("touchpad:scroll", touchpad_2fg_scroll_return_to_motion, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 	litest_add("touchpad:scroll", touchpad_2fg_scroll_source, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
+	litest_add("touchpad:scroll", touchpad_2fg_scroll_velocity, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 	litest_add("touchpad:scroll", touchpad_2fg_scroll_semi_mt, LITEST_SEMI_MT, LITEST_SINGLE_TOUCH);
 	litest_add("touchpad:scroll", touchpad_scroll_natural_defaults, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("touchpad:scroll", touchpad_scroll_natural_enable_config, LITEST_TOUCHPAD, LITEST_ANY);
@@ -29,6 +29,9 @@
 #include <libinput.h>
 #include <libinput-util.h>
 #include <libudev.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "litest.h"
@@ -560,6 +563,254 @@ START_TEST(udev_path_remove_device)
 }
 END_TEST
 
+static bool
+wait_for_device_event(struct libinput *li,
+		      enum libinput_event_type type,
+		      const char *sysname)
+{
+	struct libinput_event *event;
+	bool found = false;
+
+	while (!found) {
+		struct libinput_device *device;
+
+		litest_wait_for_event_of_type(li, type, -1);
+		event = libinput_get_event(li);
+		device = libinput_event_get_device(event);
+		found = streq(libinput_device_get_sysname(device), sysname);
+		libinput_event_destroy(event);
+	}
+
+	return found;
+}
+
+static void
+write_uevent(const char *syspath, const char *action)
+{
+	char path[PATH_MAX];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/uevent", syspath);
+	fd = open(path, O_WRONLY);
+	litest_assert_int_ge(fd, 0);
+	litest_assert_int_eq(write(fd, action, strlen(action)),
+			     (int)strlen(action));
+	close(fd);
+}
+
+/* udevd broadcasts each uevent to all monitors at once, so once this
+ * monitor has seen the uevents, the context's monitor has them too */
+static void
+wait_for_uevents(struct udev_monitor *monitor,
+		 const char *syspath,
+		 int count)
+{
+	struct pollfd fds = {
+		.fd = udev_monitor_get_fd(monitor),
+		.events = POLLIN,
+	};
+
+	while (count > 0) {
+		struct udev_device *udev_device;
+
+		ck_assert_int_eq(poll(&fds, 1, 2000), 1);
+		udev_device = udev_monitor_receive_device(monitor);
+		if (!udev_device)
+			continue;
+
+		if (streq(udev_device_get_syspath(udev_device), syspath))
+			count--;
+		udev_device_unref(udev_device);
+	}
+}
+
+START_TEST(udev_hotplug_debounce)
+{
+	struct udev *udev;
+	struct udev_monitor *monitor;
+	struct libinput *li;
+	struct litest_device *dev, *dev2;
+	struct libinput_event *event;
+	struct libinput_device *device;
+	char *sysname, *syspath;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	li = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert(li != NULL);
+	ck_assert_int_eq(libinput_udev_assign_seat(li, "seat0"), 0);
+	litest_drain_events(li);
+
+	dev = litest_create_device(LITEST_MOUSE);
+	sysname = strdup(libinput_device_get_sysname(dev->libinput_device));
+	syspath = strdup(udev_device_get_syspath(
+			libinput_device_get_udev_device(dev->libinput_device)));
+	ck_assert(wait_for_device_event(li,
+					LIBINPUT_EVENT_DEVICE_ADDED,
+					sysname));
+	litest_drain_events(li);
+
+	/* created late so it doesn't see the device's own add */
+	monitor = udev_monitor_new_from_netlink(udev, "udev");
+	ck_assert(monitor != NULL);
+	udev_monitor_filter_add_match_subsystem_devtype(monitor,
+							"input",
+							NULL);
+	ck_assert_int_eq(udev_monitor_enable_receiving(monitor), 0);
+
+	/* The device flaps, all four uevents are read in one dispatch.
+	 * The remove is immediate, the adds are held back and only the
+	 * last one creates the device */
+	write_uevent(syspath, "remove");
+	write_uevent(syspath, "add");
+	write_uevent(syspath, "remove");
+	write_uevent(syspath, "add");
+	wait_for_uevents(monitor, syspath, 4);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ck_assert(event != NULL);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_REMOVED);
+	device = libinput_event_get_device(event);
+	ck_assert_str_eq(libinput_device_get_sysname(device), sysname);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	ck_assert(wait_for_device_event(li,
+					LIBINPUT_EVENT_DEVICE_ADDED,
+					sysname));
+	litest_assert_empty_queue(li);
+
+	/* a new device is added by the dispatch that reads its uevent */
+	dev2 = litest_create_device(LITEST_MOUSE);
+	wait_for_uevents(monitor,
+			 udev_device_get_syspath(
+				libinput_device_get_udev_device(dev2->libinput_device)),
+			 1);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ck_assert(event != NULL);
+	ck_assert_int_eq(libinput_event_get_type(event),
+			 LIBINPUT_EVENT_DEVICE_ADDED);
+	device = libinput_event_get_device(event);
+	ck_assert_str_eq(libinput_device_get_sysname(device),
+			 libinput_device_get_sysname(dev2->libinput_device));
+	libinput_event_destroy(event);
+
+	litest_delete_device(dev2);
+	litest_delete_device(dev);
+	free(sysname);
+	free(syspath);
+	libinput_unref(li);
+	udev_monitor_unref(monitor);
+	udev_unref(udev);
+}
+END_TEST
+
+static int
+count_added_devices(struct libinput *li)
+{
+	struct libinput_event *event;
+	int count = 0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_DEVICE_ADDED)
+			count++;
+		libinput_event_destroy(event);
+	}
+
+	return count;
+}
+
+static void
+wait_for_shared_device_event(struct libinput_udev_monitor *monitor,
+			     struct libinput *li,
+			     enum libinput_event_type type,
+			     const char *sysname)
+{
+	struct pollfd fds[2] = {
+		{ .fd = libinput_udev_monitor_get_fd(monitor), .events = POLLIN },
+		{ .fd = libinput_get_fd(li), .events = POLLIN },
+	};
+	bool found = false;
+
+	while (!found) {
+		struct libinput_event *event;
+
+		ck_assert_int_gt(poll(fds, ARRAY_LENGTH(fds), 2000), 0);
+		ck_assert_int_eq(libinput_udev_monitor_dispatch(monitor), 0);
+		libinput_dispatch(li);
+
+		while ((event = libinput_get_event(li))) {
+			struct libinput_device *device;
+
+			device = libinput_event_get_device(event);
+			if (libinput_event_get_type(event) == type &&
+			    streq(libinput_device_get_sysname(device), sysname))
+				found = true;
+			libinput_event_destroy(event);
+		}
+	}
+}
+
+START_TEST(udev_shared_monitor)
+{
+	struct udev *udev;
+	struct libinput_udev_monitor *monitor;
+	struct libinput *li1, *li2;
+	struct litest_device *dev;
+	char *sysname;
+	int count1, count2;
+
+	udev = udev_new();
+	ck_assert(udev != NULL);
+
+	monitor = libinput_udev_monitor_new(udev);
+	ck_assert_notnull(monitor);
+	ck_assert_int_ge(libinput_udev_monitor_get_fd(monitor), 0);
+
+	li1 = libinput_udev_create_context(&simple_interface, NULL, udev);
+	li2 = libinput_udev_create_context(&simple_interface, NULL, udev);
+	ck_assert_int_eq(libinput_udev_assign_seat_shared(li1,
+							  "seat0",
+							  monitor),
+			 0);
+	ck_assert_int_eq(libinput_udev_assign_seat_shared(li2,
+							  "seat0",
+							  monitor),
+			 0);
+	ck_assert_int_eq(libinput_udev_assign_seat(li1, "seat0"), -1);
+
+	/* both contexts see the same enumerated devices */
+	count1 = count_added_devices(li1);
+	count2 = count_added_devices(li2);
+	ck_assert_int_gt(count1, 0);
+	ck_assert_int_eq(count1, count2);
+
+	dev = litest_create_device(LITEST_MOUSE);
+	sysname = strdup(libinput_device_get_sysname(dev->libinput_device));
+	wait_for_shared_device_event(monitor, li1,
+				     LIBINPUT_EVENT_DEVICE_ADDED,
+				     sysname);
+
+	litest_delete_device(dev);
+	wait_for_shared_device_event(monitor, li1,
+				     LIBINPUT_EVENT_DEVICE_REMOVED,
+				     sysname);
+	free(sysname);
+
+	libinput_unref(li1);
+	libinput_unref(li2);
+	ck_assert(libinput_udev_monitor_unref(monitor) == NULL);
+	udev_unref(udev);
+}
+END_TEST
+
 void
 litest_setup_tests_udev(void)
 {
@@ -576,6 +827,8 @@ litest_setup_tests_udev(void)
 	litest_add_for_device("udev:suspend", udev_suspend_resume, LITEST_SYNAPTICS_CLICKPAD_X220);
 	litest_add_for_device("udev:device events", udev_device_sysname, LITEST_SYNAPTICS_CLICKPAD_X220);
 	litest_add_for_device("udev:seat", udev_seat_recycle, LITEST_SYNAPTICS_CLICKPAD_X220);
+	litest_add_no_device("udev:hotplug", udev_hotplug_debounce);
+	litest_add_no_device("udev:hotplug", udev_shared_monitor);
 
 	litest_add_no_device("udev:path", udev_path_add_device);
 	litest_add_for_device("udev:path", udev_path_remove_device, LITEST_SYNAPTICS_CLICKPAD_X220);
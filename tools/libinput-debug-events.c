@@ -23,12 +23,15 @@
 
 #include "config.h"
 
+#include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
 #include <fcntl.h>
+#include <math.h>
 #include <poll.h>
 #include <stdio.h>
 #include <signal.h>
+#include <stdarg.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -39,7 +42,11 @@
 #include <libinput.h>
 #include <libevdev/libevdev.h>
 
+#include <libinput-util.h>
+
 #include "shared.h"
+#include "libinput-debug-events.h"
+#include "libinput-record.h"
 
 uint32_t start_time;
 static const uint32_t screen_width = 100;
@@ -50,98 +57,84 @@ static bool be_quiet = false;
 
 #define printq(...) ({ if (!be_quiet)  printf(__VA_ARGS__); })
 
-static void
-print_event_header(struct libinput_event *ev)
+static const char *
+event_type_name(enum libinput_event_type type)
 {
-	/* use for pointer value only, do not dereference */
-	static void *last_device = NULL;
-	struct libinput_device *dev = libinput_event_get_device(ev);
-	const char *type = NULL;
-	char prefix;
-
-	switch(libinput_event_get_type(ev)) {
+	switch(type) {
 	case LIBINPUT_EVENT_NONE:
-		abort();
-	case LIBINPUT_EVENT_DEVICE_ADDED:
-		type = "DEVICE_ADDED";
 		break;
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+		return "DEVICE_ADDED";
 	case LIBINPUT_EVENT_DEVICE_REMOVED:
-		type = "DEVICE_REMOVED";
-		break;
+		return "DEVICE_REMOVED";
 	case LIBINPUT_EVENT_KEYBOARD_KEY:
-		type = "KEYBOARD_KEY";
-		break;
+		return "KEYBOARD_KEY";
 	case LIBINPUT_EVENT_POINTER_MOTION:
-		type = "POINTER_MOTION";
-		break;
+		return "POINTER_MOTION";
 	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
-		type = "POINTER_MOTION_ABSOLUTE";
-		break;
+		return "POINTER_MOTION_ABSOLUTE";
 	case LIBINPUT_EVENT_POINTER_BUTTON:
-		type = "POINTER_BUTTON";
-		break;
+		return "POINTER_BUTTON";
 	case LIBINPUT_EVENT_POINTER_AXIS:
-		type = "POINTER_AXIS";
-		break;
+		return "POINTER_AXIS";
 	case LIBINPUT_EVENT_TOUCH_DOWN:
-		type = "TOUCH_DOWN";
-		break;
+		return "TOUCH_DOWN";
 	case LIBINPUT_EVENT_TOUCH_MOTION:
-		type = "TOUCH_MOTION";
-		break;
+		return "TOUCH_MOTION";
 	case LIBINPUT_EVENT_TOUCH_UP:
-		type = "TOUCH_UP";
-		break;
+		return "TOUCH_UP";
 	case LIBINPUT_EVENT_TOUCH_CANCEL:
-		type = "TOUCH_CANCEL";
-		break;
+		return "TOUCH_CANCEL";
 	case LIBINPUT_EVENT_TOUCH_FRAME:
-		type = "TOUCH_FRAME";
-		break;
+		return "TOUCH_FRAME";
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+		return "TOUCH_AGGREGATE_FRAME";
 	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
-		type = "GESTURE_SWIPE_BEGIN";
-		break;
+		return "GESTURE_SWIPE_BEGIN";
 	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
-		type = "GESTURE_SWIPE_UPDATE";
-		break;
+		return "GESTURE_SWIPE_UPDATE";
 	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
-		type = "GESTURE_SWIPE_END";
-		break;
+		return "GESTURE_SWIPE_END";
 	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
-		type = "GESTURE_PINCH_BEGIN";
-		break;
+		return "GESTURE_PINCH_BEGIN";
 	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
-		type = "GESTURE_PINCH_UPDATE";
-		break;
+		return "GESTURE_PINCH_UPDATE";
 	case LIBINPUT_EVENT_GESTURE_PINCH_END:
-		type = "GESTURE_PINCH_END";
-		break;
+		return "GESTURE_PINCH_END";
 	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
-		type = "TABLET_TOOL_AXIS";
-		break;
+		return "TABLET_TOOL_AXIS";
 	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
-		type = "TABLET_TOOL_PROXIMITY";
-		break;
+		return "TABLET_TOOL_PROXIMITY";
 	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
-		type = "TABLET_TOOL_TIP";
-		break;
+		return "TABLET_TOOL_TIP";
 	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
-		type = "TABLET_TOOL_BUTTON";
-		break;
+		return "TABLET_TOOL_BUTTON";
 	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
-		type = "TABLET_PAD_BUTTON";
-		break;
+		return "TABLET_PAD_BUTTON";
 	case LIBINPUT_EVENT_TABLET_PAD_RING:
-		type = "TABLET_PAD_RING";
-		break;
+		return "TABLET_PAD_RING";
 	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
-		type = "TABLET_PAD_STRIP";
-		break;
+		return "TABLET_PAD_STRIP";
 	case LIBINPUT_EVENT_SWITCH_TOGGLE:
-		type = "SWITCH_TOGGLE";
-		break;
+		return "SWITCH_TOGGLE";
+	case LIBINPUT_EVENT_RAW_FRAME:
+		return "RAW_FRAME";
 	}
 
+	abort();
+}
+
+static void
+print_event_header(struct libinput_event *ev)
+{
+	/* use for pointer value only, do not dereference */
+	static void *last_device = NULL;
+	struct libinput_device *dev = libinput_event_get_device(ev);
+	const char *type;
+	char prefix;
+
+	type = event_type_name(libinput_event_get_type(ev));
+
 	prefix = (last_device != dev) ? '-' : ' ';
 
 	printq("%c%-7s  %-16s ",
@@ -222,13 +215,10 @@ print_device_options(struct libinput_device *dev)
 	}
 }
 
-static void
-print_device_notify(struct libinput_event *ev)
+static int
+device_group_id(struct libinput_device *dev)
 {
-	struct libinput_device *dev = libinput_event_get_device(ev);
-	struct libinput_seat *seat = libinput_device_get_seat(dev);
 	struct libinput_device_group *group;
-	double w, h;
 	static int next_group_id = 0;
 	intptr_t group_id;
 
@@ -239,11 +229,22 @@ print_device_notify(struct libinput_event *ev)
 		libinput_device_group_set_user_data(group, (void*)group_id);
 	}
 
+	return group_id;
+}
+
+static void
+print_device_notify(struct libinput_event *ev)
+{
+	struct libinput_device *dev = libinput_event_get_device(ev);
+	struct libinput_seat *seat = libinput_device_get_seat(dev);
+	double w, h;
+	int group_id = device_group_id(dev);
+
 	printq("%-33s %5s %7s group%-2d",
 	       libinput_device_get_name(dev),
 	       libinput_seat_get_physical_name(seat),
 	       libinput_seat_get_logical_name(seat),
-	       (int)group_id);
+	       group_id);
 
 	printq(" cap:");
 	if (libinput_device_has_capability(dev,
@@ -617,6 +618,46 @@ print_touch_event_with_coords(struct libinput_event *ev)
 	       xmm, ymm);
 }
 
+static void
+print_touch_aggregate_frame_event(struct libinput_event *ev)
+{
+	struct libinput_event_touch *t = libinput_event_get_touch_event(ev);
+	const struct libinput_touch_slot_change *changes;
+	unsigned int i, nchanges;
+
+	changes = libinput_event_touch_get_slot_changes(t);
+	nchanges = libinput_event_touch_get_slot_change_count(t);
+
+	print_event_time(libinput_event_touch_get_time(t));
+
+	for (i = 0; i < nchanges; i++) {
+		const struct libinput_touch_slot_change *c = &changes[i];
+		const char *type;
+
+		switch (c->type) {
+		case LIBINPUT_EVENT_TOUCH_DOWN:
+			type = "down";
+			break;
+		case LIBINPUT_EVENT_TOUCH_UP:
+			type = "up";
+			break;
+		default:
+			type = "motion";
+			break;
+		}
+
+		printq("%s%s %d (%d) %5.2f/%5.2f (%5.2f/%5.2fmm)",
+		       i > 0 ? ", " : "",
+		       type,
+		       c->slot,
+		       c->seat_slot,
+		       c->x_normalized * screen_width,
+		       c->y_normalized * screen_height,
+		       c->x, c->y);
+	}
+	printq("\n");
+}
+
 static void
 print_gesture_event_without_coords(struct libinput_event *ev)
 {
@@ -760,6 +801,722 @@ print_switch_event(struct libinput_event *ev)
 	printq("switch %s state %d\n", which, state);
 }
 
+static void
+print_raw_event(struct libinput_event *ev)
+{
+	struct libinput_event_raw *raw = libinput_event_get_raw_event(ev);
+	const struct input_event *events;
+	size_t i, nevents;
+
+	print_event_time(libinput_event_raw_get_time_usec(raw) / 1000);
+
+	events = libinput_event_raw_get_events(raw, &nevents);
+	printq("%zd events", nevents);
+
+	for (i = 0; i < nevents; i++) {
+		const struct input_event *e = &events[i];
+
+		if (e->type == EV_SYN)
+			continue;
+
+		printq(", %s %d",
+		       libevdev_event_code_get_name(e->type, e->code),
+		       e->value);
+	}
+	printq("\n");
+}
+
+/* Large enough that a busy device only causes a write every few thousand
+ * events. Output is flushed at the latest OUTPUT_FLUSH_TIMEOUT_MS after
+ * its first byte was buffered, busy or not */
+#define OUTPUT_BUFFER_SIZE (1024 * 1024)
+#define OUTPUT_FLUSH_TIMEOUT_MS 100
+
+static struct {
+	char data[OUTPUT_BUFFER_SIZE];
+	size_t used;
+	uint64_t buffered_since;	/* in ms, valid while used > 0 */
+	/* jsonl records are assembled here before they're printed */
+	char *scratch;
+	size_t scratch_size;
+	uint32_t next_device_id;
+} output;
+
+static void
+output_flush(void)
+{
+	size_t offset = 0;
+
+	while (offset < output.used) {
+		ssize_t rc;
+
+		rc = write(STDOUT_FILENO,
+			   output.data + offset,
+			   output.used - offset);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			fprintf(stderr,
+				"Failed to write output: %s\n",
+				strerror(errno));
+			stop = 1;
+			break;
+		}
+		offset += rc;
+	}
+
+	output.used = 0;
+}
+
+static inline uint64_t
+output_now_ms(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+
+	return us2ms(s2us(tp.tv_sec) + ns2us(tp.tv_nsec));
+}
+
+/* Call before adding to the buffer */
+static inline void
+output_mark_buffered(void)
+{
+	if (output.used == 0)
+		output.buffered_since = output_now_ms();
+}
+
+/* Time left until the buffer must be flushed, -1 if it is empty */
+static int
+output_flush_timeout(void)
+{
+	uint64_t elapsed;
+
+	if (output.used == 0)
+		return -1;
+
+	elapsed = output_now_ms() - output.buffered_since;
+	if (elapsed >= OUTPUT_FLUSH_TIMEOUT_MS)
+		return 0;
+
+	return OUTPUT_FLUSH_TIMEOUT_MS - elapsed;
+}
+
+static void *
+output_reserve(size_t len)
+{
+	void *data;
+
+	assert(len <= sizeof(output.data));
+
+	if (output.used + len > sizeof(output.data))
+		output_flush();
+
+	output_mark_buffered();
+	data = output.data + output.used;
+	output.used += len;
+
+	return data;
+}
+
+LIBINPUT_ATTRIBUTE_PRINTF(1, 2)
+static void
+output_printf(const char *format, ...)
+{
+	va_list args;
+	size_t avail = sizeof(output.data) - output.used;
+	int n;
+
+	output_mark_buffered();
+
+	va_start(args, format);
+	n = vsnprintf(output.data + output.used, avail, format, args);
+	va_end(args);
+
+	if (n >= 0 && (size_t)n >= avail) {
+		output_flush();
+		output_mark_buffered();
+		avail = sizeof(output.data);
+
+		va_start(args, format);
+		n = vsnprintf(output.data, avail, format, args);
+		va_end(args);
+	}
+
+	if (n > 0)
+		output.used += min((size_t)n, avail - 1);
+}
+
+static void
+output_json_string(const char *key, const char *str)
+{
+	static const char hex[] = "0123456789abcdef";
+	char chunk[256];
+	size_t n = 0;
+
+	output_printf(",\"%s\":\"", key);
+
+	for (; *str; str++) {
+		unsigned char c = *str;
+
+		/* room for the longest escape, \u00XX, and the closing quote */
+		if (n + 7 > sizeof(chunk)) {
+			memcpy(output_reserve(n), chunk, n);
+			n = 0;
+		}
+
+		if (c == '"' || c == '\\') {
+			chunk[n++] = '\\';
+			chunk[n++] = c;
+		} else if (c < 0x20) {
+			chunk[n++] = '\\';
+			chunk[n++] = 'u';
+			chunk[n++] = '0';
+			chunk[n++] = '0';
+			chunk[n++] = hex[c >> 4];
+			chunk[n++] = hex[c & 0xf];
+		} else {
+			chunk[n++] = c;
+		}
+	}
+
+	chunk[n++] = '"';
+	memcpy(output_reserve(n), chunk, n);
+}
+
+static void *
+record_begin(struct libinput_event *ev, size_t len)
+{
+	struct libinput_device *dev = libinput_event_get_device(ev);
+	struct debug_events_record *r;
+	size_t total = (sizeof(*r) + len + 7) & ~(size_t)7;
+
+	if (context.options.format == TOOLS_FORMAT_BINARY) {
+		r = output_reserve(total);
+	} else {
+		if (total > output.scratch_size) {
+			output.scratch = realloc(output.scratch, total);
+			if (!output.scratch)
+				abort();
+			output.scratch_size = total;
+		}
+		r = (struct debug_events_record*)output.scratch;
+	}
+
+	memset(r, 0, total);
+	r->type = libinput_event_get_type(ev);
+	r->length = total;
+	r->device = (uintptr_t)libinput_device_get_user_data(dev);
+
+	return r + 1;
+}
+
+static void
+record_device(struct libinput_event *ev)
+{
+	struct libinput_device *dev = libinput_event_get_device(ev);
+	struct libinput_seat *seat = libinput_device_get_seat(dev);
+	struct debug_events_device *d;
+	enum libinput_device_capability cap;
+
+	if (libinput_event_get_type(ev) == LIBINPUT_EVENT_DEVICE_ADDED)
+		libinput_device_set_user_data(dev,
+			(void*)(uintptr_t)++output.next_device_id);
+
+	d = record_begin(ev, sizeof(*d));
+
+	for (cap = LIBINPUT_DEVICE_CAP_KEYBOARD;
+	     cap <= LIBINPUT_DEVICE_CAP_SWITCH;
+	     cap++) {
+		if (libinput_device_has_capability(dev, cap))
+			d->capabilities |= 1 << cap;
+	}
+
+	d->id_vendor = libinput_device_get_id_vendor(dev);
+	d->id_product = libinput_device_get_id_product(dev);
+	d->group = device_group_id(dev);
+	if (libinput_device_get_size(dev, &d->width, &d->height) != 0)
+		d->width = d->height = 0;
+
+	if (libinput_device_has_capability(dev,
+					   LIBINPUT_DEVICE_CAP_TABLET_PAD)) {
+		d->pad_buttons = libinput_device_tablet_pad_get_num_buttons(dev);
+		d->pad_rings = libinput_device_tablet_pad_get_num_rings(dev);
+		d->pad_strips = libinput_device_tablet_pad_get_num_strips(dev);
+		d->pad_mode_groups = libinput_device_tablet_pad_get_num_mode_groups(dev);
+	}
+
+	snprintf(d->sysname, sizeof(d->sysname), "%s",
+		 libinput_device_get_sysname(dev));
+	snprintf(d->name, sizeof(d->name), "%s",
+		 libinput_device_get_name(dev));
+	snprintf(d->seat_physical, sizeof(d->seat_physical), "%s",
+		 libinput_seat_get_physical_name(seat));
+	snprintf(d->seat_logical, sizeof(d->seat_logical), "%s",
+		 libinput_seat_get_logical_name(seat));
+}
+
+static void
+record_keyboard(struct libinput_event *ev)
+{
+	struct libinput_event_keyboard *k = libinput_event_get_keyboard_event(ev);
+	struct debug_events_keyboard *r = record_begin(ev, sizeof(*r));
+
+	r->time_usec = libinput_event_keyboard_get_time_usec(k);
+	r->key = libinput_event_keyboard_get_key(k);
+	r->state = libinput_event_keyboard_get_key_state(k);
+	r->seat_key_count = libinput_event_keyboard_get_seat_key_count(k);
+
+	if (!context.options.show_keycodes &&
+	    (r->key >= KEY_ESC && r->key < KEY_ZENKAKUHANKAKU))
+		r->key = UINT32_MAX;
+}
+
+static void
+record_pointer(struct libinput_event *ev)
+{
+	struct libinput_event_pointer *p = libinput_event_get_pointer_event(ev);
+	struct libinput_event_pointer_snapshot *r = record_begin(ev, sizeof(*r));
+
+	r->version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	libinput_event_pointer_get_snapshot(p, r);
+}
+
+static void
+record_touch(struct libinput_event *ev)
+{
+	struct libinput_event_touch *t = libinput_event_get_touch_event(ev);
+	struct libinput_event_touch_snapshot *r = record_begin(ev, sizeof(*r));
+
+	r->version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	libinput_event_touch_get_snapshot(t, r);
+}
+
+static void
+record_touch_aggregate_frame(struct libinput_event *ev)
+{
+	struct libinput_event_touch *t = libinput_event_get_touch_event(ev);
+	const struct libinput_touch_slot_change *changes;
+	struct debug_events_touch_frame *r;
+	unsigned int nchanges;
+
+	changes = libinput_event_touch_get_slot_changes(t);
+	nchanges = libinput_event_touch_get_slot_change_count(t);
+
+	r = record_begin(ev, sizeof(*r) + nchanges * sizeof(*changes));
+	r->time_usec = libinput_event_touch_get_time_usec(t);
+	r->nchanges = nchanges;
+	memcpy(r + 1, changes, nchanges * sizeof(*changes));
+}
+
+static void
+record_gesture(struct libinput_event *ev)
+{
+	struct libinput_event_gesture *g = libinput_event_get_gesture_event(ev);
+	struct libinput_event_gesture_snapshot *r = record_begin(ev, sizeof(*r));
+
+	r->version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	libinput_event_gesture_get_snapshot(g, r);
+}
+
+static void
+record_tablet_tool(struct libinput_event *ev)
+{
+	struct libinput_event_tablet_tool *t = libinput_event_get_tablet_tool_event(ev);
+	struct libinput_tablet_tool *tool = libinput_event_tablet_tool_get_tool(t);
+	const struct libinput_tablet_tool_sample *samples;
+	struct debug_events_tablet_tool *r;
+	size_t nsamples;
+
+	nsamples = libinput_event_tablet_tool_get_sample_count(t);
+	samples = libinput_event_tablet_tool_get_samples(t);
+
+	r = record_begin(ev, sizeof(*r) + nsamples * sizeof(*samples));
+	r->snapshot.version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	libinput_event_tablet_tool_get_snapshot(t, &r->snapshot);
+	r->snapshot.tool = NULL;
+
+	r->serial = libinput_tablet_tool_get_serial(tool);
+	r->tool_id = libinput_tablet_tool_get_tool_id(tool);
+	r->tool_type = libinput_tablet_tool_get_type(tool);
+	if (libinput_tablet_tool_has_pressure(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_PRESSURE;
+	if (libinput_tablet_tool_has_distance(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_DISTANCE;
+	if (libinput_tablet_tool_has_tilt(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_TILT;
+	if (libinput_tablet_tool_has_rotation(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_ROTATION;
+	if (libinput_tablet_tool_has_slider(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_SLIDER;
+	if (libinput_tablet_tool_has_wheel(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_WHEEL;
+	if (libinput_tablet_tool_is_unique(tool))
+		r->tool_axes |= DEBUG_EVENTS_TOOL_UNIQUE;
+
+	r->nsamples = nsamples;
+	if (nsamples)
+		memcpy(r + 1, samples, nsamples * sizeof(*samples));
+}
+
+static void
+record_tablet_pad(struct libinput_event *ev)
+{
+	struct libinput_event_tablet_pad *p = libinput_event_get_tablet_pad_event(ev);
+	struct libinput_tablet_pad_mode_group *group;
+	struct debug_events_tablet_pad *r = record_begin(ev, sizeof(*r));
+
+	group = libinput_event_tablet_pad_get_mode_group(p);
+
+	r->time_usec = libinput_event_tablet_pad_get_time_usec(p);
+	r->mode = libinput_event_tablet_pad_get_mode(p);
+	r->mode_group = libinput_tablet_pad_mode_group_get_index(group);
+
+	switch (libinput_event_get_type(ev)) {
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+		r->button = libinput_event_tablet_pad_get_button_number(p);
+		r->button_state = libinput_event_tablet_pad_get_button_state(p);
+		r->button_is_toggle =
+			libinput_tablet_pad_mode_group_button_is_toggle(group,
+									r->button);
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+		r->number = libinput_event_tablet_pad_get_ring_number(p);
+		r->source = libinput_event_tablet_pad_get_ring_source(p);
+		r->position = libinput_event_tablet_pad_get_ring_position(p);
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		r->number = libinput_event_tablet_pad_get_strip_number(p);
+		r->source = libinput_event_tablet_pad_get_strip_source(p);
+		r->position = libinput_event_tablet_pad_get_strip_position(p);
+		break;
+	default:
+		abort();
+	}
+}
+
+static void
+record_switch(struct libinput_event *ev)
+{
+	struct libinput_event_switch *sw = libinput_event_get_switch_event(ev);
+	struct debug_events_switch *r = record_begin(ev, sizeof(*r));
+
+	r->time_usec = libinput_event_switch_get_time_usec(sw);
+	r->sw = libinput_event_switch_get_switch(sw);
+	r->state = libinput_event_switch_get_switch_state(sw);
+}
+
+static void
+record_raw(struct libinput_event *ev)
+{
+	struct libinput_event_raw *raw = libinput_event_get_raw_event(ev);
+	const struct input_event *events;
+	struct debug_events_raw *r;
+	struct record_event *e;
+	size_t i, nevents;
+
+	events = libinput_event_raw_get_events(raw, &nevents);
+
+	r = record_begin(ev, sizeof(*r) + nevents * sizeof(*e));
+	r->time_usec = libinput_event_raw_get_time_usec(raw);
+	r->nevents = nevents;
+
+	e = (struct record_event*)(r + 1);
+	for (i = 0; i < nevents; i++) {
+		e[i].time = events[i].time.tv_sec * 1000000ULL +
+			    events[i].time.tv_usec;
+		e[i].type = events[i].type;
+		e[i].code = events[i].code;
+		e[i].value = events[i].value;
+	}
+}
+
+/* JSON has no nan or inf, those are printed as null. Every J in a
+ * format takes its value wrapped in JV() */
+#define J "%s"
+#define JV(v_) json_number((char[32]){0}, 32, (v_))
+
+static const char *
+json_number(char *buf, size_t sz, double v)
+{
+	if (!isfinite(v))
+		return "null";
+
+	snprintf(buf, sz, "%.9g", v);
+
+	return buf;
+}
+
+static void
+print_json_record(const struct debug_events_record *r)
+{
+	const void *payload = r + 1;
+	uint32_t i;
+
+	output_printf("{\"type\":\"%s\",\"device\":%u",
+		      event_type_name(r->type),
+		      r->device);
+
+	switch (r->type) {
+	case LIBINPUT_EVENT_NONE:
+		abort();
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED: {
+		const struct debug_events_device *d = payload;
+
+		output_printf(",\"capabilities\":%u,\"id_vendor\":%u,"
+			      "\"id_product\":%u,\"group\":%u,"
+			      "\"width\":" J ",\"height\":" J ","
+			      "\"pad_buttons\":%d,\"pad_rings\":%d,"
+			      "\"pad_strips\":%d,\"pad_mode_groups\":%d",
+			      d->capabilities, d->id_vendor, d->id_product,
+			      d->group, JV(d->width), JV(d->height),
+			      d->pad_buttons, d->pad_rings,
+			      d->pad_strips, d->pad_mode_groups);
+		output_json_string("sysname", d->sysname);
+		output_json_string("name", d->name);
+		output_json_string("seat_physical", d->seat_physical);
+		output_json_string("seat_logical", d->seat_logical);
+		break;
+	}
+	case LIBINPUT_EVENT_KEYBOARD_KEY: {
+		const struct debug_events_keyboard *k = payload;
+
+		output_printf(",\"time\":%" PRIu64 ",\"key\":%u,"
+			      "\"state\":%u,\"seat_key_count\":%u",
+			      k->time_usec, k->key, k->state,
+			      k->seat_key_count);
+		break;
+	}
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS: {
+		const struct libinput_event_pointer_snapshot *p = payload;
+
+		output_printf(",\"time\":%" PRIu64 ","
+			      "\"dx\":" J ",\"dy\":" J ","
+			      "\"dx_unaccelerated\":" J ","
+			      "\"dy_unaccelerated\":" J ","
+			      "\"absolute_x\":" J ",\"absolute_y\":" J ","
+			      "\"button\":%u,\"button_state\":%u,"
+			      "\"seat_button_count\":%u,"
+			      "\"axis_source\":%u,\"axes\":%u,"
+			      "\"axis_value\":[" J "," J "],"
+			      "\"axis_value_discrete\":[" J "," J "]",
+			      p->time_usec,
+			      JV(p->dx), JV(p->dy),
+			      JV(p->dx_unaccelerated), JV(p->dy_unaccelerated),
+			      JV(p->absolute_x), JV(p->absolute_y),
+			      p->button, p->button_state,
+			      p->seat_button_count,
+			      p->axis_source, p->axes,
+			      JV(p->axis_value[0]), JV(p->axis_value[1]),
+			      JV(p->axis_value_discrete[0]),
+			      JV(p->axis_value_discrete[1]));
+		break;
+	}
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME: {
+		const struct libinput_event_touch_snapshot *t = payload;
+
+		output_printf(",\"time\":%" PRIu64 ",\"slot\":%d,"
+			      "\"seat_slot\":%d,\"x\":" J ",\"y\":" J,
+			      t->time_usec, t->slot, t->seat_slot,
+			      JV(t->x), JV(t->y));
+		break;
+	}
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME: {
+		const struct debug_events_touch_frame *f = payload;
+		const struct libinput_touch_slot_change *c =
+			(const struct libinput_touch_slot_change*)(f + 1);
+
+		output_printf(",\"time\":%" PRIu64 ",\"changes\":[",
+			      f->time_usec);
+		for (i = 0; i < f->nchanges; i++)
+			output_printf("%s{\"type\":\"%s\",\"slot\":%d,"
+				      "\"seat_slot\":%d,"
+				      "\"x\":" J ",\"y\":" J ","
+				      "\"x_normalized\":" J ","
+				      "\"y_normalized\":" J "}",
+				      i > 0 ? "," : "",
+				      event_type_name(c[i].type),
+				      c[i].slot, c[i].seat_slot,
+				      JV(c[i].x), JV(c[i].y),
+				      JV(c[i].x_normalized),
+				      JV(c[i].y_normalized));
+		output_printf("]");
+		break;
+	}
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END: {
+		const struct libinput_event_gesture_snapshot *g = payload;
+
+		output_printf(",\"time\":%" PRIu64 ",\"finger_count\":%d,"
+			      "\"cancelled\":%d,\"dx\":" J ",\"dy\":" J ","
+			      "\"dx_unaccelerated\":" J ","
+			      "\"dy_unaccelerated\":" J ","
+			      "\"scale\":" J ",\"angle_delta\":" J,
+			      g->time_usec, g->finger_count, g->cancelled,
+			      JV(g->dx), JV(g->dy),
+			      JV(g->dx_unaccelerated), JV(g->dy_unaccelerated),
+			      JV(g->scale), JV(g->angle_delta));
+		break;
+	}
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON: {
+		const struct debug_events_tablet_tool *t = payload;
+		const struct libinput_event_tablet_tool_snapshot *s = &t->snapshot;
+		const struct libinput_tablet_tool_sample *samples =
+			(const struct libinput_tablet_tool_sample*)(t + 1);
+
+		output_printf(",\"time\":%" PRIu64 ",\"changed_axes\":%u,"
+			      "\"proximity_state\":%u,\"tip_state\":%u,"
+			      "\"x\":" J ",\"y\":" J ",\"dx\":" J ",\"dy\":" J ","
+			      "\"pressure\":" J ",\"distance\":" J ","
+			      "\"tilt_x\":" J ",\"tilt_y\":" J ","
+			      "\"rotation\":" J ",\"slider\":" J ","
+			      "\"wheel_delta\":" J ",\"wheel_delta_discrete\":%d,"
+			      "\"button\":%u,\"button_state\":%u,"
+			      "\"seat_button_count\":%u,"
+			      "\"serial\":%" PRIu64 ",\"tool_id\":%" PRIu64 ","
+			      "\"tool_type\":%u,\"tool_axes\":%u,\"samples\":[",
+			      s->time_usec, s->changed_axes,
+			      s->proximity_state, s->tip_state,
+			      JV(s->x), JV(s->y), JV(s->dx), JV(s->dy),
+			      JV(s->pressure), JV(s->distance),
+			      JV(s->tilt_x), JV(s->tilt_y),
+			      JV(s->rotation), JV(s->slider),
+			      JV(s->wheel_delta), s->wheel_delta_discrete,
+			      s->button, s->button_state,
+			      s->seat_button_count,
+			      t->serial, t->tool_id,
+			      t->tool_type, t->tool_axes);
+		for (i = 0; i < t->nsamples; i++)
+			output_printf("%s{\"time\":%" PRIu64 ","
+				      "\"x\":" J ",\"y\":" J ","
+				      "\"pressure\":" J ","
+				      "\"tilt_x\":" J ",\"tilt_y\":" J "}",
+				      i > 0 ? "," : "",
+				      samples[i].time_usec,
+				      JV(samples[i].x), JV(samples[i].y),
+				      JV(samples[i].pressure),
+				      JV(samples[i].tilt_x),
+				      JV(samples[i].tilt_y));
+		output_printf("]");
+		break;
+	}
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP: {
+		const struct debug_events_tablet_pad *p = payload;
+
+		output_printf(",\"time\":%" PRIu64 ",\"mode\":%u,"
+			      "\"mode_group\":%u,\"button\":%u,"
+			      "\"button_state\":%u,\"button_is_toggle\":%u,"
+			      "\"number\":%u,\"source\":%u,\"position\":" J,
+			      p->time_usec, p->mode, p->mode_group,
+			      p->button, p->button_state, p->button_is_toggle,
+			      p->number, p->source, JV(p->position));
+		break;
+	}
+	case LIBINPUT_EVENT_SWITCH_TOGGLE: {
+		const struct debug_events_switch *sw = payload;
+
+		output_printf(",\"time\":%" PRIu64 ",\"switch\":%u,\"state\":%u",
+			      sw->time_usec, sw->sw, sw->state);
+		break;
+	}
+	case LIBINPUT_EVENT_RAW_FRAME: {
+		const struct debug_events_raw *raw = payload;
+		const struct record_event *e = (const struct record_event*)(raw + 1);
+
+		output_printf(",\"time\":%" PRIu64 ",\"events\":[",
+			      raw->time_usec);
+		for (i = 0; i < raw->nevents; i++)
+			output_printf("%s[%" PRIu64 ",%u,%u,%d]",
+				      i > 0 ? "," : "",
+				      e[i].time, e[i].type, e[i].code,
+				      e[i].value);
+		output_printf("]");
+		break;
+	}
+	}
+
+	output_printf("}\n");
+}
+
+#undef J
+
+static void
+write_record(struct libinput_event *ev)
+{
+	switch (libinput_event_get_type(ev)) {
+	case LIBINPUT_EVENT_NONE:
+		abort();
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		record_device(ev);
+		break;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		record_keyboard(ev);
+		break;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		record_pointer(ev);
+		break;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		record_touch(ev);
+		break;
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+		record_touch_aggregate_frame(ev);
+		break;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		record_gesture(ev);
+		break;
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+		record_tablet_tool(ev);
+		break;
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		record_tablet_pad(ev);
+		break;
+	case LIBINPUT_EVENT_SWITCH_TOGGLE:
+		record_switch(ev);
+		break;
+	case LIBINPUT_EVENT_RAW_FRAME:
+		record_raw(ev);
+		break;
+	}
+
+	if (context.options.format == TOOLS_FORMAT_JSONL)
+		print_json_record((struct debug_events_record*)output.scratch);
+}
+
 static int
 handle_and_print_events(struct libinput *li)
 {
@@ -768,6 +1525,18 @@ handle_and_print_events(struct libinput *li)
 
 	libinput_dispatch(li);
 	while ((ev = libinput_get_event(li))) {
+		if (context.options.format != TOOLS_FORMAT_TEXT) {
+			write_record(ev);
+			if (libinput_event_get_type(ev) ==
+			    LIBINPUT_EVENT_DEVICE_ADDED)
+				tools_device_apply_config(libinput_event_get_device(ev),
+							  &context.options);
+			libinput_event_destroy(ev);
+			libinput_dispatch(li);
+			rc = 0;
+			continue;
+		}
+
 		print_event_header(ev);
 
 		switch (libinput_event_get_type(ev)) {
@@ -809,6 +1578,9 @@ handle_and_print_events(struct libinput *li)
 		case LIBINPUT_EVENT_TOUCH_FRAME:
 			print_touch_event_without_coords(ev);
 			break;
+		case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+			print_touch_aggregate_frame_event(ev);
+			break;
 		case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
 			print_gesture_event_without_coords(ev);
 			break;
@@ -851,6 +1623,9 @@ handle_and_print_events(struct libinput *li)
 		case LIBINPUT_EVENT_SWITCH_TOGGLE:
 			print_switch_event(ev);
 			break;
+		case LIBINPUT_EVENT_RAW_FRAME:
+			print_raw_event(ev);
+			break;
 		}
 
 		libinput_event_destroy(ev);
@@ -891,8 +1666,24 @@ mainloop(struct libinput *li)
 		fprintf(stderr, "Expected device added events on startup but got none. "
 				"Maybe you don't have the right permissions?\n");
 
-	while (!stop && poll(&fds, 1, -1) > -1)
-		handle_and_print_events(li);
+	while (!stop) {
+		int timeout = output_flush_timeout();
+		int rc;
+
+		/* A steady stream of events would never let poll() time
+		 * out, check the deadline first */
+		if (timeout == 0) {
+			output_flush();
+			continue;
+		}
+
+		rc = poll(&fds, 1, timeout);
+		if (rc == -1)
+			break;
+
+		if (rc > 0)
+			handle_and_print_events(li);
+	}
 }
 
 int
@@ -911,13 +1702,32 @@ main(int argc, char **argv)
 
 	be_quiet = context.options.quiet;
 
+	if (context.options.format == TOOLS_FORMAT_BINARY &&
+	    isatty(STDOUT_FILENO)) {
+		fprintf(stderr, "Refusing to write binary output to a terminal\n");
+		return 1;
+	}
+
 	li = tools_open_backend(&context);
 	if (!li)
 		return 1;
 
+	if (context.options.format == TOOLS_FORMAT_BINARY) {
+		struct debug_events_header *header;
+
+		header = output_reserve(sizeof(*header));
+		header->magic = DEBUG_EVENTS_MAGIC;
+		header->version = DEBUG_EVENTS_VERSION;
+		header->header_size = sizeof(*header);
+		header->snapshot_version = LIBINPUT_EVENT_SNAPSHOT_VERSION;
+	}
+
 	mainloop(li);
 
 	libinput_unref(li);
 
+	output_flush();
+	free(output.scratch);
+
 	return 0;
 }
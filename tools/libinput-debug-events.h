@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LIBINPUT_DEBUG_EVENTS_H
+#define LIBINPUT_DEBUG_EVENTS_H
+
+#include <stdint.h>
+
+#include <libinput.h>
+
+/*
+ * Output of libinput debug-events --format=binary.
+ *
+ * The output is a struct debug_events_header followed by one record per
+ * libinput event. Each record is a struct debug_events_record followed by
+ * the payload for that event type, the record length is padded to a
+ * multiple of 8 bytes. All values are in host byte order and use the
+ * host's ABI for the libinput snapshot structs.
+ *
+ * Payloads by event type:
+ * - DEVICE_ADDED, DEVICE_REMOVED: struct debug_events_device
+ * - KEYBOARD_KEY: struct debug_events_keyboard
+ * - POINTER_*: struct libinput_event_pointer_snapshot
+ * - TOUCH_DOWN, _UP, _MOTION, _CANCEL, _FRAME:
+ *   struct libinput_event_touch_snapshot
+ * - TOUCH_AGGREGATE_FRAME: struct debug_events_touch_frame followed by
+ *   nchanges struct libinput_touch_slot_change
+ * - GESTURE_*: struct libinput_event_gesture_snapshot
+ * - TABLET_TOOL_*: struct debug_events_tablet_tool followed by nsamples
+ *   struct libinput_tablet_tool_sample
+ * - TABLET_PAD_*: struct debug_events_tablet_pad
+ * - SWITCH_TOGGLE: struct debug_events_switch
+ * - RAW_FRAME: struct debug_events_raw followed by nevents
+ *   struct record_event, see libinput-record.h
+ *
+ * The jsonl format writes one JSON object per record with the same
+ * fields.
+ */
+
+#define DEBUG_EVENTS_MAGIC 0x4c494556 /* "LIEV" */
+#define DEBUG_EVENTS_VERSION 1
+
+struct debug_events_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;	/* sizeof(struct debug_events_header) */
+	uint32_t snapshot_version; /* LIBINPUT_EVENT_SNAPSHOT_VERSION */
+};
+
+struct debug_events_record {
+	uint32_t type;		/* enum libinput_event_type */
+	uint32_t length;	/* including this header and the padding */
+	uint32_t device;	/* assigned in the order devices are added */
+	uint32_t padding;
+};
+
+struct debug_events_device {
+	uint32_t capabilities;	/* 1 << enum libinput_device_capability */
+	uint32_t id_vendor;
+	uint32_t id_product;
+	uint32_t group;		/* assigned in the order groups are seen */
+	double width;		/* in mm, zero if unknown */
+	double height;		/* in mm, zero if unknown */
+	int32_t pad_buttons;
+	int32_t pad_rings;
+	int32_t pad_strips;
+	int32_t pad_mode_groups;
+	char sysname[32];
+	char name[256];
+	char seat_physical[32];
+	char seat_logical[32];
+};
+
+struct debug_events_keyboard {
+	uint64_t time_usec;
+	uint32_t key;		/* UINT32_MAX if obfuscated */
+	uint32_t state;
+	uint32_t seat_key_count;
+	uint32_t padding;
+};
+
+struct debug_events_touch_frame {
+	uint64_t time_usec;
+	uint32_t nchanges;
+	uint32_t padding;
+};
+
+struct debug_events_tablet_tool {
+	/* The tool pointer is zeroed */
+	struct libinput_event_tablet_tool_snapshot snapshot;
+	uint64_t serial;
+	uint64_t tool_id;
+	uint32_t tool_type;	/* enum libinput_tablet_tool_type */
+	uint32_t tool_axes;	/* enum debug_events_tool_axis */
+	uint32_t nsamples;
+	uint32_t padding;
+};
+
+enum debug_events_tool_axis {
+	DEBUG_EVENTS_TOOL_PRESSURE = (1 << 0),
+	DEBUG_EVENTS_TOOL_DISTANCE = (1 << 1),
+	DEBUG_EVENTS_TOOL_TILT = (1 << 2),
+	DEBUG_EVENTS_TOOL_ROTATION = (1 << 3),
+	DEBUG_EVENTS_TOOL_SLIDER = (1 << 4),
+	DEBUG_EVENTS_TOOL_WHEEL = (1 << 5),
+	DEBUG_EVENTS_TOOL_UNIQUE = (1 << 6),
+};
+
+/* Fields that do not apply to the event type are zero */
+struct debug_events_tablet_pad {
+	uint64_t time_usec;
+	uint32_t mode;
+	uint32_t mode_group;	/* index of the mode group */
+	uint32_t button;
+	uint32_t button_state;
+	uint32_t button_is_toggle;
+	uint32_t number;	/* ring or strip number */
+	uint32_t source;	/* ring or strip source */
+	uint32_t padding;
+	double position;	/* ring or strip position */
+};
+
+struct debug_events_switch {
+	uint64_t time_usec;
+	uint32_t sw;
+	uint32_t state;
+};
+
+struct debug_events_raw {
+	uint64_t time_usec;
+	uint32_t nevents;
+	uint32_t padding;
+};
+
+#endif
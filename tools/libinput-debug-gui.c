@@ -826,6 +826,7 @@ handle_event_libinput(GIOChannel *source, GIOCondition condition, gpointer data)
 			break;
 		case LIBINPUT_EVENT_TOUCH_CANCEL:
 		case LIBINPUT_EVENT_TOUCH_FRAME:
+		case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
 			break;
 		case LIBINPUT_EVENT_POINTER_BUTTON:
 			handle_event_button(ev, w);
@@ -858,6 +859,7 @@ handle_event_libinput(GIOChannel *source, GIOCondition condition, gpointer data)
 		case LIBINPUT_EVENT_TABLET_PAD_STRIP:
 			break;
 		case LIBINPUT_EVENT_SWITCH_TOGGLE:
+		case LIBINPUT_EVENT_RAW_FRAME:
 			break;
 		}
 
@@ -0,0 +1,543 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/signalfd.h>
+#include <linux/input.h>
+
+#include <libudev.h>
+
+#include <libinput-util.h>
+
+#include "shared.h"
+
+#define error(...) fprintf(stderr, __VA_ARGS__)
+
+struct samples {
+	uint64_t *data;
+	size_t count;
+	size_t size;
+};
+
+struct latency_type {
+	enum libinput_event_type type;
+	const char *name;
+	struct samples kernel;	/* newest kernel frame - event time */
+	struct samples pickup;	/* CLOCK_MONOTONIC at pickup - event time */
+};
+
+/* Every device gets a second fd to the event node. The kernel buffers
+ * events per fd, so that fd sees the same frames libinput sees and tells
+ * us how far the kernel has advanced by the time an event is handed to
+ * the caller */
+struct latency_device {
+	struct list link;
+	struct libinput_device *device;
+	char *sysname;
+	int fd;
+	uint64_t last_frame_time;	/* in µs */
+	unsigned int ndropped;		/* on our fd, not libinput's */
+	unsigned int libinput_ndropped;	/* from libinput's log */
+	bool libinput_ndropped_capped;	/* the log message was ratelimited */
+};
+
+#define LATENCY_TYPE(t_) { .type = LIBINPUT_EVENT_##t_, .name = #t_ }
+
+static struct latency_type types[] = {
+	LATENCY_TYPE(KEYBOARD_KEY),
+	LATENCY_TYPE(POINTER_MOTION),
+	LATENCY_TYPE(POINTER_MOTION_ABSOLUTE),
+	LATENCY_TYPE(POINTER_BUTTON),
+	LATENCY_TYPE(POINTER_AXIS),
+	LATENCY_TYPE(TOUCH_DOWN),
+	LATENCY_TYPE(TOUCH_UP),
+	LATENCY_TYPE(TOUCH_MOTION),
+	LATENCY_TYPE(TOUCH_CANCEL),
+	LATENCY_TYPE(TOUCH_FRAME),
+	LATENCY_TYPE(TOUCH_AGGREGATE_FRAME),
+	LATENCY_TYPE(TABLET_TOOL_AXIS),
+	LATENCY_TYPE(TABLET_TOOL_PROXIMITY),
+	LATENCY_TYPE(TABLET_TOOL_TIP),
+	LATENCY_TYPE(TABLET_TOOL_BUTTON),
+	LATENCY_TYPE(TABLET_PAD_BUTTON),
+	LATENCY_TYPE(TABLET_PAD_RING),
+	LATENCY_TYPE(TABLET_PAD_STRIP),
+	LATENCY_TYPE(GESTURE_SWIPE_BEGIN),
+	LATENCY_TYPE(GESTURE_SWIPE_UPDATE),
+	LATENCY_TYPE(GESTURE_SWIPE_END),
+	LATENCY_TYPE(GESTURE_PINCH_BEGIN),
+	LATENCY_TYPE(GESTURE_PINCH_UPDATE),
+	LATENCY_TYPE(GESTURE_PINCH_END),
+	LATENCY_TYPE(SWITCH_TOGGLE),
+	LATENCY_TYPE(RAW_FRAME),
+};
+
+static struct tools_context context;
+static struct list devices;
+
+static void
+samples_add(struct samples *s, uint64_t value)
+{
+	if (s->count == s->size) {
+		s->size = s->size ? s->size * 2 : 1024;
+		s->data = realloc(s->data, s->size * sizeof(*s->data));
+		if (!s->data)
+			abort();
+	}
+
+	s->data[s->count++] = value;
+}
+
+static int
+cmp_u64(const void *a, const void *b)
+{
+	uint64_t ua = *(const uint64_t*)a,
+		 ub = *(const uint64_t*)b;
+
+	return (ua > ub) - (ua < ub);
+}
+
+/* Prints p50, p95, p99 and max in ms, sorts the samples in place */
+static void
+samples_print(struct samples *s)
+{
+	const unsigned int percentiles[] = { 50, 95, 99 };
+	size_t i;
+
+	if (s->count == 0) {
+		printf("  %7s %7s %7s %7s", "-", "-", "-", "-");
+		return;
+	}
+
+	qsort(s->data, s->count, sizeof(*s->data), cmp_u64);
+
+	printf(" ");
+	for (i = 0; i < ARRAY_LENGTH(percentiles); i++) {
+		size_t idx = s->count * percentiles[i] / 100;
+
+		idx = min(idx, s->count - 1);
+		printf(" %7.2f", s->data[idx] / 1000.0);
+	}
+	printf(" %7.2f", s->data[s->count - 1] / 1000.0);
+}
+
+static struct latency_type *
+latency_type_find(enum libinput_event_type type)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_LENGTH(types); i++) {
+		if (types[i].type == type)
+			return &types[i];
+	}
+
+	return NULL;
+}
+
+static uint64_t
+event_time_usec(struct libinput_event *ev)
+{
+	switch (libinput_event_get_type(ev)) {
+	case LIBINPUT_EVENT_NONE:
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		return 0;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		return libinput_event_keyboard_get_time_usec(
+				libinput_event_get_keyboard_event(ev));
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		return libinput_event_pointer_get_time_usec(
+				libinput_event_get_pointer_event(ev));
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+	case LIBINPUT_EVENT_TOUCH_AGGREGATE_FRAME:
+		return libinput_event_touch_get_time_usec(
+				libinput_event_get_touch_event(ev));
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+		return libinput_event_tablet_tool_get_time_usec(
+				libinput_event_get_tablet_tool_event(ev));
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		return libinput_event_tablet_pad_get_time_usec(
+				libinput_event_get_tablet_pad_event(ev));
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		return libinput_event_gesture_get_time_usec(
+				libinput_event_get_gesture_event(ev));
+	case LIBINPUT_EVENT_SWITCH_TOGGLE:
+		return libinput_event_switch_get_time_usec(
+				libinput_event_get_switch_event(ev));
+	case LIBINPUT_EVENT_RAW_FRAME:
+		return libinput_event_raw_get_time_usec(
+				libinput_event_get_raw_event(ev));
+	}
+
+	return 0;
+}
+
+static inline uint64_t
+now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return s2us(ts.tv_sec) + ts.tv_nsec / 1000;
+}
+
+static void
+device_added(struct libinput_device *device)
+{
+	struct latency_device *d;
+	struct udev_device *udev_device;
+	const char *devnode = NULL;
+	int clockid = CLOCK_MONOTONIC;
+
+	tools_device_apply_config(device, &context.options);
+
+	d = zalloc(sizeof(*d));
+	d->device = libinput_device_ref(device);
+	d->sysname = strdup(libinput_device_get_sysname(device));
+	d->fd = -1;
+
+	udev_device = libinput_device_get_udev_device(device);
+	if (udev_device) {
+		devnode = udev_device_get_devnode(udev_device);
+		if (devnode)
+			d->fd = open(devnode, O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+		udev_device_unref(udev_device);
+	}
+
+	if (d->fd == -1)
+		error("%s: cannot open the event node, kernel latency "
+		      "will not be measured\n",
+		      d->sysname);
+	else if (ioctl(d->fd, EVIOCSCLOCKID, &clockid) < 0)
+		error("%s: failed to set the clock: %s\n",
+		      d->sysname,
+		      strerror(errno));
+
+	libinput_device_set_user_data(device, d);
+	list_insert(devices.prev, &d->link);
+}
+
+static void
+device_removed(struct libinput_device *device)
+{
+	struct latency_device *d = libinput_device_get_user_data(device);
+
+	if (!d || d->fd == -1)
+		return;
+
+	/* Keep the device around for the summary */
+	close(d->fd);
+	d->fd = -1;
+}
+
+static struct latency_device *
+device_find(const char *sysname)
+{
+	struct latency_device *d, *found = NULL;
+
+	/* The most recent device of that name wins */
+	list_for_each(d, &devices, link) {
+		if (streq(d->sysname, sysname))
+			found = d;
+	}
+
+	return found;
+}
+
+/* libinput logs a SYN_DROPPED on its own fd of a device, the log handler
+ * is the only way to count those. A device message arrives as separate
+ * calls: the "%-7s - " sysname prefix, the device name at info and
+ * above, then the message itself */
+LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
+static void
+log_handler(struct libinput *li,
+	    enum libinput_log_priority priority,
+	    const char *format,
+	    va_list args)
+{
+	static char sysname[64];
+	static bool last_was_syn_dropped;
+	struct latency_device *d;
+	va_list copy;
+
+	if (context.options.verbose ||
+	    priority >= LIBINPUT_LOG_PRIORITY_ERROR) {
+		va_copy(copy, args);
+		vfprintf(stderr, format, copy);
+		va_end(copy);
+	}
+
+	if (streq(format, "%-7s - ")) {
+		va_copy(copy, args);
+		snprintf(sysname, sizeof(sysname), "%s", va_arg(copy, char *));
+		va_end(copy);
+		return;
+	}
+
+	if (streq(format, "%s: "))
+		return;
+
+	d = device_find(sysname);
+	if (d && strstr(format, "SYN_DROPPED")) {
+		d->libinput_ndropped++;
+		last_was_syn_dropped = true;
+		return;
+	}
+
+	/* Follows the message that hit the limit, more drops on this
+	 * device may go uncounted */
+	if (d && last_was_syn_dropped &&
+	    strstr(format, "log rate limit exceeded"))
+		d->libinput_ndropped_capped = true;
+
+	last_was_syn_dropped = false;
+}
+
+static void
+device_drain(struct latency_device *d)
+{
+	struct input_event evbuf[64];
+	ssize_t rc;
+	size_t i;
+
+	if (d->fd == -1)
+		return;
+
+	do {
+		rc = read(d->fd, evbuf, sizeof(evbuf));
+		for (i = 0; rc > 0 && i < rc/sizeof(*evbuf); i++) {
+			struct input_event *ev = &evbuf[i];
+
+			if (ev->type != EV_SYN)
+				continue;
+
+			if (ev->code == SYN_REPORT)
+				d->last_frame_time = tv2us(&ev->time);
+			else if (ev->code == SYN_DROPPED)
+				d->ndropped++;
+		}
+	} while (rc == sizeof(evbuf));
+}
+
+static void
+handle_events(struct libinput *li)
+{
+	struct libinput_event *ev;
+	struct latency_device *d;
+
+	libinput_dispatch(li);
+
+	/* Whatever the kernel has queued up now was not yet processed by
+	 * libinput, or only just. Either way the events below are behind it */
+	list_for_each(d, &devices, link)
+		device_drain(d);
+
+	while ((ev = libinput_get_event(li))) {
+		struct libinput_device *device = libinput_event_get_device(ev);
+		enum libinput_event_type type = libinput_event_get_type(ev);
+		struct latency_type *t;
+		uint64_t now = now_usec(),
+			 time;
+
+		switch (type) {
+		case LIBINPUT_EVENT_DEVICE_ADDED:
+			device_added(device);
+			break;
+		case LIBINPUT_EVENT_DEVICE_REMOVED:
+			device_removed(device);
+			break;
+		default:
+			break;
+		}
+
+		t = latency_type_find(type);
+		time = event_time_usec(ev);
+		if (t && time != 0) {
+			d = libinput_device_get_user_data(device);
+
+			samples_add(&t->pickup, now > time ? now - time : 0);
+			if (d && d->last_frame_time != 0)
+				samples_add(&t->kernel,
+					    d->last_frame_time > time ?
+					    d->last_frame_time - time : 0);
+		}
+
+		libinput_event_destroy(ev);
+	}
+}
+
+static void
+print_summary(void)
+{
+	struct latency_device *d;
+	size_t i;
+	bool have_data = false;
+
+	printf("%-24s %8s   %-31s   %-31s\n",
+	       "", "", "behind kernel (ms)", "behind CLOCK_MONOTONIC (ms)");
+	printf("%-24s %8s  %7s %7s %7s %7s  %7s %7s %7s %7s\n",
+	       "event type", "count",
+	       "p50", "p95", "p99", "max",
+	       "p50", "p95", "p99", "max");
+
+	for (i = 0; i < ARRAY_LENGTH(types); i++) {
+		struct latency_type *t = &types[i];
+
+		if (t->pickup.count == 0)
+			continue;
+
+		printf("%-24s %8zd", t->name, t->pickup.count);
+		samples_print(&t->kernel);
+		samples_print(&t->pickup);
+		printf("\n");
+		have_data = true;
+	}
+
+	if (!have_data)
+		printf("No events recorded\n");
+
+	/* libinput's count is what the pipeline lost. Ours only says that
+	 * the behind-kernel numbers of that device are based on an
+	 * incomplete view */
+	printf("\n%-24s %20s %16s\n",
+	       "device", "libinput SYN_DROPPED", "own SYN_DROPPED");
+	list_for_each(d, &devices, link)
+		printf("%-24s %19u%s %16u\n",
+		       d->sysname,
+		       d->libinput_ndropped,
+		       d->libinput_ndropped_capped ? "+" : " ",
+		       d->ndropped);
+}
+
+static int
+mainloop(struct libinput *li)
+{
+	struct pollfd fds[2];
+	sigset_t mask;
+
+	fds[0].fd = libinput_get_fd(li);
+	fds[0].events = POLLIN;
+	fds[0].revents = 0;
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	fds[1].fd = signalfd(-1, &mask, SFD_NONBLOCK);
+	fds[1].events = POLLIN;
+	fds[1].revents = 0;
+
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+
+	/* Handle already-pending device added events */
+	handle_events(li);
+
+	error("Measuring... Ctrl+C to stop and print the results\n");
+
+	while (poll(fds, 2, -1) > -1) {
+		if (fds[1].revents)
+			break;
+
+		handle_events(li);
+	}
+
+	close(fds[1].fd);
+
+	return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct libinput *li;
+	struct latency_device *d, *tmp;
+	size_t i;
+	int rc;
+
+	tools_init_context(&context);
+
+	if (tools_parse_args("measure latency", argc, argv, &context))
+		return EXIT_FAILURE;
+
+	list_init(&devices);
+
+	li = tools_open_backend(&context);
+	if (!li)
+		return EXIT_FAILURE;
+
+	libinput_log_set_handler(li, log_handler);
+	if (!context.options.verbose)
+		libinput_log_set_priority(li, LIBINPUT_LOG_PRIORITY_INFO);
+
+	rc = mainloop(li);
+
+	print_summary();
+
+	list_for_each_safe(d, tmp, &devices, link) {
+		if (d->fd != -1)
+			close(d->fd);
+		libinput_device_unref(d->device);
+		free(d->sysname);
+		free(d);
+	}
+
+	libinput_unref(li);
+
+	for (i = 0; i < ARRAY_LENGTH(types); i++) {
+		free(types[i].kernel.data);
+		free(types[i].pickup.data);
+	}
+
+	return rc;
+}
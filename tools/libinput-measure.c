@@ -48,6 +48,8 @@ usage(void)
 	       "Available features are:\n"
 	       "  touchpad-tap-time\n"
 	       "	Measures the time for tap-to-click interactions\n"
+	       "  latency\n"
+	       "	Measures how far processed events are behind the kernel and the clock\n"
 	       "     "
 	       "For information about each feature, see the --help output for that feature.\n"
 	       "\n"
@@ -0,0 +1,664 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "config.h"
+
+#include <assert.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+
+#include <libudev.h>
+#include <libevdev/libevdev.h>
+
+#include <libinput-util.h>
+
+#include "libinput-record.h"
+
+#define error(...) fprintf(stderr, __VA_ARGS__)
+
+/* Several seconds worth of an 8kHz mouse. The buffer is only written
+ * out when it is full or when the devices have been idle for
+ * RECORD_IDLE_FLUSH_MS, so a burst of events never waits for the disk */
+#define RECORD_BUFFER_SIZE (4 * 1024 * 1024)
+#define RECORD_IDLE_FLUSH_MS 1000
+#define RECORD_READ_EVENTS 256
+#define RECORD_MAX_DEVICES 64
+
+static_assert(sizeof(struct record_device) % RECORD_ALIGN == 0,
+	      "Device description breaks the chunk alignment");
+static_assert(sizeof(struct record_events) % RECORD_ALIGN == 0,
+	      "Event chunk header breaks the chunk alignment");
+static_assert(sizeof(struct record_event) == 16,
+	      "Unexpected record_event size");
+
+struct record_buffer {
+	int fd;
+	char *data;
+	size_t used;
+	bool failed;
+};
+
+struct record_device_state {
+	uint32_t id;
+	int fd;
+	char *path;
+	uint64_t nevents;
+	unsigned int ndropped;
+};
+
+struct record_context {
+	struct udev *udev;
+	struct record_buffer buffer;
+	struct record_device_state devices[RECORD_MAX_DEVICES];
+	size_t ndevices;
+};
+
+static inline size_t
+record_padded(size_t len)
+{
+	return (len + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1);
+}
+
+static bool
+buffer_flush(struct record_buffer *buffer)
+{
+	size_t offset = 0;
+
+	if (buffer->failed)
+		return false;
+
+	while (offset < buffer->used) {
+		ssize_t rc;
+
+		rc = write(buffer->fd,
+			   buffer->data + offset,
+			   buffer->used - offset);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Failed to write recording: %s\n",
+			      strerror(errno));
+			buffer->failed = true;
+			return false;
+		}
+		offset += rc;
+	}
+
+	buffer->used = 0;
+
+	return true;
+}
+
+static void *
+buffer_reserve(struct record_buffer *buffer, size_t len)
+{
+	void *data;
+
+	assert(len % RECORD_ALIGN == 0);
+	assert(len <= RECORD_BUFFER_SIZE);
+
+	if (buffer->used + len > RECORD_BUFFER_SIZE &&
+	    !buffer_flush(buffer))
+		return NULL;
+
+	data = buffer->data + buffer->used;
+	buffer->used += len;
+
+	return data;
+}
+
+/* Returns a pointer to the payload of a new chunk of the given length,
+ * the padding is zeroed, the payload is up to the caller */
+static void *
+buffer_add_chunk(struct record_buffer *buffer,
+		 enum record_chunk_type type,
+		 size_t len)
+{
+	struct record_chunk *chunk;
+	char *payload;
+
+	chunk = buffer_reserve(buffer, sizeof(*chunk) + record_padded(len));
+	if (!chunk)
+		return NULL;
+
+	chunk->type = type;
+	chunk->length = len;
+
+	payload = (char*)(chunk + 1);
+	memset(payload + len, 0, record_padded(len) - len);
+
+	return payload;
+}
+
+static bool
+record_is_relevant_property(const char *key)
+{
+	const char *prefixes[] = {
+		"ID_INPUT",
+		"LIBINPUT_",
+		"EVDEV_ABS_",
+		"MOUSE_",
+		"POINTINGSTICK_",
+	};
+	size_t i;
+
+	for (i = 0; i < ARRAY_LENGTH(prefixes); i++) {
+		if (strneq(key, prefixes[i], strlen(prefixes[i])))
+			return true;
+	}
+
+	return false;
+}
+
+static inline void
+set_bit_u8(uint8_t *array, unsigned int bit)
+{
+	array[bit / 8] |= 1 << (bit % 8);
+}
+
+static bool
+record_write_device(struct record_context *ctx,
+		    struct record_device_state *d)
+{
+	struct libevdev *evdev;
+	struct udev_device *udev_device = NULL;
+	struct udev_list_entry *e;
+	struct record_device *desc;
+	struct stat st;
+	const char *name;
+	char *str;
+	size_t len;
+	uint32_t nproperties = 0;
+	unsigned int type, code;
+	bool success = false;
+	int rc;
+
+	rc = libevdev_new_from_fd(d->fd, &evdev);
+	if (rc < 0) {
+		error("Failed to init device %s: %s\n",
+		      d->path,
+		      strerror(-rc));
+		return false;
+	}
+
+	/* libinput uses CLOCK_MONOTONIC, make the recording match */
+	rc = libevdev_set_clock_id(evdev, CLOCK_MONOTONIC);
+	if (rc < 0) {
+		error("Failed to set the clock on %s: %s\n",
+		      d->path,
+		      strerror(-rc));
+		goto out;
+	}
+
+	if (fstat(d->fd, &st) == 0)
+		udev_device = udev_device_new_from_devnum(ctx->udev,
+							  'c',
+							  st.st_rdev);
+
+	name = libevdev_get_name(evdev);
+	len = sizeof(*desc) + strlen(name) + 1;
+	if (udev_device) {
+		e = udev_device_get_properties_list_entry(udev_device);
+		for (; e; e = udev_list_entry_get_next(e)) {
+			const char *key = udev_list_entry_get_name(e);
+			const char *value = udev_list_entry_get_value(e);
+
+			if (!record_is_relevant_property(key))
+				continue;
+
+			len += strlen(key) + 1 + strlen(value) + 1;
+			nproperties++;
+		}
+	}
+
+	desc = buffer_add_chunk(&ctx->buffer, RECORD_CHUNK_DEVICE, len);
+	if (!desc)
+		goto out;
+
+	memset(desc, 0, sizeof(*desc));
+	desc->id = d->id;
+	desc->bustype = libevdev_get_id_bustype(evdev);
+	desc->vendor = libevdev_get_id_vendor(evdev);
+	desc->product = libevdev_get_id_product(evdev);
+	desc->version = libevdev_get_id_version(evdev);
+	desc->nproperties = nproperties;
+
+	for (code = 0; code < RECORD_PROP_BYTES * 8; code++) {
+		if (libevdev_has_property(evdev, code))
+			set_bit_u8(desc->props, code);
+	}
+
+	for (type = 0; type < RECORD_TYPE_COUNT; type++) {
+		int max;
+
+		if (!libevdev_has_event_type(evdev, type))
+			continue;
+
+		desc->types |= 1U << type;
+
+		max = libevdev_event_type_get_max(type);
+		max = min(max, RECORD_CODE_BYTES * 8 - 1);
+		for (code = 0; (int)code <= max; code++) {
+			if (libevdev_has_event_code(evdev, type, code))
+				set_bit_u8(desc->codes[type], code);
+		}
+	}
+
+	for (code = 0; code < RECORD_ABS_COUNT; code++) {
+		const struct input_absinfo *abs;
+		struct record_absinfo *a = &desc->absinfo[code];
+
+		abs = libevdev_get_abs_info(evdev, code);
+		if (!abs)
+			continue;
+
+		a->value = abs->value;
+		a->minimum = abs->minimum;
+		a->maximum = abs->maximum;
+		a->fuzz = abs->fuzz;
+		a->flat = abs->flat;
+		a->resolution = abs->resolution;
+	}
+
+	str = (char*)(desc + 1);
+	str += sprintf(str, "%s", name) + 1;
+	if (udev_device) {
+		e = udev_device_get_properties_list_entry(udev_device);
+		for (; e; e = udev_list_entry_get_next(e)) {
+			const char *key = udev_list_entry_get_name(e);
+
+			if (!record_is_relevant_property(key))
+				continue;
+
+			str += sprintf(str,
+				       "%s=%s",
+				       key,
+				       udev_list_entry_get_value(e)) + 1;
+		}
+	}
+
+	error("%s: recording \"%s\" as device %u\n", d->path, name, d->id);
+	success = true;
+out:
+	if (udev_device)
+		udev_device_unref(udev_device);
+	libevdev_free(evdev);
+
+	return success;
+}
+
+static bool
+record_add_device(struct record_context *ctx, const char *path)
+{
+	struct record_device_state *d;
+	int fd;
+
+	if (ctx->ndevices >= ARRAY_LENGTH(ctx->devices)) {
+		error("Too many devices, ignoring %s\n", path);
+		return true;
+	}
+
+	fd = open(path, O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+	if (fd < 0) {
+		error("Failed to open %s: %s\n", path, strerror(errno));
+		return false;
+	}
+
+	d = &ctx->devices[ctx->ndevices];
+	d->id = ctx->ndevices;
+	d->fd = fd;
+	d->path = strdup(path);
+
+	if (!record_write_device(ctx, d)) {
+		close(fd);
+		free(d->path);
+		return false;
+	}
+
+	ctx->ndevices++;
+
+	return true;
+}
+
+static int
+is_event_node(const struct dirent *dir)
+{
+	return strneq(dir->d_name, "event", 5);
+}
+
+/* Nodes we can't open (permissions, a device that went away) are
+ * skipped, main() fails if none could be added */
+static bool
+record_add_all_devices(struct record_context *ctx)
+{
+	struct dirent **namelist;
+	int ndev, i;
+
+	ndev = scandir("/dev/input", &namelist, is_event_node, versionsort);
+	if (ndev < 0) {
+		error("Failed to list /dev/input: %s\n", strerror(errno));
+		return false;
+	}
+
+	for (i = 0; i < ndev; i++) {
+		char path[PATH_MAX];
+
+		snprintf(path,
+			 sizeof(path),
+			 "/dev/input/%s",
+			 namelist[i]->d_name);
+		if (!record_add_device(ctx, path))
+			error("%s: skipping\n", path);
+		free(namelist[i]);
+	}
+	free(namelist);
+
+	return true;
+}
+
+/* Reads until the kernel buffer of the device is empty. Each read() ends
+ * up as one event chunk. Returns false if the device should no longer be
+ * polled */
+static bool
+record_read_device(struct record_context *ctx,
+		   struct record_device_state *d)
+{
+	struct input_event evbuf[RECORD_READ_EVENTS];
+
+	while (true) {
+		struct record_events *events;
+		struct record_event *e;
+		ssize_t rc;
+		size_t i, nevents;
+
+		rc = read(d->fd, evbuf, sizeof(evbuf));
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN)
+				return true;
+			if (errno == ENODEV)
+				error("%s: device removed\n", d->path);
+			else
+				error("%s: read error: %s\n",
+				      d->path,
+				      strerror(errno));
+			return false;
+		}
+
+		nevents = rc/sizeof(*evbuf);
+		if (nevents == 0)
+			return true;
+
+		events = buffer_add_chunk(&ctx->buffer,
+					  RECORD_CHUNK_EVENTS,
+					  sizeof(*events) +
+					  nevents * sizeof(*e));
+		if (!events)
+			return false;
+
+		events->device = d->id;
+		events->nevents = nevents;
+
+		e = (struct record_event*)(events + 1);
+		for (i = 0; i < nevents; i++) {
+			const struct input_event *ev = &evbuf[i];
+
+			e[i].time = tv2us(&ev->time);
+			e[i].type = ev->type;
+			e[i].code = ev->code;
+			e[i].value = ev->value;
+
+			if (ev->type == EV_SYN && ev->code == SYN_DROPPED)
+				d->ndropped++;
+		}
+		d->nevents += nevents;
+
+		if (nevents < ARRAY_LENGTH(evbuf))
+			return true;
+	}
+}
+
+static int
+record_loop(struct record_context *ctx)
+{
+	struct pollfd fds[RECORD_MAX_DEVICES + 1];
+	size_t nfds = ctx->ndevices + 1;
+	size_t nactive = ctx->ndevices;
+	sigset_t mask;
+	size_t i;
+	int rc = EXIT_FAILURE;
+
+	for (i = 0; i < ctx->ndevices; i++) {
+		fds[i].fd = ctx->devices[i].fd;
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	}
+
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGINT);
+	sigaddset(&mask, SIGTERM);
+	fds[nfds - 1].fd = signalfd(-1, &mask, SFD_NONBLOCK);
+	fds[nfds - 1].events = POLLIN;
+	fds[nfds - 1].revents = 0;
+
+	sigprocmask(SIG_BLOCK, &mask, NULL);
+
+	error("Recording... Ctrl+C to stop\n");
+
+	while (nactive > 0) {
+		int n = poll(fds, nfds, RECORD_IDLE_FLUSH_MS);
+
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			error("poll failed: %s\n", strerror(errno));
+			goto out;
+		}
+
+		if (n == 0) {
+			if (!buffer_flush(&ctx->buffer))
+				goto out;
+			continue;
+		}
+
+		if (fds[nfds - 1].revents)
+			break;
+
+		for (i = 0; i < ctx->ndevices; i++) {
+			if (fds[i].revents == 0)
+				continue;
+
+			if (!record_read_device(ctx, &ctx->devices[i])) {
+				if (ctx->buffer.failed)
+					goto out;
+				/* the device is gone, negative fds are
+				 * ignored by poll */
+				fds[i].fd = -1;
+				nactive--;
+			}
+		}
+	}
+
+	rc = EXIT_SUCCESS;
+out:
+	if (!buffer_flush(&ctx->buffer))
+		rc = EXIT_FAILURE;
+	close(fds[nfds - 1].fd);
+
+	return rc;
+}
+
+static inline void
+usage(void)
+{
+	printf("Usage: libinput record [--help] [--all] --output-file=<file> [/dev/input/event0 ...]\n");
+	printf("\n"
+	       "Record the raw kernel events and the description of one or more devices\n"
+	       "into a binary file until interrupted with Ctrl+C.\n"
+	       "\n"
+	       "Options:\n"
+	       "--help ......................... show this help\n"
+	       "--all .......................... record all /dev/input/event* devices\n"
+	       "-o <file>, --output-file=<file>  the file to write to. If omitted, the\n"
+	       "                                 recording is written to stdout unless\n"
+	       "                                 stdout is a terminal\n"
+	       "\n"
+	       "This tool requires access to the /dev/input/eventX nodes.\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	struct record_context ctx;
+	struct record_file_header *header;
+	const char *output_file = NULL;
+	bool all = false;
+	int option_index = 0;
+	int rc = EXIT_FAILURE;
+	size_t i;
+
+	while (1) {
+		enum opts {
+			OPT_HELP = 1,
+			OPT_ALL,
+			OPT_OUTPUT_FILE = 'o',
+		};
+		static struct option opts[] = {
+			{ "help",	         no_argument, 0, OPT_HELP },
+			{ "all",	         no_argument, 0, OPT_ALL },
+			{ "output-file",   required_argument, 0, OPT_OUTPUT_FILE },
+			{ 0, 0, 0, 0 },
+		};
+		int c;
+
+		c = getopt_long(argc, argv, "o:", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch(c) {
+		case OPT_HELP:
+			usage();
+			return EXIT_SUCCESS;
+		case OPT_ALL:
+			all = true;
+			break;
+		case OPT_OUTPUT_FILE:
+			output_file = optarg;
+			break;
+		default:
+			usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (all == (optind < argc)) {
+		usage();
+		return EXIT_FAILURE;
+	}
+
+	memset(&ctx, 0, sizeof(ctx));
+
+	if (output_file) {
+		ctx.buffer.fd = open(output_file,
+				     O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,
+				     0644);
+		if (ctx.buffer.fd < 0) {
+			error("Failed to open %s: %s\n",
+			      output_file,
+			      strerror(errno));
+			return EXIT_FAILURE;
+		}
+	} else if (isatty(STDOUT_FILENO)) {
+		error("Refusing to write a binary recording to a terminal\n");
+		return EXIT_FAILURE;
+	} else {
+		ctx.buffer.fd = STDOUT_FILENO;
+	}
+
+	ctx.buffer.data = malloc(RECORD_BUFFER_SIZE);
+	ctx.udev = udev_new();
+	if (!ctx.buffer.data || !ctx.udev) {
+		error("Failed to initialize\n");
+		goto out;
+	}
+
+	header = buffer_reserve(&ctx.buffer, sizeof(*header));
+	header->magic = RECORD_MAGIC;
+	header->version = RECORD_VERSION;
+	header->header_size = sizeof(*header);
+	header->clock_id = CLOCK_MONOTONIC;
+
+	if (all) {
+		if (!record_add_all_devices(&ctx))
+			goto out;
+	} else {
+		for (i = optind; i < (size_t)argc; i++) {
+			if (!record_add_device(&ctx, argv[i]))
+				goto out;
+		}
+	}
+
+	if (ctx.ndevices == 0) {
+		error("No devices to record\n");
+		goto out;
+	}
+
+	rc = record_loop(&ctx);
+
+	for (i = 0; i < ctx.ndevices; i++) {
+		struct record_device_state *d = &ctx.devices[i];
+
+		error("%s: %" PRIu64 " events, %u SYN_DROPPED\n",
+		      d->path,
+		      d->nevents,
+		      d->ndropped);
+	}
+
+out:
+	for (i = 0; i < ctx.ndevices; i++) {
+		close(ctx.devices[i].fd);
+		free(ctx.devices[i].path);
+	}
+	if (ctx.udev)
+		udev_unref(ctx.udev);
+	free(ctx.buffer.data);
+	if (ctx.buffer.fd != STDOUT_FILENO)
+		close(ctx.buffer.fd);
+
+	return rc;
+}
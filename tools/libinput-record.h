@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef LIBINPUT_RECORD_H
+#define LIBINPUT_RECORD_H
+
+#include <stdint.h>
+
+/*
+ * On-disk format written by libinput record.
+ *
+ * A recording is a struct record_file_header followed by a sequence of
+ * chunks. Every chunk starts with a struct record_chunk, the payload
+ * follows immediately and is padded to a multiple of 8 bytes so every
+ * chunk header and payload is naturally aligned when the file is
+ * mmap()ed. All values are in host byte order, readers must check the
+ * magic to detect a foreign byte order.
+ *
+ * A RECORD_CHUNK_DEVICE chunk describes a device and is always written
+ * before the first RECORD_CHUNK_EVENTS chunk referencing that device.
+ * Event chunks contain the events exactly as read from the kernel in one
+ * read(), frame boundaries are the EV_SYN/SYN_REPORT events within.
+ */
+
+#define RECORD_MAGIC 0x4c495243 /* "LIRC" */
+#define RECORD_VERSION 1
+
+#define RECORD_ALIGN 8
+#define RECORD_TYPE_COUNT 32	/* EV_CNT */
+#define RECORD_CODE_BYTES 96	/* KEY_CNT / 8, the largest code range */
+#define RECORD_ABS_COUNT 64	/* ABS_CNT */
+#define RECORD_PROP_BYTES 8	/* INPUT_PROP_CNT / 8, rounded up */
+
+enum record_chunk_type {
+	RECORD_CHUNK_DEVICE = 1,
+	RECORD_CHUNK_EVENTS = 2,
+};
+
+struct record_file_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t header_size;	/* sizeof(struct record_file_header) */
+	uint32_t clock_id;	/* clock of the event timestamps */
+};
+
+struct record_chunk {
+	uint32_t type;		/* enum record_chunk_type */
+	uint32_t length;	/* payload length, excluding padding */
+};
+
+struct record_absinfo {
+	int32_t value;
+	int32_t minimum;
+	int32_t maximum;
+	int32_t fuzz;
+	int32_t flat;
+	int32_t resolution;
+};
+
+/* The payload of RECORD_CHUNK_DEVICE. The struct is followed by the
+ * NUL-terminated device name and nproperties NUL-terminated
+ * KEY=value udev properties */
+struct record_device {
+	uint32_t id;
+	uint32_t types;		/* bitmask of the supported EV_* types */
+	uint16_t bustype;
+	uint16_t vendor;
+	uint16_t product;
+	uint16_t version;
+	uint32_t nproperties;
+	uint32_t reserved;
+	uint8_t props[RECORD_PROP_BYTES];
+	uint8_t codes[RECORD_TYPE_COUNT][RECORD_CODE_BYTES];
+	struct record_absinfo absinfo[RECORD_ABS_COUNT];
+};
+
+/* The payload of RECORD_CHUNK_EVENTS, followed by nevents
+ * struct record_event */
+struct record_events {
+	uint32_t device;	/* struct record_device.id */
+	uint32_t nevents;
+};
+
+struct record_event {
+	uint64_t time;		/* in µs */
+	uint16_t type;
+	uint16_t code;
+	int32_t value;
+};
+
+#endif
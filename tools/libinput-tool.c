@@ -65,6 +65,9 @@ usage(void)
 	       "\n"
 	       "  measure\n"
 	       "	Measure various device properties. See the --help output for more info\n"
+	       "\n"
+	       "  record\n"
+	       "	Record the kernel events of one or more devices to a file\n"
 	       "\n");
 }
 
@@ -58,12 +58,15 @@ enum options {
 	OPT_MIDDLEBUTTON_DISABLE,
 	OPT_DWT_ENABLE,
 	OPT_DWT_DISABLE,
+	OPT_RAW_ENABLE,
+	OPT_RAW_DISABLE,
 	OPT_CLICK_METHOD,
 	OPT_SCROLL_METHOD,
 	OPT_SCROLL_BUTTON,
 	OPT_SPEED,
 	OPT_PROFILE,
 	OPT_SHOW_KEYCODES,
+	OPT_FORMAT,
 	OPT_QUIET,
 };
 
@@ -116,6 +119,8 @@ tools_usage(const char *command)
 	       "--disable-middlebutton.... enable/disable middle button emulation\n"
 	       "--enable-dwt\n"
 	       "--disable-dwt..... enable/disable disable-while-typing\n"
+	       "--enable-raw\n"
+	       "--disable-raw..... enable/disable raw evdev frame passthrough\n"
 	       "--set-click-method=[none|clickfinger|buttonareas] .... set the desired click method\n"
 	       "--set-scroll-method=[none|twofinger|edge|button] ... set the desired scroll method\n"
 	       "--set-scroll-button=BTN_MIDDLE ... set the button to the given button code\n"
@@ -123,6 +128,7 @@ tools_usage(const char *command)
 	       "--set-speed=<value>.... set pointer acceleration speed (allowed range [-1, 1]) \n"
 	       "--set-tap-map=[lrm|lmr] ... set button mapping for tapping\n"
 	       "--show-keycodes.... show all key codes while typing\n"
+	       "--format=[text|jsonl|binary] .... set the output format\n"
 	       "\n"
 	       "These options apply to all applicable devices, if a feature\n"
 	       "is not explicitly specified it is left at each device's default.\n"
@@ -150,6 +156,7 @@ tools_init_context(struct tools_context *context)
 	options->left_handed = -1;
 	options->middlebutton = -1;
 	options->dwt = -1;
+	options->raw = -1;
 	options->click_method = -1;
 	options->scroll_method = -1;
 	options->scroll_button = -1;
@@ -158,6 +165,7 @@ tools_init_context(struct tools_context *context)
 	options->speed = 0.0;
 	options->profile = LIBINPUT_CONFIG_ACCEL_PROFILE_NONE;
 	options->show_keycodes = false;
+	options->format = TOOLS_FORMAT_TEXT;
 }
 
 int
@@ -192,6 +200,8 @@ tools_parse_args(const char *command,
 			{ "disable-middlebutton",      no_argument,       0, OPT_MIDDLEBUTTON_DISABLE },
 			{ "enable-dwt",                no_argument,       0, OPT_DWT_ENABLE },
 			{ "disable-dwt",               no_argument,       0, OPT_DWT_DISABLE },
+			{ "enable-raw",                no_argument,       0, OPT_RAW_ENABLE },
+			{ "disable-raw",               no_argument,       0, OPT_RAW_DISABLE },
 			{ "set-click-method",          required_argument, 0, OPT_CLICK_METHOD },
 			{ "set-scroll-method",         required_argument, 0, OPT_SCROLL_METHOD },
 			{ "set-scroll-button",         required_argument, 0, OPT_SCROLL_BUTTON },
@@ -199,6 +209,7 @@ tools_parse_args(const char *command,
 			{ "set-tap-map",               required_argument, 0, OPT_TAP_MAP },
 			{ "set-speed",                 required_argument, 0, OPT_SPEED },
 			{ "show-keycodes",             no_argument,       0, OPT_SHOW_KEYCODES },
+			{ "format",                    required_argument, 0, OPT_FORMAT },
 			{ 0, 0, 0, 0}
 		};
 
@@ -286,6 +297,12 @@ tools_parse_args(const char *command,
 		case OPT_DWT_DISABLE:
 			options->dwt = LIBINPUT_CONFIG_DWT_DISABLED;
 			break;
+		case OPT_RAW_ENABLE:
+			options->raw = LIBINPUT_CONFIG_RAW_ENABLED;
+			break;
+		case OPT_RAW_DISABLE:
+			options->raw = LIBINPUT_CONFIG_RAW_DISABLED;
+			break;
 		case OPT_CLICK_METHOD:
 			if (!optarg) {
 				tools_usage(command);
@@ -366,6 +383,18 @@ tools_parse_args(const char *command,
 		case OPT_SHOW_KEYCODES:
 			options->show_keycodes = true;
 			break;
+		case OPT_FORMAT:
+			if (streq(optarg, "text")) {
+				options->format = TOOLS_FORMAT_TEXT;
+			} else if (streq(optarg, "jsonl")) {
+				options->format = TOOLS_FORMAT_JSONL;
+			} else if (streq(optarg, "binary")) {
+				options->format = TOOLS_FORMAT_BINARY;
+			} else {
+				tools_usage(command);
+				return 1;
+			}
+			break;
 		case OPT_QUIET:
 			options->quiet = true;
 			break;
@@ -529,6 +558,9 @@ tools_device_apply_config(struct libinput_device *device,
 	if (options->dwt != -1)
 		libinput_device_config_dwt_set_enabled(device, options->dwt);
 
+	if (options->raw != -1)
+		libinput_device_config_raw_set_enabled(device, options->raw);
+
 	if (options->click_method != (enum libinput_config_click_method)-1)
 		libinput_device_config_click_set_method(device, options->click_method);
 
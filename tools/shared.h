@@ -33,6 +33,12 @@ enum tools_backend {
 	BACKEND_UDEV
 };
 
+enum tools_format {
+	TOOLS_FORMAT_TEXT,
+	TOOLS_FORMAT_JSONL,
+	TOOLS_FORMAT_BINARY,
+};
+
 struct tools_options {
 	bool verbose;
 	bool quiet;
@@ -41,6 +47,7 @@ struct tools_options {
 	const char *seat; /* if backend is BACKEND_UDEV */
 	int grab; /* EVIOCGRAB */
 	bool show_keycodes; /* show keycodes */
+	enum tools_format format; /* output format of debug-events */
 
 	int tapping;
 	int drag;
@@ -54,6 +61,7 @@ struct tools_options {
 	int scroll_button;
 	double speed;
 	int dwt;
+	int raw;
 	enum libinput_config_accel_profile profile;
 };
 
@@ -0,0 +1,473 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Measures what a tablet tool event actually costs. Creates a uinput
+ * tablet, replays a stroke for a few typical tools (hover in, contact,
+ * hover out) through a path context and reports, per
+ * libinput_event_tablet_tool:
+ * - the size of the allocation libinput made for the event, as reported
+ *   by malloc_usable_size(), i.e. the event struct plus its packed axes
+ * - the time spent in libinput_dispatch() and in fetching and destroying
+ *   the events, i.e. the event creation path
+ * The baseline is the whole event as it was before the axes were packed,
+ * allocated and measured the same way.
+ *
+ * Needs write access to /dev/uinput and a running udev.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <linux/input.h>
+#include <malloc.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+#include <libevdev/libevdev-uinput.h>
+#include <libudev.h>
+#include <libinput.h>
+
+#include "libinput-private.h"
+
+enum bench_tool {
+	BENCH_PEN,		/* pressure, distance */
+	BENCH_TILT_PEN,		/* pressure, distance, tilt */
+	BENCH_AIRBRUSH,		/* pressure, distance, tilt, slider */
+	BENCH_MOUSE,		/* distance, rotation, wheel */
+};
+
+/* struct libinput_event_tablet_tool before the axes were packed, with
+ * the full struct tablet_axes embedded. Keep in sync with the old
+ * definition in libinput.c, not with the current one */
+struct bench_old_tablet_tool_event {
+	struct libinput_event base;
+	uint32_t button;
+	enum libinput_button_state state;
+	uint32_t seat_button_count;
+	uint64_t time;
+	struct tablet_axes axes;
+	unsigned char changed_axes[NCHARS(LIBINPUT_TABLET_TOOL_AXIS_MAX + 1)];
+	struct libinput_tablet_tool *tool;
+	enum libinput_tablet_tool_proximity_state proximity_state;
+	enum libinput_tablet_tool_tip_state tip_state;
+};
+
+struct bench_result {
+	unsigned int nevents;
+	size_t bytes;
+	uint64_t nsec;
+};
+
+static const char *
+bench_tool_name(enum bench_tool tool)
+{
+	switch (tool) {
+	case BENCH_PEN:		return "pen";
+	case BENCH_TILT_PEN:	return "tilt pen";
+	case BENCH_AIRBRUSH:	return "airbrush";
+	case BENCH_MOUSE:	return "mouse";
+	}
+
+	return "unknown";
+}
+
+static unsigned int
+bench_tool_code(enum bench_tool tool)
+{
+	switch (tool) {
+	case BENCH_PEN:
+	case BENCH_TILT_PEN:	return BTN_TOOL_PEN;
+	case BENCH_AIRBRUSH:	return BTN_TOOL_AIRBRUSH;
+	case BENCH_MOUSE:	return BTN_TOOL_MOUSE;
+	}
+
+	abort();
+}
+
+static struct libevdev_uinput *
+bench_create_tablet(void)
+{
+	struct libevdev *dev;
+	struct libevdev_uinput *uidev = NULL;
+	struct input_absinfo abs[] = {
+		{ .value = ABS_X, .maximum = 44704, .resolution = 200 },
+		{ .value = ABS_Y, .maximum = 27940, .resolution = 200 },
+		{ .value = ABS_Z, .minimum = -900, .maximum = 899 },
+		{ .value = ABS_WHEEL, .maximum = 1023 },
+		{ .value = ABS_PRESSURE, .maximum = 2047 },
+		{ .value = ABS_DISTANCE, .maximum = 63 },
+		{ .value = ABS_TILT_X, .minimum = -64, .maximum = 63,
+		  .resolution = 57 },
+		{ .value = ABS_TILT_Y, .minimum = -64, .maximum = 63,
+		  .resolution = 57 },
+	};
+	unsigned int keys[] = {
+		BTN_TOOL_PEN, BTN_TOOL_AIRBRUSH, BTN_TOOL_MOUSE,
+		BTN_TOUCH, BTN_STYLUS, BTN_LEFT, BTN_RIGHT, BTN_MIDDLE,
+	};
+	size_t i;
+	int rc;
+
+	dev = libevdev_new();
+	libevdev_set_name(dev, "tablet-event-bench tablet");
+	libevdev_set_id_bustype(dev, BUS_USB);
+	libevdev_set_id_vendor(dev, 0x1);
+	libevdev_set_id_product(dev, 0x1);
+
+	for (i = 0; i < ARRAY_LENGTH(abs); i++) {
+		struct input_absinfo a = abs[i];
+
+		a.value = 0;
+		libevdev_enable_event_code(dev, EV_ABS, abs[i].value, &a);
+	}
+	for (i = 0; i < ARRAY_LENGTH(keys); i++)
+		libevdev_enable_event_code(dev, EV_KEY, keys[i], NULL);
+	libevdev_enable_event_code(dev, EV_REL, REL_WHEEL, NULL);
+
+	rc = libevdev_uinput_create_from_device(dev,
+						LIBEVDEV_UINPUT_OPEN_MANAGED,
+						&uidev);
+	libevdev_free(dev);
+	if (rc != 0) {
+		fprintf(stderr,
+			"Failed to create uinput device (%s)\n",
+			strerror(-rc));
+		return NULL;
+	}
+
+	return uidev;
+}
+
+/* The path backend reads the udev properties once, wait for udev to
+ * tag the device as tablet before adding it */
+static bool
+bench_wait_for_udev(const char *devnode)
+{
+	struct udev *udev;
+	struct stat st;
+	bool initialized = false;
+	int i;
+
+	if (stat(devnode, &st) != 0)
+		return false;
+
+	udev = udev_new();
+	if (!udev)
+		return false;
+
+	for (i = 0; i < 200 && !initialized; i++) {
+		struct udev_device *device;
+
+		device = udev_device_new_from_devnum(udev, 'c', st.st_rdev);
+		if (device) {
+			initialized = udev_device_get_is_initialized(device) &&
+				udev_device_get_property_value(device,
+							       "ID_INPUT_TABLET");
+			udev_device_unref(device);
+		}
+		if (!initialized)
+			usleep(10000);
+	}
+
+	udev_unref(udev);
+
+	return initialized;
+}
+
+static int
+bench_open_restricted(const char *path, int flags, void *user_data)
+{
+	int fd = open(path, flags);
+
+	return fd < 0 ? -errno : fd;
+}
+
+static void
+bench_close_restricted(int fd, void *user_data)
+{
+	close(fd);
+}
+
+static const struct libinput_interface interface = {
+	.open_restricted = bench_open_restricted,
+	.close_restricted = bench_close_restricted,
+};
+
+static inline uint64_t
+bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static size_t
+bench_old_event_size(void)
+{
+	struct bench_old_tablet_tool_event *event;
+	size_t size;
+
+	event = zalloc(sizeof *event);
+	size = malloc_usable_size(event);
+	free(event);
+
+	return size;
+}
+
+static void
+bench_drain(struct libinput *li, struct bench_result *result)
+{
+	struct libinput_event *event;
+	uint64_t start;
+
+	start = bench_now();
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		switch (libinput_event_get_type(event)) {
+		case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+		case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+		case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+		case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+			/* the tablet tool event is the allocation, the
+			 * base event is its first member */
+			result->bytes += malloc_usable_size(event);
+			result->nevents++;
+			break;
+		default:
+			break;
+		}
+		libinput_event_destroy(event);
+	}
+
+	result->nsec += bench_now() - start;
+}
+
+static void
+bench_write(struct libevdev_uinput *uidev,
+	    unsigned int type,
+	    unsigned int code,
+	    int value)
+{
+	libevdev_uinput_write_event(uidev, type, code, value);
+}
+
+static void
+bench_stroke(struct libinput *li,
+	     struct libevdev_uinput *uidev,
+	     enum bench_tool tool,
+	     int nevents,
+	     struct bench_result *result)
+{
+	unsigned int code = bench_tool_code(tool);
+	bool in_contact = false;
+	int i;
+
+	for (i = 0; i < nevents; i++) {
+		/* first and last quarter of the stroke hover, middle is in
+		 * contact */
+		bool contact = i > nevents/4 && i < nevents * 3/4;
+		double t = (double)i/nevents;
+
+		if (i == 0)
+			bench_write(uidev, EV_KEY, code, 1);
+
+		bench_write(uidev, EV_ABS, ABS_X, 1000 + (i * 7) % 40000);
+		bench_write(uidev, EV_ABS, ABS_Y, 2000 + (i * 3) % 25000);
+
+		if (tool != BENCH_MOUSE && contact != in_contact) {
+			bench_write(uidev, EV_KEY, BTN_TOUCH, contact);
+			in_contact = contact;
+		}
+
+		if (tool != BENCH_MOUSE && contact) {
+			bench_write(uidev, EV_ABS, ABS_DISTANCE, 0);
+			bench_write(uidev, EV_ABS, ABS_PRESSURE,
+				    100 + sin(t * M_PI) * 1900);
+		} else {
+			bench_write(uidev, EV_ABS, ABS_PRESSURE, 0);
+			bench_write(uidev, EV_ABS, ABS_DISTANCE,
+				    1 + fabs(0.5 - t) * 60);
+		}
+
+		switch (tool) {
+		case BENCH_PEN:
+			break;
+		case BENCH_AIRBRUSH:
+			bench_write(uidev, EV_ABS, ABS_WHEEL, 512);
+			/* fallthrough */
+		case BENCH_TILT_PEN:
+			bench_write(uidev, EV_ABS, ABS_TILT_X, 30 - t * 20);
+			bench_write(uidev, EV_ABS, ABS_TILT_Y, -10 + t * 5);
+			break;
+		case BENCH_MOUSE:
+			bench_write(uidev, EV_ABS, ABS_Z, -900 + t * 1799);
+			if (i % 16 == 0)
+				bench_write(uidev, EV_REL, REL_WHEEL, 1);
+			break;
+		}
+
+		bench_write(uidev, EV_SYN, SYN_REPORT, 0);
+
+		/* drain every frame so the kernel buffer never overflows */
+		bench_drain(li, result);
+	}
+
+	if (in_contact)
+		bench_write(uidev, EV_KEY, BTN_TOUCH, 0);
+	bench_write(uidev, EV_ABS, ABS_PRESSURE, 0);
+	bench_write(uidev, EV_ABS, ABS_DISTANCE, 0);
+	bench_write(uidev, EV_ABS, ABS_TILT_X, 0);
+	bench_write(uidev, EV_ABS, ABS_TILT_Y, 0);
+	bench_write(uidev, EV_ABS, ABS_WHEEL, 0);
+	bench_write(uidev, EV_ABS, ABS_Z, 0);
+	bench_write(uidev, EV_KEY, code, 0);
+	bench_write(uidev, EV_SYN, SYN_REPORT, 0);
+	bench_drain(li, result);
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [options]\n"
+	       "\n"
+	       "--nevents=<int>\n"
+	       "	... number of events per stroke (default: 2000)\n",
+	       program_invocation_short_name);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct libevdev_uinput *uidev;
+	struct libinput *li;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	const char *devnode;
+	size_t old_bytes;
+	enum bench_tool tool;
+	int nevents = 2000;
+	int rc = 1;
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option long_options[] = {
+			{"nevents", 1, 0, 'n' },
+			{"help", 0, 0, 'h' },
+			{0, 0, 0, 0}
+		};
+
+		c = getopt_long(argc, argv, "n:h",
+				long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'n':
+			nevents = atoi(optarg);
+			if (nevents <= 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case 'h':
+			usage();
+			return 0;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	uidev = bench_create_tablet();
+	if (!uidev)
+		return 1;
+
+	devnode = libevdev_uinput_get_devnode(uidev);
+	if (!bench_wait_for_udev(devnode)) {
+		fprintf(stderr, "%s was not tagged as tablet by udev\n",
+			devnode);
+		goto out;
+	}
+
+	li = libinput_path_create_context(&interface, NULL);
+	if (!li)
+		goto out;
+
+	device = libinput_path_add_device(li, devnode);
+	if (!device ||
+	    !libinput_device_has_capability(device,
+					    LIBINPUT_DEVICE_CAP_TABLET_TOOL)) {
+		fprintf(stderr, "Failed to add %s as tablet\n", devnode);
+		libinput_unref(li);
+		goto out;
+	}
+
+	/* discard DEVICE_ADDED */
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li)))
+		libinput_event_destroy(event);
+
+	old_bytes = bench_old_event_size();
+	printf("# old layout: %zu bytes per event (%zu of them axes)\n",
+	       old_bytes,
+	       sizeof(struct tablet_axes));
+	printf("# tool		events	bytes/event	saved	ns/event\n");
+
+	for (tool = BENCH_PEN; tool <= BENCH_MOUSE; tool++) {
+		struct bench_result result = {0};
+
+		bench_stroke(li, uidev, tool, nevents, &result);
+		if (result.nevents == 0) {
+			printf("%-12s	0\n", bench_tool_name(tool));
+			continue;
+		}
+
+		printf("%-12s	%u	%.1f		%.1f	%.0f\n",
+		       bench_tool_name(tool),
+		       result.nevents,
+		       (double)result.bytes/result.nevents,
+		       old_bytes - (double)result.bytes/result.nevents,
+		       (double)result.nsec/result.nevents);
+	}
+
+	libinput_unref(li);
+	rc = 0;
+out:
+	libevdev_uinput_destroy(uidev);
+
+	return rc;
+}
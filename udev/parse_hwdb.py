@@ -34,6 +34,7 @@ import glob
 import string
 import sys
 import os
+import re
 
 try:
     from pyparsing import (Word, White, Literal, ParserElement, Regex,
@@ -42,9 +43,9 @@ try:
                            nums, alphanums, printables,
                            stringEnd, pythonStyleComment,
                            ParseBaseException)
+    HAVE_PYPARSING = True
 except ImportError:
-    print('pyparsing is not available')
-    sys.exit(77)
+    HAVE_PYPARSING = False
 
 try:
     from evdev.ecodes import ecodes
@@ -52,12 +53,13 @@ except ImportError:
     ecodes = None
     print('WARNING: evdev is not available')
 
-EOL = LineEnd().suppress()
-EMPTYLINE = LineEnd()
-COMMENTLINE = pythonStyleComment + EOL
-INTEGER = Word(nums)
-REAL = Combine((INTEGER + Optional('.' + Optional(INTEGER))) ^ ('.' + INTEGER))
-UDEV_TAG = Word(string.ascii_uppercase, alphanums + '_')
+if HAVE_PYPARSING:
+    EOL = LineEnd().suppress()
+    EMPTYLINE = LineEnd()
+    COMMENTLINE = pythonStyleComment + EOL
+    INTEGER = Word(nums)
+    REAL = Combine((INTEGER + Optional('.' + Optional(INTEGER))) ^ ('.' + INTEGER))
+    UDEV_TAG = Word(string.ascii_uppercase, alphanums + '_')
 
 TYPES = {
          'libinput': ('name', 'touchpad', 'mouse', 'keyboard'),
@@ -188,7 +190,119 @@ def print_summary(fname, groups):
                   sum(len(props) for matches, props in groups),
           ))
 
+# The C table generator only needs the match and property lines, so it
+# uses a plain line reader and works without pyparsing. Run the regular
+# checks to validate the hwdb file itself.
+def read_groups(fname):
+    groups = []
+    matches, props = [], []
+    with open(fname, encoding='utf-8') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if line.startswith('#'):
+                continue
+            if line.startswith(' '):
+                prop = line.partition('#')[0].strip()
+                if prop:
+                    props.append(prop)
+                continue
+            if line.startswith('libinput:'):
+                if props:
+                    groups.append((matches, props))
+                    matches, props = [], []
+                matches.append(line)
+                continue
+            if matches and props:
+                groups.append((matches, props))
+            matches, props = [], []
+    if matches and props:
+        groups.append((matches, props))
+    return groups
+
+ID_MATCH = re.compile(r'libinput:(touchpad|mouse|keyboard):input:'
+                      r'b([0-9A-F]{4})v([0-9A-F]{4})p(?:([0-9A-F]{4}))?\*$')
+ID_TYPES = { 'touchpad': 1, 'mouse': 2, 'keyboard': 3 }
+HASH_MULTIPLIER = 0x9E3779B97F4A7C15
+MASK64 = (1 << 64) - 1
+
+def model_quirk_key(match):
+    m = ID_MATCH.match(match)
+    if not m:
+        return None
+    type, bus, vid, pid = m.groups()
+    key = ID_TYPES[type] << 49 | int(bus, 16) << 32 | int(vid, 16) << 16
+    if pid is None:
+        key |= 1 << 48
+    else:
+        key |= int(pid, 16)
+    return key
+
+def model_quirk_slot(key, seed, bits):
+    return (((key ^ seed) * HASH_MULTIPLIER) & MASK64) >> (64 - bits)
+
+def find_perfect_hash(keys):
+    bits = max(1, (2 * len(keys) - 1).bit_length())
+    while True:
+        for seed in range(1 << 16):
+            slots = set(model_quirk_slot(k, seed, bits) for k in keys)
+            if len(slots) == len(keys):
+                return seed, bits
+        bits += 1
+
+def c_string(s):
+    return '"' + s.replace('\\', '\\\\').replace('"', '\\"') + '"'
+
+def generate_c(fname, output):
+    ids = {}
+    globs = []
+    for matches, props in read_groups(fname):
+        flags = [p.partition('=')[0].replace('LIBINPUT_MODEL_', 'EVDEV_MODEL_')
+                 for p in props
+                 if p.startswith('LIBINPUT_MODEL_') and p.endswith('=1')]
+        if not flags:
+            continue
+        for match in matches:
+            if ':fwversion:' in match:
+                print('WARNING: {} needs the firmware version, '
+                      'left to udev'.format(match))
+                continue
+            key = model_quirk_key(match)
+            if key is None:
+                globs.append((match, flags))
+            else:
+                ids.setdefault(key, set()).update(flags)
+
+    keys = sorted(ids)
+    seed, bits = find_perfect_hash(keys)
+    slots = { model_quirk_slot(k, seed, bits): k for k in keys }
+
+    with open(output, 'w', encoding='utf-8') as f:
+        f.write('/* Generated by parse_hwdb.py from {}, do not edit */\n\n'
+                .format(os.path.basename(fname)))
+        f.write('#define MODEL_QUIRK_ID_SEED 0x{:x}ULL\n'.format(seed))
+        f.write('#define MODEL_QUIRK_ID_BITS {}\n\n'.format(bits))
+        f.write('static const struct model_quirk_id model_quirk_ids[1 << MODEL_QUIRK_ID_BITS] = {\n')
+        for slot in sorted(slots):
+            key = slots[slot]
+            f.write('\t[{}] = {{ 0x{:x}ULL, {} }},\n'
+                    .format(slot, key, ' | '.join(sorted(ids[key]))))
+        f.write('};\n\n')
+        f.write('static const struct model_quirk_glob model_quirk_globs[] = {\n')
+        for match, flags in globs:
+            f.write('\t{{ {}, {} }},\n'
+                    .format(c_string(match), ' | '.join(flags)))
+        f.write('\t{ NULL, 0 },\n')
+        f.write('};\n')
+
 if __name__ == '__main__':
+    if len(sys.argv) == 4 and sys.argv[1] == '--generate-c':
+        generate_c(sys.argv[2], sys.argv[3])
+        sys.exit(0)
+
+    if not HAVE_PYPARSING:
+        print('pyparsing is not available')
+        sys.exit(77)
+
     args = sys.argv[1:] or glob.glob(os.path.dirname(sys.argv[0]) + '/*.hwdb')
 
     for fname in args: